@@ -3,9 +3,13 @@
 // Entry Point, Game Loop, and Core Game Management
 // ============================================================================
 
+#include "assets.h"
 #include "camera.h"
+#include "hud.h"
 #include "level.h"
 #include "player.h"
+#include "primitives.h"
+#include "quality.h"
 
 #ifdef __APPLE__
 #include <GLUT/glut.h>
@@ -13,8 +17,11 @@
 #include <GL/glut.h>
 #endif
 
+#include <chrono>
 #include <csignal> // Added for signal handling
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
 
 // ============================================================================
@@ -22,6 +29,8 @@
 // ============================================================================
 const int WINDOW_WIDTH = 1280;
 const int WINDOW_HEIGHT = 720;
+int windowWidth = WINDOW_WIDTH; // Actual size, from reshape()
+int windowHeight = WINDOW_HEIGHT;
 
 // Game state
 enum GameState { MENU, LEVEL1, LEVEL2, PAUSED, WIN, GAME_OVER };
@@ -42,6 +51,51 @@ int lastMouseY = WINDOW_HEIGHT / 2;
 int lastFrameTime = 0;
 float deltaTime = 0.0f;
 
+// Startup metrics: meshes stream in behind the first frames, so report the
+// time to the first frame and to every mesh being resident
+std::chrono::steady_clock::time_point loadStart;
+int startupCacheHits = 0;
+int startupCacheMisses = 0;
+bool firstFramePending = false;
+bool fullyLoadedPending = false;
+
+// Level 2 assets are decoded in the background once the desert portal opens;
+// once they are uploaded, level 2 itself is prepared (its static bake runs
+// on the thread pool) so the switch only has to pick it up
+AssetBatch *levelPrefetch = nullptr;
+bool levelPrefetchStarted = false;
+Level *preparedLevel = nullptr;
+
+// Level transition timing: from the update that switches levels to the first
+// level 2 frame on screen
+bool transitionFramePending = false;
+std::chrono::steady_clock::time_point transitionStart;
+
+// Texture binds of the first frame of each level are reported once
+bool bindReportPending = false;
+
+// [O] overlays the occlusion buffer in the bottom right corner
+bool showOcclusionBuffer = false;
+
+// HUD widgets, drawn in this order from cached vertices
+enum HudWidgetId {
+  HUD_LEVEL_PANEL,
+  HUD_LEVEL_INFO,
+  HUD_TIMER,
+  HUD_HEART,
+  HUD_HEALTH,
+  HUD_START_MESSAGE,
+  HUD_CAMERA_MODE,
+  HUD_OCCLUSION_STATS,
+  HUD_DAMAGE_FLASH,
+  HUD_EXIT_FADE
+};
+HudLayer hud;
+
+// Render scale, snow, tessellation and LOD follow the measured frame time
+QualityGovernor governor;
+ScaledRenderTarget sceneTarget;
+
 // Menu selection
 int menuSelection = 0;
 
@@ -103,6 +157,12 @@ void startGame() {
   // Initialize camera
   camera = new Camera();
 
+  // Startup timing (cold = mesh caches rebuilt, warm = all cache hits)
+  loadStart = std::chrono::steady_clock::now();
+  startupCacheHits = Model::cacheHits;
+  startupCacheMisses = Model::cacheMisses;
+  int sharedBefore = AssetRegistry::hits();
+
   // Initialize player at starting position
   // Spawn at the far side (z=70), facing the portal (z=-80)
   player = new Player(0.0f, 1.0f, 70.0f);
@@ -113,17 +173,92 @@ void startGame() {
   currentLevel = new DesertLevel();
   currentLevel->init(player);
 
+  double loadMs = std::chrono::duration<double, std::milli>(
+                      std::chrono::steady_clock::now() - loadStart)
+                      .count();
+  printf("Startup: level ready in %.1f ms (%d meshes still streaming)\n",
+         loadMs, Model::getStreamingCount());
+  firstFramePending = true;
+  fullyLoadedPending = true;
+  bindReportPending = true;
+  printf("Startup: %d assets reused from the registry\n",
+         AssetRegistry::hits() - sharedBefore);
+
   currentState = LEVEL1;
 
   // Set start time AFTER everything is loaded
   gameStartTime = glutGet(GLUT_ELAPSED_TIME);
 }
 
+void cancelLevelPrefetch() {
+  delete levelPrefetch; // Waits for in-flight decodes
+  levelPrefetch = nullptr;
+  levelPrefetchStarted = false;
+  delete preparedLevel; // Waits for its bake
+  preparedLevel = nullptr;
+}
+
+// Spawns and asset lookups of level 2 now, its bake on the thread pool
+Level *prepareIceLevel() {
+  auto setupStart = std::chrono::steady_clock::now();
+  int hitsBefore = AssetRegistry::hits();
+  int missesBefore = AssetRegistry::misses();
+  Level *level = new IceLevel();
+  level->prepare();
+  printf("Level 2 prepared: setup %.1f ms, assets %d shared / %d newly "
+         "loaded\n",
+         std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - setupStart)
+             .count(),
+         AssetRegistry::hits() - hitsBefore,
+         AssetRegistry::misses() - missesBefore);
+  return level;
+}
+
+void updateLevelPrefetch() {
+  if (!levelPrefetchStarted && currentLevel->isPortalActive()) {
+    levelPrefetch = new AssetBatch();
+    IceLevel::queueAssets(*levelPrefetch);
+    levelPrefetch->start();
+    levelPrefetchStarted = true;
+    printf("Prefetching level 2: %zu assets\n", levelPrefetch->size());
+  } else if (levelPrefetch && levelPrefetch->isDecoded()) {
+    // GL upload on the GLUT thread, still ahead of the switch
+    levelPrefetch->finish();
+    delete levelPrefetch;
+    levelPrefetch = nullptr;
+    preparedLevel = prepareIceLevel();
+  }
+}
+
 void nextLevel() {
   if (currentState == LEVEL1) {
+    auto switchStart = std::chrono::steady_clock::now();
+    bool prefetched = levelPrefetchStarted && !levelPrefetch;
+    if (levelPrefetch) {
+      levelPrefetch->finish(); // Reached the portal before decoding finished
+      delete levelPrefetch;
+      levelPrefetch = nullptr;
+    }
+
+    // Level 2 should only load what level 1 did not already share
+    Level *next = preparedLevel ? preparedLevel : prepareIceLevel();
+    preparedLevel = nullptr;
+    bool bakeReady = next->isPrepared();
     delete currentLevel;
-    currentLevel = new IceLevel();
+    currentLevel = next;
     currentLevel->init(player);
+    printf("Level switch: %.1f ms (%s; static bake %s, waited %.1f ms, "
+           "upload %.1f ms)\n",
+           std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - switchStart)
+               .count(),
+           prefetched ? "prefetched" : "prefetch incomplete",
+           bakeReady ? "ready" : "pending", currentLevel->getBakeWaitMs(),
+           currentLevel->getUploadMs());
+    AssetRegistry::printReport();
+    bindReportPending = true;
+    governor.reset(); // The switch frame is not a level 2 frame
     player->resetPosition(0.0f, 1.0f, 0.0f);
     currentState = LEVEL2;
   } else if (currentState == LEVEL2) {
@@ -139,7 +274,7 @@ void cleanup() {
     delete player;
   if (currentLevel)
     delete currentLevel;
-  Level::cleanupCommonAssets();
+  cancelLevelPrefetch();
   // Nullify pointers to be safe
   camera = nullptr;
   player = nullptr;
@@ -157,6 +292,8 @@ void restartLevel() { fullReset(); }
 // UPDATE LOGIC
 // ============================================================================
 void update(int value) {
+  auto updateStart = std::chrono::steady_clock::now();
+
   // Calculate delta time
   int currentTime = glutGet(GLUT_ELAPSED_TIME);
   deltaTime = (currentTime - lastFrameTime) / 1000.0f;
@@ -189,6 +326,8 @@ void update(int value) {
 
     // Update level
     currentLevel->update(deltaTime);
+    if (currentState == LEVEL1)
+      updateLevelPrefetch();
 
     // Update camera
     bool isMoving = (forward != 0.0f || strafe != 0.0f);
@@ -197,6 +336,8 @@ void update(int value) {
 
     // Check win condition
     if (currentLevel->isComplete()) {
+      transitionStart = updateStart;
+      transitionFramePending = currentState == LEVEL1;
       nextLevel();
     }
 
@@ -281,132 +422,112 @@ void renderHUD() {
   glDisable(GL_DEPTH_TEST);
 
   char buffer[64];
+  HudWidget *w;
+  hud.begin();
 
   // --- Top Left: Level Info ---
-  // Background
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-  glColor4f(0.0f, 0.0f, 0.0f, 0.5f);
-  glBegin(GL_QUADS);
-  glVertex2f(10, WINDOW_HEIGHT - 10);
-  glVertex2f(250, WINDOW_HEIGHT - 10);
-  glVertex2f(250, WINDOW_HEIGHT - 100); // Extended to match border
-  glVertex2f(10, WINDOW_HEIGHT - 100);
-  glEnd();
-  glDisable(GL_BLEND);
-
-  // Border
-  glColor3f(0.8f, 0.8f, 0.8f);
-  glLineWidth(2.0f);
-  glBegin(GL_LINE_LOOP);
-  glVertex2f(10, WINDOW_HEIGHT - 10);
-  glVertex2f(250, WINDOW_HEIGHT - 10);
-  glVertex2f(250, WINDOW_HEIGHT - 100); // Expanded to fit timer
-  glVertex2f(10, WINDOW_HEIGHT - 100);
-  glEnd();
-
-  // Text
-  glColor3f(1.0f, 1.0f, 1.0f);
+  if ((w = hud.widget(HUD_LEVEL_PANEL, 0))) {
+    w->color(0.0f, 0.0f, 0.0f, 0.5f);
+    w->rect(10, WINDOW_HEIGHT - 100, 250, WINDOW_HEIGHT - 10); // Fits timer
+    w->color(0.8f, 0.8f, 0.8f);
+    w->outline(10, WINDOW_HEIGHT - 100, 250, WINDOW_HEIGHT - 10, 2.0f);
+  }
+
+  // Text, rebuilt when the orbs or the whole seconds left change
   if (currentState == LEVEL1) {
     DesertLevel *desert = (DesertLevel *)currentLevel;
-    renderText(20, WINDOW_HEIGHT - 35, "Level 1: Desert Temple");
-    sprintf(buffer, "Orbs: %d / %d", player->getOrbsCollected(),
-            desert->getTotalOrbs());
-    glColor3f(1.0f, 0.84f, 0.0f); // Gold
-    renderText(20, WINDOW_HEIGHT - 60, buffer);
+    int orbs = player->getOrbsCollected(), total = desert->getTotalOrbs();
+    if ((w = hud.widget(HUD_LEVEL_INFO, LEVEL1 * 1000000LL + orbs * 1000 +
+                                            total))) {
+      w->color(1.0f, 1.0f, 1.0f);
+      w->text(20, WINDOW_HEIGHT - 35, "Level 1: Desert Temple");
+      sprintf(buffer, "Orbs: %d / %d", orbs, total);
+      w->color(1.0f, 0.84f, 0.0f); // Gold
+      w->text(20, WINDOW_HEIGHT - 60, buffer);
+    }
 
     // Timer (now inside the box)
-    float timeLeft = desert->getTimeRemaining();
-    sprintf(buffer, "Time: %.1f", timeLeft);
-    if (timeLeft < 10.0f)
-      glColor3f(1.0f, 0.2f, 0.2f); // Red
-    else if (timeLeft < 30.0f)
-      glColor3f(1.0f, 0.6f, 0.0f); // Orange
-    else
-      glColor3f(0.6f, 0.8f, 1.0f); // Light blue
-    renderText(20, WINDOW_HEIGHT - 85, buffer);
+    int secondsLeft = (int)ceilf(desert->getTimeRemaining());
+    if ((w = hud.widget(HUD_TIMER, LEVEL1 * 1000000LL + secondsLeft))) {
+      sprintf(buffer, "Time: %d", secondsLeft);
+      if (secondsLeft <= 10)
+        w->color(1.0f, 0.2f, 0.2f); // Red
+      else if (secondsLeft <= 30)
+        w->color(1.0f, 0.6f, 0.0f); // Orange
+      else
+        w->color(0.6f, 0.8f, 1.0f); // Light blue
+      w->text(20, WINDOW_HEIGHT - 85, buffer);
+    }
   } else if (currentState == LEVEL2) {
     IceLevel *ice = (IceLevel *)currentLevel;
-    renderText(20, WINDOW_HEIGHT - 35, "Level 2: Ice Cave");
-    float timeLeft = ice->getTimeRemaining();
-    sprintf(buffer, "Time: %.1f", timeLeft);
-
-    if (timeLeft < 10.0f)
-      glColor3f(1.0f, 0.2f, 0.2f);
-    else if (timeLeft < 20.0f)
-      glColor3f(1.0f, 0.6f, 0.0f);
-    else
-      glColor3f(0.6f, 0.8f, 1.0f);
+    if ((w = hud.widget(HUD_LEVEL_INFO, LEVEL2 * 1000000LL))) {
+      w->color(1.0f, 1.0f, 1.0f);
+      w->text(20, WINDOW_HEIGHT - 35, "Level 2: Ice Cave");
+    }
 
-    renderText(20, WINDOW_HEIGHT - 60, buffer);
+    int secondsLeft = (int)ceilf(ice->getTimeRemaining());
+    if ((w = hud.widget(HUD_TIMER, LEVEL2 * 1000000LL + secondsLeft))) {
+      sprintf(buffer, "Time: %d", secondsLeft);
+      if (secondsLeft <= 10)
+        w->color(1.0f, 0.2f, 0.2f);
+      else if (secondsLeft <= 20)
+        w->color(1.0f, 0.6f, 0.0f);
+      else
+        w->color(0.6f, 0.8f, 1.0f);
+      w->text(20, WINDOW_HEIGHT - 60, buffer);
+    }
   }
 
   // --- Bottom Left: Professional Health Bar ---
-  float healthPercent = (float)player->getHealth() / 100.0f;
-
-  // 1. Heart Icon
-  glPushMatrix();
-  glTranslatef(35, 35, 0);
-  glScalef(15, 15, 1);
-  glColor3f(1.0f, 0.2f, 0.2f); // Red Heart
-  glBegin(GL_TRIANGLE_FAN);
-  glVertex2f(0, 0);
-  for (int i = 0; i <= 100; i++) {
-    float angle = i * 2.0f * 3.14159f / 100.0f;
-    float r = (sin(angle) * sqrt(abs(cos(angle)))) / (sin(angle) + 1.4142f) -
-              2 * sin(angle) + 2;
-    glVertex2f(r * 0.5f, -r * 0.5f + 1.0f); // Adjust shape
+  // 1. Heart Icon, a fan around (35, 35) built once
+  if ((w = hud.widget(HUD_HEART, 0))) {
+    w->color(1.0f, 0.2f, 0.2f); // Red Heart
+    float lastX = 0.0f, lastY = 0.0f;
+    for (int i = 0; i <= 100; i++) {
+      float angle = i * 2.0f * 3.14159f / 100.0f;
+      float r = (sinf(angle) * sqrtf(fabsf(cosf(angle)))) /
+                    (sinf(angle) + 1.4142f) -
+                2 * sinf(angle) + 2;
+      float x = 35 + 15 * (r * 0.5f), y = 35 + 15 * (-r * 0.5f + 1.0f);
+      if (i > 0)
+        w->triangle(35, 35, lastX, lastY, x, y);
+      lastX = x;
+      lastY = y;
+    }
   }
-  glEnd();
-  glPopMatrix();
 
-  // 2. Bar Background (Sleek, Semi-transparent)
-  float barX = 60;
-  float barY = 25;
-  float barWidth = 200;
-  float barHeight = 20;
-
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-  glColor4f(0.0f, 0.0f, 0.0f, 0.6f);
-  glBegin(GL_QUADS);
-  glVertex2f(barX, barY);
-  glVertex2f(barX + barWidth, barY);
-  glVertex2f(barX + barWidth, barY + barHeight);
-  glVertex2f(barX, barY + barHeight);
-  glEnd();
-
-  // 3. Bar Fill (Gradient)
-  float fillWidth = barWidth * healthPercent;
-  glBegin(GL_QUADS);
-  // Left color (Green)
-  glColor4f(0.0f, 0.8f, 0.2f, 0.9f);
-  glVertex2f(barX, barY + 2);
-  glVertex2f(barX + fillWidth, barY + 2);
-  // Right color (Lighter Green or Red if low)
-  if (healthPercent > 0.5f)
-    glColor4f(0.4f, 1.0f, 0.4f, 0.9f);
-  else
-    glColor4f(1.0f, 0.2f, 0.2f, 0.9f);
-
-  glVertex2f(barX + fillWidth, barY + barHeight - 2);
-  glVertex2f(barX, barY + barHeight - 2);
-  glEnd();
-  glDisable(GL_BLEND);
+  // 2-4. Bar, fill and text, rebuilt when health changes
+  int health = player->getHealth();
+  if ((w = hud.widget(HUD_HEALTH, health))) {
+    float healthPercent = (float)health / 100.0f;
+    float barX = 60;
+    float barY = 25;
+    float barWidth = 200;
+    float barHeight = 20;
+
+    // Background (Sleek, Semi-transparent)
+    w->color(0.0f, 0.0f, 0.0f, 0.6f);
+    w->rect(barX, barY, barX + barWidth, barY + barHeight);
+
+    // Fill, green fading to lighter green (or red if low)
+    float fillWidth = barWidth * healthPercent;
+    w->color(0.0f, 0.8f, 0.2f, 0.9f);
+    if (healthPercent > 0.5f)
+      w->gradientRect(barX, barY + 2, barX + fillWidth, barY + barHeight - 2,
+                      0.4f, 1.0f, 0.4f, 0.9f);
+    else
+      w->gradientRect(barX, barY + 2, barX + fillWidth, barY + barHeight - 2,
+                      1.0f, 0.2f, 0.2f, 0.9f);
 
-  // 4. Health Text (Clean White)
-  sprintf(buffer, "HP %d%%", player->getHealth());
-  glColor3f(1.0f, 1.0f, 1.0f);
-  // Centered above bar
-  renderText(barX + 5, barY + barHeight + 5, buffer, GLUT_BITMAP_HELVETICA_12);
+    // Health Text (Clean White), above the bar
+    sprintf(buffer, "HP %d%%", health);
+    w->color(1.0f, 1.0f, 1.0f);
+    w->text(barX + 5, barY + barHeight + 5, buffer, GLUT_BITMAP_HELVETICA_12);
+  }
 
   // --- Start Message "LET'S GO!" (Enhanced) ---
   float timeSinceStart = (glutGet(GLUT_ELAPSED_TIME) - gameStartTime) / 1000.0f;
   if (timeSinceStart < 6.0f) {
-    glPushMatrix();
-    // Center of screen
-    glTranslatef(WINDOW_WIDTH / 2.0f, WINDOW_HEIGHT / 2.0f, 0);
-
     // Animation: Zoom in and bounce
     float scale = 0.0f;
     if (timeSinceStart < 0.5f)
@@ -416,52 +537,59 @@ void renderHUD() {
     else
       scale = 1.0f - (timeSinceStart - 3.0f) * 2.0f; // Zoom out
 
-    if (scale < 0)
-      scale = 0;
-
-    glScalef(scale * 0.5f, scale * 0.5f, 1.0f); // Scale down stroke font
-
-    // Centering text (approximate width of "LET'S GO!" is ~600 units in
-    // stroke font)
-    glTranslatef(-300, -50, 0);
-
-    glLineWidth(3.0f);
-    // Shadow/Outline
-    glColor3f(0.0f, 0.0f, 0.0f);
-    glPushMatrix();
-    glTranslatef(4, -4, 0);
-    for (const char *c = "LET'S GO!"; *c != '\0'; c++)
-      glutStrokeCharacter(GLUT_STROKE_ROMAN, *c);
-    glPopMatrix();
-
-    // Main Text (Gold)
-    glColor3f(1.0f, 0.8f, 0.0f);
-    for (const char *c = "LET'S GO!"; *c != '\0'; c++)
-      glutStrokeCharacter(GLUT_STROKE_ROMAN, *c);
-
-    glLineWidth(1.0f);
-    glPopMatrix();
+    // Rebuilt per thousandth of scale, so only while it animates
+    if (scale > 0 &&
+        (w = hud.widget(HUD_START_MESSAGE, (long long)(scale * 1000.0f)))) {
+      // Stroke font scaled down and centered on screen (the width of
+      // "LET'S GO!" is ~600 units in stroke font)
+      float s = scale * 0.5f;
+      float x = WINDOW_WIDTH / 2.0f - 300 * s;
+      float y = WINDOW_HEIGHT / 2.0f - 50 * s;
+
+      // Shadow/Outline
+      w->color(0.0f, 0.0f, 0.0f);
+      w->strokeText(x + 4 * s, y - 4 * s, s, "LET'S GO!");
+
+      // Main Text (Gold)
+      w->color(1.0f, 0.8f, 0.0f);
+      w->strokeText(x, y, s, "LET'S GO!");
+    }
   }
 
   // --- Top Right: Camera Mode ---
-  glColor3f(0.8f, 0.8f, 0.8f);
-  renderText(WINDOW_WIDTH - 220, WINDOW_HEIGHT - 30,
-             camera->getMode() == FIRST_PERSON ? "[C] First Person"
-                                               : "[C] Third Person");
+  if ((w = hud.widget(HUD_CAMERA_MODE, camera->getMode()))) {
+    w->color(0.8f, 0.8f, 0.8f);
+    w->text(WINDOW_WIDTH - 220, WINDOW_HEIGHT - 30,
+            camera->getMode() == FIRST_PERSON ? "[C] First Person"
+                                              : "[C] Third Person");
+  }
+
+  // --- Bottom Right: Occlusion Buffer (debug) ---
+  if (showOcclusionBuffer) {
+    OcclusionBuffer &occlusion = currentLevel->getOcclusion();
+    float bw = OcclusionBuffer::width * 1.5f;
+    float bh = OcclusionBuffer::height * 1.5f;
+    occlusion.drawDebug(WINDOW_WIDTH - bw - 10, 10, bw, bh);
+    long long key = occlusion.getOccluderCount() * 1000000000000LL +
+                    OcclusionBuffer::occludedCount * 1000000LL +
+                    OcclusionBuffer::testedCount;
+    if ((w = hud.widget(HUD_OCCLUSION_STATS, key))) {
+      w->color(1.0f, 1.0f, 0.0f);
+      sprintf(buffer, "Occluders: %d  Occluded: %d / %d",
+              occlusion.getOccluderCount(), OcclusionBuffer::occludedCount,
+              OcclusionBuffer::testedCount);
+      w->text(WINDOW_WIDTH - bw - 10, bh + 20, buffer);
+    }
+  }
 
   // --- Damage Overlay (Red Flash) ---
   float flash = player->getDamageFlashTimer();
   if (flash > 0.0f) {
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glColor4f(1.0f, 0.0f, 0.0f, flash * 1.5f); // Fade out
-    glBegin(GL_QUADS);
-    glVertex2f(0, 0);
-    glVertex2f(WINDOW_WIDTH, 0);
-    glVertex2f(WINDOW_WIDTH, WINDOW_HEIGHT);
-    glVertex2f(0, WINDOW_HEIGHT);
-    glEnd();
-    glDisable(GL_BLEND);
+    float alpha = flash * 1.5f > 1.0f ? 1.0f : flash * 1.5f; // Fade out
+    if ((w = hud.widget(HUD_DAMAGE_FLASH, (long long)(alpha * 255.0f)))) {
+      w->color(1.0f, 0.0f, 0.0f, alpha);
+      w->rect(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+    }
   }
 
   // --- White Fade Exit Transition ---
@@ -469,19 +597,15 @@ void renderHUD() {
   if (exitProgress > 0.0f) {
     if (exitProgress > 1.0f)
       exitProgress = 1.0f;
-
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glColor4f(1.0f, 1.0f, 1.0f, exitProgress);
-    glBegin(GL_QUADS);
-    glVertex2f(0, 0);
-    glVertex2f(WINDOW_WIDTH, 0);
-    glVertex2f(WINDOW_WIDTH, WINDOW_HEIGHT);
-    glVertex2f(0, WINDOW_HEIGHT);
-    glEnd();
-    glDisable(GL_BLEND);
+    if ((w = hud.widget(HUD_EXIT_FADE, (long long)(exitProgress * 255.0f)))) {
+      w->color(1.0f, 1.0f, 1.0f, exitProgress);
+      w->rect(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+    }
   }
 
+  // Everything above in one line draw and one triangle draw
+  hud.draw();
+
   // Restore state
   glEnable(GL_DEPTH_TEST);
   glEnable(GL_LIGHTING);
@@ -521,6 +645,8 @@ void renderGameOver() {
 }
 
 void display() {
+  auto frameStart = std::chrono::steady_clock::now();
+  GlyphAtlas::build(); // Once, through the back buffer, before it is drawn
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
   if (currentState == MENU) {
@@ -530,6 +656,10 @@ void display() {
   } else if (currentState == GAME_OVER) {
     renderGameOver();
   } else if (currentState == LEVEL1 || currentState == LEVEL2) {
+    // The scene may be drawn below window resolution and stretched
+    sceneTarget.begin(windowWidth, windowHeight,
+                      governor.getSettings().renderScale);
+
     // Setup 3D projection
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
@@ -538,19 +668,91 @@ void display() {
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
 
+    // Swap in streamed meshes, a few per frame to keep frame times even;
+    // the level re-bakes the scenery that just became resident, and its
+    // surfaces once their textures are decoded
+    if (Model::updateStreaming(2) > 0)
+      currentLevel->meshesStreamed();
+    currentLevel->updateAssets();
+    if (fullyLoadedPending && Model::getStreamingCount() == 0) {
+      fullyLoadedPending = false;
+      int hits = Model::cacheHits - startupCacheHits;
+      int misses = Model::cacheMisses - startupCacheMisses;
+      printf("Startup: fully loaded in %.1f ms (%s, mesh cache %d hit / %d "
+             "miss)\n",
+             std::chrono::duration<double, std::milli>(
+                 std::chrono::steady_clock::now() - loadStart)
+                 .count(),
+             misses == 0 ? "warm" : "cold", hits, misses);
+    }
+
     // Apply camera
     camera->apply();
 
     // Render level
+    resetTextureBinds();
+    Frustum::resetCounts();
+    OcclusionBuffer::resetCounts();
+    RenderQueue::resetCounts();
+    Snowfall::resetCounts();
+    GlowBatch::resetCounts();
+    HudLayer::resetCounts();
+    LightManager::resetCounts();
+    StaticGeometry::resetCounts();
+    Snowfall::synchronizeTiming = bindReportPending; // Only when reported
+    PrimitiveCache::beginFrame();
     currentLevel->render();
 
     // Render player (only in third person)
     if (camera->getMode() == THIRD_PERSON) {
       player->render();
     }
+    bool hudReportPending = bindReportPending;
+    if (bindReportPending) {
+      bindReportPending = false;
+      printf("Level %d: %d texture binds per frame (%s)\n",
+             currentLevel->isDesert() ? 1 : 2, getTextureBindCount(),
+             TextureAtlas::enabled ? "surface atlas" : "no atlas");
+      printf("Level %d: %d entities and static chunks drawn, %d culled, %d "
+             "occluded (%s)\n",
+             currentLevel->isDesert() ? 1 : 2,
+             Frustum::visibleCount - OcclusionBuffer::occludedCount,
+             Frustum::culledCount, OcclusionBuffer::occludedCount,
+             Frustum::enabled ? "frustum culling" : "no culling");
+      printf("Level %d: static geometry %d chunks drawn, %d culled, %d "
+             "relit by dynamic lights\n",
+             currentLevel->isDesert() ? 1 : 2, StaticGeometry::drawnChunks,
+             StaticGeometry::culledChunks, StaticGeometry::dynamicLitChunks);
+      printf("Level %d: %d state changes for %d queued draws (%s)\n",
+             currentLevel->isDesert() ? 1 : 2, RenderQueue::stateChanges,
+             RenderQueue::itemCount,
+             RenderQueue::sorting ? "state sorted" : "submission order");
+      printf("Level %d: %zu primitive meshes cached (%s)\n",
+             currentLevel->isDesert() ? 1 : 2, PrimitiveCache::getMeshCount(),
+             PrimitiveCache::enabled ? "primitive cache" : "GLUT/GLU");
+      printf("Level %d: %d glow sprites\n", currentLevel->isDesert() ? 1 : 2,
+             GlowBatch::spriteCount);
+      printf("Level %d: %d light selections scoring %d candidates, %d light "
+             "slot changes (up to %d per object)\n",
+             currentLevel->isDesert() ? 1 : 2, LightManager::selectionCount,
+             LightManager::candidateCount, LightManager::slotChanges,
+             LightManager::budget);
+      if (Snowfall::drawnCount > 0)
+        printf("Level %d: %d snowflakes drawn in %.2f ms (one point draw, "
+               "GPU included)\n",
+               currentLevel->isDesert() ? 1 : 2, Snowfall::drawnCount,
+               Snowfall::drawMs);
+    }
+
+    sceneTarget.end();
 
     // Render HUD
     renderHUD();
+    if (hudReportPending)
+      printf("Level %d: HUD %d draws, %d vertices, %d widgets rebuilt in "
+             "%.2f ms\n",
+             currentLevel->isDesert() ? 1 : 2, HudLayer::drawCalls,
+             HudLayer::vertexCount, HudLayer::rebuiltCount, HudLayer::cpuMs);
 
     // Render paused overlay
     if (currentState == PAUSED) {
@@ -559,6 +761,29 @@ void display() {
   }
 
   glutSwapBuffers();
+
+  // Swap waits for a software rasterizer; on a GPU this is CPU and driver
+  // time, which is what the governor's levers mostly cut there too
+  if (currentState == LEVEL1 || currentState == LEVEL2)
+    governor.frameFinished(std::chrono::duration<float, std::milli>(
+                               std::chrono::steady_clock::now() - frameStart)
+                               .count());
+
+  if (firstFramePending && currentState == LEVEL1) {
+    firstFramePending = false;
+    printf("Startup: first frame in %.1f ms\n",
+           std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - loadStart)
+               .count());
+  }
+
+  if (transitionFramePending && currentState == LEVEL2) {
+    transitionFramePending = false;
+    printf("Level transition frame: %.1f ms\n",
+           std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - transitionStart)
+               .count());
+  }
 }
 
 // ============================================================================
@@ -601,6 +826,9 @@ void keyboard(unsigned char key, int x, int y) {
     if (key == 'r' || key == 'R') {
       fullReset();
     }
+    if (key == 'o' || key == 'O') {
+      showOcclusionBuffer = !showOcclusionBuffer;
+    }
   } else if (currentState == WIN) {
     if (key == 13) { // ENTER - restart
       cleanup();
@@ -647,6 +875,8 @@ void mouseMotion(int x, int y) {
 void reshape(int width, int height) {
   if (height == 0)
     height = 1;
+  windowWidth = width;
+  windowHeight = height;
   glViewport(0, 0, width, height);
 }
 
@@ -668,6 +898,50 @@ int main(int argc, char **argv) {
 
   initOpenGL();
 
+  // --no-atlas draws level surfaces from separate textures, --no-cull
+  // draws every entity, --no-occlusion skips only the occlusion test and
+  // --no-sort draws queued entities in submission order, --no-prim-cache
+  // tessellates spheres, cones etc. through GLUT/GLU, for comparison;
+  // --snow=N sets the flakes in level 2; --no-governor keeps full quality
+  // whatever the frame time, --frame-target=MS sets the governor's target;
+  // --lights=N sets the point lights per object (0 to 7); --no-light-bake
+  // lights the static level geometry live instead of from baked colours;
+  // --no-streaming loads each level's assets in one parallel batch before
+  // its first frame instead of streaming them in behind it
+  Model::streaming = true;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--no-atlas") == 0)
+      TextureAtlas::enabled = false;
+    else if (strcmp(argv[i], "--no-cull") == 0)
+      Frustum::enabled = OcclusionBuffer::enabled = false;
+    else if (strcmp(argv[i], "--no-occlusion") == 0)
+      OcclusionBuffer::enabled = false;
+    else if (strcmp(argv[i], "--no-sort") == 0)
+      RenderQueue::sorting = false;
+    else if (strcmp(argv[i], "--no-prim-cache") == 0)
+      PrimitiveCache::enabled = false;
+    else if (strncmp(argv[i], "--snow=", 7) == 0)
+      Snowfall::defaultCount = (size_t)atol(argv[i] + 7);
+    else if (strcmp(argv[i], "--no-governor") == 0)
+      QualityGovernor::enabled = false;
+    else if (strncmp(argv[i], "--frame-target=", 15) == 0)
+      QualityGovernor::targetMs = (float)atof(argv[i] + 15);
+    else if (strncmp(argv[i], "--lights=", 9) == 0)
+      LightManager::budget = atoi(argv[i] + 9);
+    else if (strcmp(argv[i], "--no-light-bake") == 0)
+      StaticGeometry::bakeLights = false;
+    else if (strcmp(argv[i], "--no-streaming") == 0)
+      Model::streaming = false;
+  }
+
+  // One mapping serves every mesh, texture and sound (built by pack_assets)
+  if (AssetPack::shared().open("assets.pack"))
+    printf("Asset pack: %zu entries, %zu bytes mapped\n",
+           AssetPack::shared().getEntryCount(),
+           AssetPack::shared().getFileSize());
+  else
+    printf("No asset pack, loading loose files from assets/\n");
+
   // Register callbacks
   glutDisplayFunc(display);
   glutReshapeFunc(reshape);
@@ -687,5 +961,6 @@ int main(int argc, char **argv) {
   glutMainLoop();
 
   cleanup();
+  AssetRegistry::shutdown();
   return 0;
 }
\ No newline at end of file
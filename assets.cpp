@@ -0,0 +1,441 @@
+// ============================================================================
+// Assets.cpp - Shared Asset Registry Implementation
+// ============================================================================
+
+#include "assets.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+
+std::map<std::string, AssetRegistry::ModelEntry> AssetRegistry::models;
+std::map<std::string, AssetRegistry::TextureEntry> AssetRegistry::textures;
+int AssetRegistry::modelHits = 0;
+int AssetRegistry::modelMisses = 0;
+int AssetRegistry::textureHits = 0;
+int AssetRegistry::textureMisses = 0;
+unsigned long AssetRegistry::useClock = 0;
+size_t AssetRegistry::textureBudget = 32u << 20;
+size_t AssetRegistry::textureBytes = 0;
+
+bool AssetRegistry::upgradeModel(ModelEntry &entry, const std::string &path,
+                                 bool withLods, bool retainCpuData) {
+  bool needLods = withLods && !entry.withLods;
+  bool needCpuData = retainCpuData && !entry.retainCpuData;
+  if (!needLods && !needCpuData)
+    return false;
+  entry.withLods = entry.withLods || withLods;
+  entry.retainCpuData = entry.retainCpuData || retainCpuData;
+  entry.model->setRetainCpuData(entry.retainCpuData);
+  // A mesh still streaming in keeps its copy when it arrives
+  if (!needLods && (entry.model->isStreaming() || entry.model->hasCpuData()))
+    return false;
+  // Upgrade in place so existing holders keep a valid pointer
+  entry.model->load(path.c_str(), entry.withLods);
+  modelMisses++;
+  return true;
+}
+
+ModelHandle AssetRegistry::acquireModel(const char *path, bool withLods,
+                                        bool retainCpuData) {
+  auto it = models.find(path);
+  if (it != models.end()) {
+    ModelEntry &entry = it->second;
+    if (!upgradeModel(entry, path, withLods, retainCpuData) &&
+        !entry.preloaded)
+      modelHits++; // A batch load was already counted as the miss
+    entry.preloaded = false;
+    entry.refs++;
+    return ModelHandle(&entry);
+  }
+
+  // Failed loads are kept too: the model renders its placeholder and the
+  // next level does not retry the import
+  Model *model = new Model();
+  model->setRetainCpuData(retainCpuData);
+  if (!model->load(path, withLods))
+    printf("Asset registry: failed to load model %s\n", path);
+  ModelEntry &entry = models[path];
+  entry = {model, 1, withLods, retainCpuData, false};
+  modelMisses++;
+  return ModelHandle(&entry);
+}
+
+void AssetRegistry::release(ModelEntry *entry) {
+  if (entry->refs > 0)
+    entry->refs--;
+}
+
+TextureHandle AssetRegistry::acquireTexture(const char *path) {
+  auto it = textures.find(path);
+  if (it != textures.end()) {
+    TextureEntry &entry = it->second;
+    entry.refs++;
+    if (!entry.preloaded)
+      textureHits++;
+    entry.preloaded = false;
+    entry.lastUse = ++useClock;
+    return TextureHandle(&entry);
+  }
+
+  TextureEntry &entry = addTexture(path, loadBMP(path), 1, false);
+  textureMisses++;
+  enforceTextureBudget();
+  if (textureBytes > textureBudget)
+    printf("Texture budget exceeded: %zu bytes in use, budget %zu\n",
+           textureBytes, textureBudget);
+  return TextureHandle(&entry);
+}
+
+std::string AssetRegistry::atlasKey(const std::vector<std::string> &paths) {
+  std::string key = "atlas:";
+  for (size_t i = 0; i < paths.size(); i++)
+    key += (i ? "+" : "") + paths[i];
+  return key;
+}
+
+TextureHandle
+AssetRegistry::acquireAtlas(const std::vector<std::string> &paths) {
+  std::string key = atlasKey(paths);
+  auto it = textures.find(key);
+  if (it != textures.end()) {
+    TextureEntry &entry = it->second;
+    entry.refs++;
+    if (!entry.preloaded)
+      textureHits++;
+    entry.preloaded = false;
+    entry.lastUse = ++useClock;
+    return TextureHandle(&entry);
+  }
+
+  BMPImage image;
+  std::vector<TextureRegion> regions;
+  Texture texture;
+  if (TextureAtlas::pack(paths, image, regions))
+    texture = TextureAtlas::upload(image, regions);
+  else
+    regions.clear();
+  TextureEntry &entry = addTexture(key, texture, 1, false);
+  entry.regions = regions;
+  textureMisses++;
+  enforceTextureBudget();
+  if (textureBytes > textureBudget)
+    printf("Texture budget exceeded: %zu bytes in use, budget %zu\n",
+           textureBytes, textureBudget);
+  return TextureHandle(&entry);
+}
+
+void AssetRegistry::release(TextureEntry *entry) {
+  if (entry->refs > 0)
+    entry->refs--;
+  entry->lastUse = ++useClock;
+  if (entry->refs == 0)
+    enforceTextureBudget();
+}
+
+AssetRegistry::TextureEntry &
+AssetRegistry::addTexture(const std::string &path, const Texture &texture,
+                          int refs, bool preloaded) {
+  TextureEntry &entry = textures[path];
+  entry = {texture, {}, refs, preloaded, ++useClock};
+  textureBytes += texture.bytes;
+  return entry;
+}
+
+void AssetRegistry::deleteTexture(
+    std::map<std::string, TextureEntry>::iterator it) {
+  if (it->second.texture.id != 0)
+    glDeleteTextures(1, &it->second.texture.id);
+  textureBytes -= it->second.texture.bytes;
+  textures.erase(it);
+}
+
+void AssetRegistry::enforceTextureBudget() {
+  while (textureBytes > textureBudget) {
+    // Least recently released texture nobody holds. Prefetched textures
+    // (preloaded) are waiting for their first user and are kept.
+    auto victim = textures.end();
+    for (auto it = textures.begin(); it != textures.end(); ++it) {
+      const TextureEntry &entry = it->second;
+      if (entry.refs == 0 && !entry.preloaded && entry.texture.id != 0 &&
+          (victim == textures.end() || entry.lastUse < victim->second.lastUse))
+        victim = it;
+    }
+    if (victim == textures.end())
+      return; // Everything left is in use
+    printf("Texture evicted: %s (%zu bytes)\n", victim->first.c_str(),
+           victim->second.texture.bytes);
+    deleteTexture(victim);
+  }
+}
+
+void AssetRegistry::purgeUnused() {
+  for (auto it = models.begin(); it != models.end();) {
+    if (it->second.refs == 0) {
+      delete it->second.model;
+      it = models.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  for (auto it = textures.begin(); it != textures.end();) {
+    auto next = std::next(it);
+    if (it->second.refs == 0)
+      deleteTexture(it);
+    it = next;
+  }
+}
+
+void AssetRegistry::shutdown() {
+  for (auto &m : models)
+    delete m.second.model;
+  models.clear();
+  for (auto &t : textures)
+    if (t.second.texture.id != 0)
+      glDeleteTextures(1, &t.second.texture.id);
+  textures.clear();
+  textureBytes = 0;
+}
+
+void AssetRegistry::printReport() {
+  printf("Asset registry: %zu models (%d hit / %d miss), %zu textures "
+         "(%d hit / %d miss)\n",
+         models.size(), modelHits, modelMisses, textures.size(), textureHits,
+         textureMisses);
+  for (const auto &m : models)
+    printf("  model   %-32s refs %d\n", m.first.c_str(), m.second.refs);
+  printf("  textures resident: %zu bytes of %zu budget\n", textureBytes,
+         textureBudget);
+  for (const auto &t : textures)
+    printf("  texture %-32s refs %d, %zu bytes\n", t.first.c_str(),
+           t.second.refs, t.second.texture.bytes);
+}
+
+// ============================================================================
+// HANDLES
+// ============================================================================
+
+ModelHandle &ModelHandle::operator=(ModelHandle &&other) {
+  if (this != &other) {
+    reset();
+    entry = other.entry;
+    other.entry = nullptr;
+  }
+  return *this;
+}
+
+void ModelHandle::reset() {
+  if (entry)
+    AssetRegistry::release(entry);
+  entry = nullptr;
+}
+
+TextureHandle &TextureHandle::operator=(TextureHandle &&other) {
+  if (this != &other) {
+    reset();
+    entry = other.entry;
+    other.entry = nullptr;
+  }
+  return *this;
+}
+
+void TextureHandle::reset() {
+  if (entry)
+    AssetRegistry::release(entry);
+  entry = nullptr;
+}
+
+const Texture &TextureHandle::get() const {
+  static const Texture none;
+  return entry ? entry->texture : none;
+}
+
+TextureRegion TextureHandle::getRegion(size_t index) const {
+  if (entry && index < entry->regions.size())
+    return entry->regions[index];
+  return TextureRegion(get());
+}
+
+// ============================================================================
+// ASSET BATCH
+// ============================================================================
+
+static double msSince(std::chrono::steady_clock::time_point start,
+                      std::chrono::steady_clock::time_point end) {
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+AssetBatch::AssetBatch() {
+  started = false;
+  wallMs = 0.0;
+  summedMs = 0.0;
+  uploadMs = 0.0;
+}
+
+AssetBatch::~AssetBatch() {
+  // Workers hold pointers into this batch
+  for (auto &job : jobs)
+    job.wait();
+  for (auto &m : models)
+    delete m.model;
+}
+
+void AssetBatch::addModel(const char *path, bool withLods,
+                          bool retainCpuData) {
+  auto it = AssetRegistry::models.find(path);
+  if (it != AssetRegistry::models.end() &&
+      (it->second.withLods || !withLods) &&
+      (it->second.retainCpuData || !retainCpuData))
+    return;
+  for (auto &m : models) {
+    if (m.path == path) {
+      m.withLods = m.withLods || withLods;
+      m.retainCpuData = m.retainCpuData || retainCpuData;
+      return;
+    }
+  }
+  models.push_back({path, withLods, retainCpuData, nullptr, false, 0.0});
+}
+
+void AssetBatch::addTexture(const char *path) {
+  if (AssetRegistry::textures.count(path))
+    return;
+  for (auto &t : textures)
+    if (t.path == path)
+      return;
+  textures.push_back({path, BMPImage(), false, 0.0});
+}
+
+void AssetBatch::addAtlas(const std::vector<std::string> &paths) {
+  std::string key = AssetRegistry::atlasKey(paths);
+  if (AssetRegistry::textures.count(key))
+    return;
+  for (auto &a : atlases)
+    if (a.key == key)
+      return;
+  atlases.push_back({key, paths, BMPImage(), {}, false, 0.0});
+}
+
+void AssetBatch::start() {
+  if (started)
+    return;
+  started = true;
+  startTime = std::chrono::steady_clock::now();
+  jobEnds.assign(size(), startTime);
+
+  // Vectors are not resized after this point, so workers may keep indices
+  ThreadPool &pool = ThreadPool::shared();
+  for (size_t i = 0; i < models.size(); i++) {
+    models[i].model = new Model();
+    jobs.push_back(pool.submit([this, i] {
+      PendingModel &m = models[i];
+      auto begin = std::chrono::steady_clock::now();
+      m.ok = m.model->decode(m.path.c_str(), m.withLods);
+      jobEnds[i] = std::chrono::steady_clock::now();
+      m.ms = msSince(begin, jobEnds[i]);
+    }));
+  }
+  for (size_t i = 0; i < textures.size(); i++) {
+    size_t slot = models.size() + i;
+    jobs.push_back(pool.submit([this, i, slot] {
+      PendingTexture &t = textures[i];
+      auto begin = std::chrono::steady_clock::now();
+      t.ok = readBMP(t.path.c_str(), t.image);
+      jobEnds[slot] = std::chrono::steady_clock::now();
+      t.ms = msSince(begin, jobEnds[slot]);
+    }));
+  }
+  for (size_t i = 0; i < atlases.size(); i++) {
+    size_t slot = models.size() + textures.size() + i;
+    jobs.push_back(pool.submit([this, i, slot] {
+      PendingAtlas &a = atlases[i];
+      auto begin = std::chrono::steady_clock::now();
+      a.ok = TextureAtlas::pack(a.paths, a.image, a.regions);
+      jobEnds[slot] = std::chrono::steady_clock::now();
+      a.ms = msSince(begin, jobEnds[slot]);
+    }));
+  }
+}
+
+bool AssetBatch::isDecoded() const {
+  if (!started)
+    return false;
+  for (auto &job : jobs)
+    if (job.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+      return false;
+  return true;
+}
+
+void AssetBatch::finish() {
+  start();
+  for (auto &job : jobs)
+    job.wait();
+
+  summedMs = 0.0;
+  auto lastEnd = startTime;
+  for (auto &end : jobEnds)
+    lastEnd = std::max(lastEnd, end);
+  wallMs = msSince(startTime, lastEnd);
+
+  // GL object creation happens here, on the calling thread
+  auto uploadStart = std::chrono::steady_clock::now();
+  for (auto &m : models) {
+    summedMs += m.ms;
+    auto &entries = AssetRegistry::models;
+    auto it = entries.find(m.path);
+    if (it != entries.end()) {
+      // Acquired directly while this batch was decoding. If that copy lacks
+      // LODs or its CPU copy, reload it in place for its holders (the cache
+      // is warm now).
+      AssetRegistry::upgradeModel(it->second, m.path, m.withLods,
+                                  m.retainCpuData);
+      delete m.model;
+    } else {
+      m.model->setRetainCpuData(m.retainCpuData);
+      if (!(m.ok && m.model->upload()))
+        printf("Asset registry: failed to load model %s\n", m.path.c_str());
+      entries[m.path] = {m.model, 0, m.withLods, m.retainCpuData, true};
+      AssetRegistry::modelMisses++;
+    }
+    m.model = nullptr;
+  }
+  for (auto &t : textures) {
+    summedMs += t.ms;
+    if (!AssetRegistry::textures.count(t.path)) {
+      Texture texture;
+      if (t.ok)
+        texture = uploadBMP(t.image, t.path.c_str());
+      AssetRegistry::addTexture(t.path, texture, 0, true);
+      AssetRegistry::textureMisses++;
+    }
+    t.image = BMPImage();
+  }
+  for (auto &a : atlases) {
+    summedMs += a.ms;
+    if (!AssetRegistry::textures.count(a.key)) {
+      Texture texture;
+      if (a.ok)
+        texture = TextureAtlas::upload(a.image, a.regions);
+      else
+        a.regions.clear();
+      AssetRegistry::addTexture(a.key, texture, 0, true).regions = a.regions;
+      AssetRegistry::textureMisses++;
+    }
+    a.image = BMPImage();
+  }
+  AssetRegistry::enforceTextureBudget();
+  if (AssetRegistry::textureBytes > AssetRegistry::textureBudget)
+    printf("Texture budget exceeded: %zu bytes in use, budget %zu\n",
+           AssetRegistry::textureBytes, AssetRegistry::textureBudget);
+  uploadMs = msSince(uploadStart, std::chrono::steady_clock::now());
+
+  if (size() > 0)
+    printf("Asset batch: %zu assets decoded in %.1f ms wall / %.1f ms summed "
+           "(%.1fx on %u threads), GL upload %.1f ms\n",
+           size(), wallMs, summedMs, wallMs > 0.0 ? summedMs / wallMs : 1.0,
+           ThreadPool::shared().getThreadCount(), uploadMs);
+  models.clear();
+  textures.clear();
+  atlases.clear();
+  jobs.clear();
+}
@@ -0,0 +1,218 @@
+// ============================================================================
+// Assets.h - Shared Asset Registry
+// Loads each model/texture once per process and hands out ref-counted handles
+// ============================================================================
+
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include "atlas.h"
+#include "model.h"
+#include "utils.h"
+#include <chrono>
+#include <future>
+#include <map>
+#include <string>
+#include <vector>
+
+class ModelHandle;
+class TextureHandle;
+
+// Every acquire returns a handle holding one reference, released when the
+// handle is destroyed or reassigned. Models whose count drops to zero stay
+// loaded (so level transitions and restarts reuse them) until purgeUnused()
+// or shutdown() is called. Unused textures are kept the same way only while
+// the texture bytes fit textureBudget; past it, the least recently released
+// ones are deleted (a budget of 0 deletes a texture as soon as its last user
+// releases it). Surface atlases are registered as textures too, under a key
+// naming their sources, so they share the same reuse and budget.
+class AssetRegistry {
+private:
+    struct ModelEntry {
+        Model* model;
+        int refs;
+        bool withLods;
+        bool retainCpuData; // see Model::setRetainCpuData()
+        bool preloaded; // added by an AssetBatch, not yet acquired
+    };
+    struct TextureEntry {
+        Texture texture;
+        std::vector<TextureRegion> regions; // atlases only
+        int refs;
+        bool preloaded;
+        unsigned long lastUse; // useClock at the last acquire/release
+    };
+
+    static std::map<std::string, ModelEntry> models;
+    static std::map<std::string, TextureEntry> textures;
+    static unsigned long useClock;
+
+    static TextureEntry& addTexture(const std::string& path,
+                                    const Texture& texture, int refs,
+                                    bool preloaded);
+    static void deleteTexture(std::map<std::string, TextureEntry>::iterator it);
+    // Called by the handles; entries are found directly, never by search
+    static void release(ModelEntry* entry);
+    static void release(TextureEntry* entry);
+    // Reloads a model in place (handles stay valid) when a request needs
+    // LODs or a CPU copy it was loaded without; true if it did
+    static bool upgradeModel(ModelEntry& entry, const std::string& path,
+                             bool withLods, bool retainCpuData);
+
+public:
+    // Models are keyed by path; a later withLods request on a model that was
+    // first loaded without LODs reloads it in place (handles stay valid).
+    // retainCpuData keeps the model's packed vertices after upload, for
+    // Model::getMesh(), and upgrades a loaded model the same way.
+    static ModelHandle acquireModel(const char* path, bool withLods = false,
+                                    bool retainCpuData = false);
+    static TextureHandle acquireTexture(const char* path);
+    // Packs the textures into one atlas (see TextureAtlas). A failed pack is
+    // held like a failed texture: id 0 and no regions.
+    static TextureHandle acquireAtlas(const std::vector<std::string>& paths);
+    static std::string atlasKey(const std::vector<std::string>& paths);
+
+    // Texture residency: bytes of every registered texture (mips included)
+    // against the budget unused textures are evicted to stay under
+    static size_t textureBudget;
+    static size_t textureBytes;
+    static void enforceTextureBudget();
+
+    // Frees assets nobody holds any more
+    static void purgeUnused();
+    // Frees everything (call once the GL context is going away and every
+    // handle has been dropped)
+    static void shutdown();
+
+    // Lookup statistics
+    static int modelHits;
+    static int modelMisses;
+    static int textureHits;
+    static int textureMisses;
+    static int hits() { return modelHits + textureHits; }
+    static int misses() { return modelMisses + textureMisses; }
+
+    static void printReport();
+
+    friend class AssetBatch;
+    friend class ModelHandle;
+    friend class TextureHandle;
+};
+
+// Move-only reference to a registry model; empty when default constructed
+// or moved from
+class ModelHandle {
+private:
+    AssetRegistry::ModelEntry* entry;
+
+    explicit ModelHandle(AssetRegistry::ModelEntry* e) : entry(e) {}
+    friend class AssetRegistry;
+
+public:
+    ModelHandle() : entry(nullptr) {}
+    ModelHandle(ModelHandle&& other) : entry(other.entry) {
+        other.entry = nullptr;
+    }
+    ModelHandle& operator=(ModelHandle&& other);
+    ~ModelHandle() { reset(); }
+    ModelHandle(const ModelHandle&) = delete;
+    ModelHandle& operator=(const ModelHandle&) = delete;
+
+    // Drops the reference, leaving the handle empty
+    void reset();
+
+    Model* get() const { return entry ? entry->model : nullptr; }
+    Model* operator->() const { return get(); }
+    explicit operator bool() const { return entry != nullptr; }
+};
+
+// Move-only reference to a registry texture. A failed load is held like any
+// other and reads as a Texture with id 0.
+class TextureHandle {
+private:
+    AssetRegistry::TextureEntry* entry;
+
+    explicit TextureHandle(AssetRegistry::TextureEntry* e) : entry(e) {}
+    friend class AssetRegistry;
+
+public:
+    TextureHandle() : entry(nullptr) {}
+    TextureHandle(TextureHandle&& other) : entry(other.entry) {
+        other.entry = nullptr;
+    }
+    TextureHandle& operator=(TextureHandle&& other);
+    ~TextureHandle() { reset(); }
+    TextureHandle(const TextureHandle&) = delete;
+    TextureHandle& operator=(const TextureHandle&) = delete;
+
+    void reset();
+
+    const Texture& get() const;
+    const Texture* operator->() const { return &get(); }
+    // Region of source `index` for an atlas; the whole texture otherwise
+    TextureRegion getRegion(size_t index) const;
+    explicit operator bool() const { return entry != nullptr; }
+};
+
+// Loads a set of assets in parallel: start() decodes them on the shared
+// thread pool, finish() uploads them on the calling (GL) thread and hands
+// them to the registry, so the acquire calls that follow find them resident.
+// Assets the registry already holds are skipped.
+class AssetBatch {
+private:
+    struct PendingModel {
+        std::string path;
+        bool withLods;
+        bool retainCpuData;
+        Model* model;
+        bool ok;
+        double ms;
+    };
+    struct PendingTexture {
+        std::string path;
+        BMPImage image;
+        bool ok;
+        double ms;
+    };
+    struct PendingAtlas {
+        std::string key;
+        std::vector<std::string> paths;
+        BMPImage image;
+        std::vector<TextureRegion> regions;
+        bool ok;
+        double ms;
+    };
+
+    std::vector<PendingModel> models;
+    std::vector<PendingTexture> textures;
+    std::vector<PendingAtlas> atlases;
+    std::vector<std::future<void>> jobs;
+    std::vector<std::chrono::steady_clock::time_point> jobEnds;
+    std::chrono::steady_clock::time_point startTime;
+    bool started;
+    double wallMs;   // first decode start to last decode end
+    double summedMs; // sum of per-asset decode times
+    double uploadMs;
+
+public:
+    AssetBatch();
+    ~AssetBatch();
+
+    void addModel(const char* path, bool withLods = false,
+                  bool retainCpuData = false);
+    void addTexture(const char* path);
+    void addAtlas(const std::vector<std::string>& paths);
+    size_t size() const {
+        return models.size() + textures.size() + atlases.size();
+    }
+
+    void start();
+    bool isDecoded() const;
+    void finish();
+
+    double getWallMs() const { return wallMs; }
+    double getSummedMs() const { return summedMs; }
+    double getUploadMs() const { return uploadMs; }
+};
+
+#endif // ASSETS_H
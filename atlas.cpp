@@ -0,0 +1,152 @@
+// ============================================================================
+// Atlas.cpp - Surface Texture Atlas Implementation
+// ============================================================================
+
+#include "atlas.h"
+#include <algorithm>
+#include <cstdio>
+
+#ifndef GL_TEXTURE_MAX_LEVEL
+#define GL_TEXTURE_MAX_LEVEL 0x813D
+#endif
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE 0x812F
+#endif
+
+bool TextureAtlas::enabled = true;
+
+// Texture bound through bindTexture(), while nothing else has rebound it
+static GLuint boundTexture = 0;
+static bool bindingKnown = false;
+static int textureBinds = 0;
+
+static int roundUp(int value, int step) {
+  return (value + step - 1) / step * step;
+}
+
+bool TextureAtlas::pack(const std::vector<std::string> &paths,
+                        BMPImage &atlas, std::vector<TextureRegion> &regions) {
+  regions.clear();
+  if (paths.empty())
+    return false;
+
+  // Mapped, not copied: the pixels are only read while the atlas is filled
+  std::vector<BMPImage> sources(paths.size());
+  for (size_t i = 0; i < paths.size(); i++)
+    if (!openBMP(paths[i].c_str(), sources[i]))
+      return false;
+
+  // Shelf packing, tallest first, into a power-of-two wide atlas
+  struct Cell {
+    size_t source;
+    int x, y, w, h;
+  };
+  std::vector<Cell> cells;
+  long area = 0;
+  int widest = 0;
+  for (size_t i = 0; i < sources.size(); i++) {
+    Cell cell = {i, 0, 0, roundUp(sources[i].width + 2 * padding, padding),
+                 roundUp(sources[i].height + 2 * padding, padding)};
+    cells.push_back(cell);
+    area += (long)cell.w * cell.h;
+    widest = std::max(widest, cell.w);
+  }
+  std::sort(cells.begin(), cells.end(),
+            [](const Cell &a, const Cell &b) { return a.h > b.h; });
+  int atlasWidth = 1;
+  while (atlasWidth < widest || (long)atlasWidth * atlasWidth < area)
+    atlasWidth *= 2;
+  int shelfX = 0, shelfY = 0, shelfH = 0;
+  for (Cell &cell : cells) {
+    if (shelfX + cell.w > atlasWidth) {
+      shelfY += shelfH;
+      shelfX = shelfH = 0;
+    }
+    cell.x = shelfX;
+    cell.y = shelfY;
+    shelfX += cell.w;
+    shelfH = std::max(shelfH, cell.h);
+  }
+  int atlasHeight = shelfY + shelfH;
+
+  atlas = BMPImage();
+  atlas.width = atlasWidth;
+  atlas.height = atlasHeight;
+  atlas.bytesPerPixel = 3;
+  atlas.stride = bmpRowBytes(atlasWidth, 3);
+  atlas.storage.assign(atlas.stride * atlasHeight, 0);
+  atlas.pixels = atlas.storage.data();
+
+  regions.resize(paths.size());
+  for (const Cell &cell : cells) {
+    const BMPImage &src = sources[cell.source];
+    int bpp = src.bytesPerPixel;
+    // The gutter repeats the opposite edges, as GL_REPEAT would sample them
+    for (int y = -padding; y < src.height + padding; y++) {
+      int srcY = (y % src.height + src.height) % src.height;
+      const unsigned char *srcRow = src.pixels + (size_t)srcY * src.stride;
+      unsigned char *dstRow = atlas.storage.data() +
+                              (size_t)(cell.y + padding + y) * atlas.stride +
+                              (size_t)(cell.x + padding) * 3;
+      for (int x = -padding; x < src.width + padding; x++) {
+        int srcX = (x % src.width + src.width) % src.width;
+        const unsigned char *texel = srcRow + (size_t)srcX * bpp;
+        unsigned char *out = dstRow + x * 3;
+        out[0] = texel[0];
+        out[1] = texel[1];
+        out[2] = texel[2];
+      }
+    }
+
+    TextureRegion &region = regions[cell.source];
+    region.u0 = (float)(cell.x + padding) / atlasWidth;
+    region.v0 = (float)(cell.y + padding) / atlasHeight;
+    region.u1 = (float)(cell.x + padding + src.width) / atlasWidth;
+    region.v1 = (float)(cell.y + padding + src.height) / atlasHeight;
+  }
+
+  buildMipChain(atlas);
+  return true;
+}
+
+Texture TextureAtlas::upload(const BMPImage &atlas,
+                             std::vector<TextureRegion> &regions) {
+  Texture texture = uploadBMP(atlas, "surface atlas");
+  if (texture.id == 0)
+    return texture;
+
+  // Past log2(padding) levels the gutters would blend neighbouring sources
+  int maxLevel = 0;
+  while ((2 << maxLevel) <= padding)
+    maxLevel++;
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, maxLevel);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  bindingKnown = false; // uploadBMP bound the atlas behind bindTexture's back
+
+  for (TextureRegion &region : regions)
+    region.id = texture.id;
+  printf("Texture atlas: %zu surfaces in %dx%d (%d mip levels)\n",
+         regions.size(), atlas.width, atlas.height, maxLevel + 1);
+  return texture;
+}
+
+// ============================================================================
+// BIND TRACKING
+// ============================================================================
+
+void bindTexture(GLuint id) {
+  if (bindingKnown && boundTexture == id)
+    return;
+  glBindTexture(GL_TEXTURE_2D, id);
+  boundTexture = id;
+  bindingKnown = true;
+  textureBinds++;
+}
+
+void resetTextureBinds() {
+  bindingKnown = false;
+  textureBinds = 0;
+}
+
+int getTextureBindCount() { return textureBinds; }
@@ -0,0 +1,60 @@
+// ============================================================================
+// Atlas.h - Surface Texture Atlas
+// Packs a level's tiling surface textures (ground, walls) into one texture
+// so its surfaces are drawn without rebinding
+// ============================================================================
+
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include "utils.h"
+#include <string>
+#include <vector>
+
+// A whole texture or the part of an atlas one source texture occupies. Draw
+// code maps its 0..1 texture coordinates through u()/v(); repeats have to be
+// tessellated, since GL_REPEAT would wrap over the whole atlas.
+struct TextureRegion {
+    GLuint id;
+    float u0, v0, u1, v1;
+
+    TextureRegion() : id(0), u0(0), v0(0), u1(1), v1(1) {}
+    explicit TextureRegion(const Texture& texture)
+        : id(texture.id), u0(0), v0(0), u1(1), v1(1) {}
+
+    float u(float s) const { return u0 + (u1 - u0) * s; }
+    float v(float t) const { return v0 + (v1 - v0) * t; }
+};
+
+// Each source is surrounded by a gutter of `padding` texels holding its own
+// wrapped-around edges and placed on a padding-aligned grid, so bilinear
+// filtering at a tile seam reads the neighbouring tile rather than another
+// texture. Mip levels stop where the gutter shrinks to one texel.
+// Atlases are owned by the AssetRegistry (see acquireAtlas()); this class
+// only packs and uploads them.
+class TextureAtlas {
+public:
+    static const int padding = 16;
+
+    // Reads the BMPs from the asset pack or disk and packs them, mips
+    // included, into `atlas`; regions[i] receives the texture coordinates of
+    // paths[i]. Touches no GL state, so it may run on a worker thread. Fails
+    // if a source is missing.
+    static bool pack(const std::vector<std::string>& paths, BMPImage& atlas,
+                     std::vector<TextureRegion>& regions);
+    // Uploads a packed atlas and points the regions at it (GL thread only)
+    static Texture upload(const BMPImage& atlas,
+                          std::vector<TextureRegion>& regions);
+
+    // Levels pack their surfaces only while this is set
+    static bool enabled;
+};
+
+// Binds a texture unless it is the one already bound, and counts the binds
+// that reach GL. resetTextureBinds() forgets the current binding and zeroes
+// the count; call it at the start of every frame.
+void bindTexture(GLuint id);
+void resetTextureBinds();
+int getTextureBindCount();
+
+#endif // ATLAS_H
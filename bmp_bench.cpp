@@ -0,0 +1,185 @@
+// ============================================================================
+// BmpBench.cpp - BMP Loader Benchmark
+// Times the old fread-and-copy BMP loader against the mmap'd zero-copy reader
+// on every .bmp in a directory and reports throughput in bytes/s
+// Usage: bmp_bench [asset directory] [iterations] [upload]
+// ============================================================================
+
+#include "utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+// Every path has to read each pixel, as glTexImage2D would; otherwise the
+// mapped reader would only be timing the header
+static unsigned long long touchPixels(const unsigned char *pixels,
+                                      size_t bytes) {
+  unsigned long long sum = 0;
+  for (size_t i = 0; i < bytes; i += 64)
+    sum += pixels[i];
+  return sum;
+}
+
+// The loader this replaced: fread the header, copy the image to the heap
+static bool legacyLoad(const char *filename, unsigned long long &sum) {
+  FILE *file = fopen(filename, "rb");
+  if (!file)
+    return false;
+  unsigned char header[54];
+  if (fread(header, 1, 54, file) != 54 || header[0] != 'B' ||
+      header[1] != 'M') {
+    fclose(file);
+    return false;
+  }
+  unsigned int dataPos = readLE32(header + 0x0A);
+  unsigned int imageSize = readLE32(header + 0x22);
+  int width = (int)readLE32(header + 0x12);
+  int height = (int)readLE32(header + 0x16);
+  if (imageSize == 0)
+    imageSize = width * height * 3;
+  if (dataPos == 0)
+    dataPos = 54;
+  unsigned char *data = new unsigned char[imageSize];
+  fseek(file, dataPos, SEEK_SET);
+  size_t got = fread(data, 1, imageSize, file);
+  fclose(file);
+  sum += touchPixels(data, got);
+  delete[] data;
+  return got == imageSize;
+}
+
+static bool mappedLoad(const char *filename, bool mips,
+                       unsigned long long &sum) {
+  BMPImage image;
+  if (!(mips ? readBMP(filename, image) : openBMP(filename, image)))
+    return false;
+  sum += touchPixels(image.pixels, image.stride * image.height);
+  return true;
+}
+
+static bool uploadLoad(const char *filename, unsigned long long &sum) {
+  BMPImage image;
+  if (!openBMP(filename, image))
+    return false;
+  Texture tex = uploadBMP(image, filename);
+  glFinish();
+  glDeleteTextures(1, &tex.id);
+  sum += tex.bytes;
+  return tex.id != 0;
+}
+
+enum Mode { MODE_LEGACY, MODE_MAPPED, MODE_MAPPED_MIPS, MODE_UPLOAD };
+
+// Best-of-N time in milliseconds, or a negative value if the load failed
+static double timeLoad(const std::string &path, Mode mode, int iterations,
+                       unsigned long long &sum) {
+  double best = 1e30;
+  for (int i = 0; i < iterations; i++) {
+    auto start = std::chrono::steady_clock::now();
+    bool ok = false;
+    switch (mode) {
+    case MODE_LEGACY:
+      ok = legacyLoad(path.c_str(), sum);
+      break;
+    case MODE_MAPPED:
+      ok = mappedLoad(path.c_str(), false, sum);
+      break;
+    case MODE_MAPPED_MIPS:
+      ok = mappedLoad(path.c_str(), true, sum);
+      break;
+    case MODE_UPLOAD:
+      ok = uploadLoad(path.c_str(), sum);
+      break;
+    }
+    double ms = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+    if (!ok)
+      return -1.0;
+    best = std::min(best, ms);
+  }
+  return best;
+}
+
+static double mbPerSecond(size_t bytes, double ms) {
+  return ms > 0.0 ? bytes / (1024.0 * 1024.0) / (ms / 1000.0) : 0.0;
+}
+
+int main(int argc, char **argv) {
+  std::string dir = argc > 1 ? argv[1] : "assets";
+  int iterations = argc > 2 ? std::max(1, atoi(argv[2])) : 20;
+  bool upload = argc > 3 && strcmp(argv[3], "upload") == 0;
+
+  if (upload) {
+    // uploadBMP needs a current GL context
+    glutInit(&argc, argv);
+    glutInitDisplayMode(GLUT_RGB);
+    glutInitWindowSize(64, 64);
+    glutCreateWindow("bmp_bench");
+  }
+
+  DIR *d = opendir(dir.c_str());
+  if (!d) {
+    printf("Cannot open asset directory: %s\n", dir.c_str());
+    return 1;
+  }
+  std::vector<std::string> files;
+  while (dirent *entry = readdir(d)) {
+    std::string file = entry->d_name;
+    if (file.size() > 4 && file.compare(file.size() - 4, 4, ".bmp") == 0)
+      files.push_back(file);
+  }
+  closedir(d);
+  std::sort(files.begin(), files.end());
+
+  printf("%-22s %9s %10s %10s %10s %10s\n", "file", "KB", "fread ms",
+         "mmap ms", "+mips ms", upload ? "upload ms" : "");
+  double totals[4] = {0.0, 0.0, 0.0, 0.0};
+  size_t bytesTotal = 0;
+  unsigned long long sum = 0;
+  int failures = 0;
+  for (const std::string &file : files) {
+    std::string path = dir + "/" + file;
+    struct stat st;
+    size_t bytes = stat(path.c_str(), &st) == 0 ? (size_t)st.st_size : 0;
+
+    double ms[4] = {0.0, 0.0, 0.0, 0.0};
+    bool ok = true;
+    int lastMode = upload ? MODE_UPLOAD : MODE_MAPPED_MIPS;
+    for (int mode = MODE_LEGACY; mode <= lastMode; mode++) {
+      ms[mode] = timeLoad(path, (Mode)mode, iterations, sum);
+      ok = ok && ms[mode] >= 0.0;
+    }
+    if (!ok) {
+      printf("%-22s %9.1f  (failed to load)\n", file.c_str(), bytes / 1024.0);
+      failures++;
+      continue;
+    }
+    printf("%-22s %9.1f %10.3f %10.3f %10.3f", file.c_str(), bytes / 1024.0,
+           ms[MODE_LEGACY], ms[MODE_MAPPED], ms[MODE_MAPPED_MIPS]);
+    if (upload)
+      printf(" %10.3f", ms[MODE_UPLOAD]);
+    printf("\n");
+    for (int mode = 0; mode < 4; mode++)
+      totals[mode] += ms[mode];
+    bytesTotal += bytes;
+  }
+
+  printf("Total: %.2f MB, fread %.1f MB/s, mmap %.1f MB/s, mmap + mips "
+         "%.1f MB/s",
+         bytesTotal / (1024.0 * 1024.0),
+         mbPerSecond(bytesTotal, totals[MODE_LEGACY]),
+         mbPerSecond(bytesTotal, totals[MODE_MAPPED]),
+         mbPerSecond(bytesTotal, totals[MODE_MAPPED_MIPS]));
+  if (upload)
+    printf(", mmap + upload %.1f MB/s",
+           mbPerSecond(bytesTotal, totals[MODE_UPLOAD]));
+  printf(" (checksum %llu)\n", sum);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,98 @@
+// ============================================================================
+// Frustum.cpp - View-Frustum Culling Implementation
+// ============================================================================
+
+#include "frustum.h"
+#include <cmath>
+#ifdef __APPLE__
+#include <GLUT/glut.h>
+#else
+#include <GL/glut.h>
+#endif
+
+bool Frustum::enabled = true;
+int Frustum::visibleCount = 0;
+int Frustum::culledCount = 0;
+
+static void normalizePlane(float *plane) {
+  float len = sqrtf(plane[0] * plane[0] + plane[1] * plane[1] +
+                    plane[2] * plane[2]);
+  if (len > 0.0f)
+    for (int i = 0; i < 4; i++)
+      plane[i] /= len;
+}
+
+void Frustum::extract(float maxDistance) {
+  GLfloat mv[16], proj[16], clip[16];
+  glGetFloatv(GL_MODELVIEW_MATRIX, mv);
+  glGetFloatv(GL_PROJECTION_MATRIX, proj);
+  // clip = proj * mv, column-major
+  for (int c = 0; c < 4; c++)
+    for (int r = 0; r < 4; r++)
+      clip[c * 4 + r] = proj[r] * mv[c * 4] + proj[4 + r] * mv[c * 4 + 1] +
+                        proj[8 + r] * mv[c * 4 + 2] +
+                        proj[12 + r] * mv[c * 4 + 3];
+
+  // Gribb/Hartmann: each plane is row 3 of the clip matrix +/- row 0..2
+  for (int p = 0; p < 6; p++) {
+    int row = p / 2;
+    float sign = (p % 2 == 0) ? 1.0f : -1.0f;
+    for (int i = 0; i < 4; i++)
+      planes[p][i] = clip[i * 4 + 3] + sign * clip[i * 4 + row];
+    normalizePlane(planes[p]);
+  }
+
+  // Anything past the fog end is drawn in the flat fog colour anyway
+  if (maxDistance <= 0.0f && glIsEnabled(GL_FOG))
+    glGetFloatv(GL_FOG_END, &maxDistance);
+  // Far distance of a perspective projection: proj[14] / (proj[10] + 1)
+  float far = (proj[10] != -1.0f) ? proj[14] / (proj[10] + 1.0f) : 0.0f;
+  if (maxDistance > 0.0f && (far <= 0.0f || maxDistance < far)) {
+    // Eye-space -z <= maxDistance, i.e. eyeZ + maxDistance >= 0
+    planes[5][0] = mv[2];
+    planes[5][1] = mv[6];
+    planes[5][2] = mv[10];
+    planes[5][3] = mv[14] + maxDistance;
+    normalizePlane(planes[5]);
+  }
+  valid = true;
+}
+
+bool Frustum::sphereVisible(float x, float y, float z, float radius) const {
+  if (!enabled || !valid) {
+    visibleCount++;
+    return true;
+  }
+  for (int p = 0; p < 6; p++) {
+    if (planes[p][0] * x + planes[p][1] * y + planes[p][2] * z +
+            planes[p][3] <
+        -radius) {
+      culledCount++;
+      return false;
+    }
+  }
+  visibleCount++;
+  return true;
+}
+
+bool Frustum::boxVisible(float minX, float minY, float minZ, float maxX,
+                         float maxY, float maxZ) const {
+  if (!enabled || !valid) {
+    visibleCount++;
+    return true;
+  }
+  for (int p = 0; p < 6; p++) {
+    // The corner furthest along the plane normal
+    float x = planes[p][0] >= 0.0f ? maxX : minX;
+    float y = planes[p][1] >= 0.0f ? maxY : minY;
+    float z = planes[p][2] >= 0.0f ? maxZ : minZ;
+    if (planes[p][0] * x + planes[p][1] * y + planes[p][2] * z +
+            planes[p][3] <
+        0.0f) {
+      culledCount++;
+      return false;
+    }
+  }
+  visibleCount++;
+  return true;
+}
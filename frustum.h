@@ -0,0 +1,39 @@
+// ============================================================================
+// Frustum.h - View-Frustum Culling
+// Tests level entities against the camera's view volume, clipped at the fog
+// end, so off-screen and fully fogged draws can be skipped
+// ============================================================================
+
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+class Frustum {
+private:
+    // a*x + b*y + c*z + d >= 0 inside, normalized so d is a distance:
+    // left, right, bottom, top, near, far
+    float planes[6][4];
+    bool valid;
+
+public:
+    Frustum() : valid(false) {}
+
+    // Planes of the current GL projection * modelview (call after the camera
+    // is applied). The far plane is pulled in to maxDistance in eye space
+    // when that is closer; 0 uses the fog end while GL_FOG is on.
+    void extract(float maxDistance = 0.0f);
+
+    // Conservative: may keep a few invisible objects, never drops a visible
+    // one. Everything is visible before the first extract().
+    bool sphereVisible(float x, float y, float z, float radius) const;
+    bool boxVisible(float minX, float minY, float minZ, float maxX,
+                    float maxY, float maxZ) const;
+
+    // Culling is skipped (everything passes) while this is cleared
+    static bool enabled;
+    // Per-frame counts of tests that kept or skipped a draw
+    static int visibleCount;
+    static int culledCount;
+    static void resetCounts() { visibleCount = culledCount = 0; }
+};
+
+#endif // FRUSTUM_H
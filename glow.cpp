@@ -0,0 +1,122 @@
+// ============================================================================
+// Glow.cpp - Billboard Glow Sprites Implementation
+// ============================================================================
+
+#include "glow.h"
+#include <algorithm>
+#include <cmath>
+
+int GlowBatch::spriteCount = 0;
+
+void GlowBatch::add(float x, float y, float z, float halfWidth,
+                    float halfHeight, float r, float g, float b, float a) {
+  Sprite s;
+  s.x = x;
+  s.y = y;
+  s.z = z;
+  s.halfWidth = halfWidth;
+  s.halfHeight = halfHeight;
+  s.color[0] = r;
+  s.color[1] = g;
+  s.color[2] = b;
+  s.color[3] = a * 2.0f > 1.0f ? 1.0f : a * 2.0f;
+  s.depth = 0.0f;
+  sprites.push_back(s);
+}
+
+GLuint GlowBatch::texture() {
+  static GLuint id = 0;
+  if (id != 0)
+    return id;
+
+  // White with the alpha of a glowing ball's thickness along each ray:
+  // sqrt(1 - r^2), falling to 0 at the rim
+  const int size = 64;
+  std::vector<unsigned char> pixels(size * size * 4);
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      float dx = (x + 0.5f) / (size / 2) - 1.0f;
+      float dy = (y + 0.5f) / (size / 2) - 1.0f;
+      float t = 1.0f - (dx * dx + dy * dy);
+      unsigned char *p = &pixels[(y * size + x) * 4];
+      p[0] = p[1] = p[2] = 255;
+      p[3] = (unsigned char)(t > 0.0f ? sqrtf(t) * 255.0f + 0.5f : 0.0f);
+    }
+  }
+  glGenTextures(1, &id);
+  glBindTexture(GL_TEXTURE_2D, id);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size, size, 0, GL_RGBA,
+               GL_UNSIGNED_BYTE, pixels.data());
+  glBindTexture(GL_TEXTURE_2D, 0);
+  return id;
+}
+
+void GlowBatch::submit(RenderQueue &queue, float x, float y, float z) {
+  if (sprites.empty())
+    return;
+  queue.submit(RenderState(BLEND_ADDITIVE, false, texture()), x, y, z,
+               [this] { draw(); });
+}
+
+void GlowBatch::draw() {
+  if (sprites.empty())
+    return;
+
+  // Camera right and up in the current frame are the first two rows of
+  // the modelview's rotation
+  GLfloat m[16];
+  glGetFloatv(GL_MODELVIEW_MATRIX, m);
+  float right[3] = {m[0], m[4], m[8]};
+  float up[3] = {m[1], m[5], m[9]};
+  float rightLength = sqrtf(right[0] * right[0] + right[1] * right[1] +
+                            right[2] * right[2]);
+  float upLength = sqrtf(up[0] * up[0] + up[1] * up[1] + up[2] * up[2]);
+  for (int i = 0; i < 3; i++) {
+    right[i] /= rightLength > 0.0f ? rightLength : 1.0f;
+    up[i] /= upLength > 0.0f ? upLength : 1.0f;
+  }
+
+  for (Sprite &s : sprites)
+    s.depth = -(m[2] * s.x + m[6] * s.y + m[10] * s.z + m[14]);
+  std::sort(sprites.begin(), sprites.end(),
+            [](const Sprite &a, const Sprite &b) { return a.depth > b.depth; });
+
+  static const float corners[4][2] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+  vertices.resize(sprites.size() * 4);
+  GlowVertex *v = vertices.data();
+  for (const Sprite &s : sprites) {
+    for (const float *c : corners) {
+      float w = c[0] * s.halfWidth, h = c[1] * s.halfHeight;
+      v->position[0] = s.x + right[0] * w + up[0] * h;
+      v->position[1] = s.y + right[1] * w + up[1] * h;
+      v->position[2] = s.z + right[2] * w + up[2] * h;
+      v->uv[0] = (c[0] + 1.0f) * 0.5f;
+      v->uv[1] = (c[1] + 1.0f) * 0.5f;
+      for (int i = 0; i < 4; i++)
+        v->color[i] = s.color[i];
+      v++;
+    }
+  }
+
+  // Depth tested against the scene, but a glow must not hide the ones
+  // behind it
+  glDepthMask(GL_FALSE);
+  const GLsizei stride = sizeof(GlowVertex);
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+  glEnableClientState(GL_COLOR_ARRAY);
+  glVertexPointer(3, GL_FLOAT, stride, vertices[0].position);
+  glTexCoordPointer(2, GL_FLOAT, stride, vertices[0].uv);
+  glColorPointer(4, GL_FLOAT, stride, vertices[0].color);
+  glDrawArrays(GL_QUADS, 0, (GLsizei)vertices.size());
+  glDisableClientState(GL_COLOR_ARRAY);
+  glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+  glDisableClientState(GL_VERTEX_ARRAY);
+  glDepthMask(GL_TRUE);
+
+  spriteCount += (int)sprites.size();
+}
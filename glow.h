@@ -0,0 +1,54 @@
+// ============================================================================
+// Glow.h - Billboard Glow Sprites
+// Draws soft glows as camera-facing quads textured with a radial falloff,
+// all of a frame's glows in one blended draw
+// ============================================================================
+
+#ifndef GLOW_H
+#define GLOW_H
+
+#include "renderqueue.h"
+#include <vector>
+
+class GlowBatch {
+private:
+    struct Sprite {
+        float x, y, z;
+        float halfWidth, halfHeight;
+        float color[4];
+        float depth; // Along the view direction, set by draw()
+    };
+    struct GlowVertex {
+        float position[3];
+        float uv[2];
+        float color[4];
+    };
+    std::vector<Sprite> sprites;
+    std::vector<GlowVertex> vertices; // Rebuilt by every draw()
+
+public:
+    void clear() { sprites.clear(); }
+    // A glow standing in for a blended sphere (or ellipsoid) with these
+    // radii and colour. The quad is brightest in the middle, where the
+    // sphere's front and back faces both covered a pixel, so alpha is
+    // doubled there (clamped to 1).
+    void add(float x, float y, float z, float halfWidth, float halfHeight,
+             float r, float g, float b, float a);
+    bool empty() const { return sprites.empty(); }
+
+    // Queues every glow as one additive, unlit item sorted at x, y, z
+    void submit(RenderQueue& queue, float x, float y, float z);
+    // Draws the glows back to front, facing the camera of the current
+    // modelview, without writing depth. The caller sets blending, turns
+    // lighting off and binds texture().
+    void draw();
+
+    // Radial falloff shared by every glow, created on first use (GL thread)
+    static GLuint texture();
+
+    // Per-frame count of glows drawn
+    static int spriteCount;
+    static void resetCounts() { spriteCount = 0; }
+};
+
+#endif // GLOW_H
@@ -0,0 +1,512 @@
+// ============================================================================
+// Hud.cpp - Cached HUD Layer Implementation
+// ============================================================================
+
+#include "hud.h"
+#include "atlas.h"
+#include "model.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+// ============================================================================
+// GLYPH ATLAS
+// ============================================================================
+namespace {
+struct AtlasFont {
+  void *font;
+  int height;   // Cell height, enough for the font's ascent and descent
+  int baseline; // Baseline above the bottom of the cell
+};
+const AtlasFont atlasFonts[] = {{GLUT_BITMAP_HELVETICA_12, 18, 5},
+                                {GLUT_BITMAP_HELVETICA_18, 26, 7},
+                                {GLUT_BITMAP_TIMES_ROMAN_24, 34, 9}};
+const int fontCount = sizeof(atlasFonts) / sizeof(atlasFonts[0]);
+const int firstGlyph = 32; // Printable ASCII
+const int glyphCount = 95;
+const int atlasWidth = 512;
+const int glyphPadding = 2; // Pixels around the advance for overhanging ink
+const int whiteSize = 4;
+
+GlyphAtlas::Glyph glyphs[fontCount][glyphCount];
+GLuint atlasTexture = 0;
+} // namespace
+
+float GlyphAtlas::whiteU = 0.0f;
+float GlyphAtlas::whiteV = 0.0f;
+
+void GlyphAtlas::build() {
+  if (atlasTexture != 0)
+    return;
+
+  // Shelf-pack every cell after the white block
+  int cellX[fontCount][glyphCount], cellY[fontCount][glyphCount];
+  int x = whiteSize, y = 0, rowHeight = whiteSize;
+  for (int f = 0; f < fontCount; f++) {
+    for (int i = 0; i < glyphCount; i++) {
+      Glyph &g = glyphs[f][i];
+      g.advance = glutBitmapWidth(atlasFonts[f].font, firstGlyph + i);
+      g.width = g.advance + 2 * glyphPadding;
+      g.height = atlasFonts[f].height;
+      g.left = -glyphPadding;
+      g.bottom = -atlasFonts[f].baseline;
+      if (x + g.width > atlasWidth) {
+        x = 0;
+        y += rowHeight;
+        rowHeight = 0;
+      }
+      cellX[f][i] = x;
+      cellY[f][i] = y;
+      x += g.width;
+      if (g.height > rowHeight)
+        rowHeight = g.height;
+    }
+  }
+  int height = 1;
+  while (height < y + rowHeight)
+    height *= 2;
+
+  // Rasterize in white on black at the bottom left of the back buffer
+  glPushAttrib(GL_ALL_ATTRIB_BITS);
+  glViewport(0, 0, atlasWidth, height);
+  glMatrixMode(GL_PROJECTION);
+  glPushMatrix();
+  glLoadIdentity();
+  gluOrtho2D(0, atlasWidth, 0, height);
+  glMatrixMode(GL_MODELVIEW);
+  glPushMatrix();
+  glLoadIdentity();
+  glDisable(GL_LIGHTING);
+  glDisable(GL_DEPTH_TEST);
+  glDisable(GL_BLEND);
+  glDisable(GL_TEXTURE_2D);
+  glDisable(GL_FOG);
+  glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+  glClear(GL_COLOR_BUFFER_BIT);
+  glColor3f(1.0f, 1.0f, 1.0f);
+  glRecti(0, 0, whiteSize, whiteSize);
+  for (int f = 0; f < fontCount; f++) {
+    for (int i = 0; i < glyphCount; i++) {
+      glRasterPos2i(cellX[f][i] + glyphPadding,
+                    cellY[f][i] + atlasFonts[f].baseline);
+      glutBitmapCharacter(atlasFonts[f].font, firstGlyph + i);
+    }
+  }
+  std::vector<unsigned char> alpha(atlasWidth * height);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadBuffer(GL_BACK);
+  glReadPixels(0, 0, atlasWidth, height, GL_RED, GL_UNSIGNED_BYTE,
+               alpha.data());
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glClear(GL_COLOR_BUFFER_BIT);
+  glPopMatrix();
+  glMatrixMode(GL_PROJECTION);
+  glPopMatrix();
+  glPopAttrib();
+
+  for (int f = 0; f < fontCount; f++) {
+    for (int i = 0; i < glyphCount; i++) {
+      Glyph &g = glyphs[f][i];
+      g.u0 = (float)cellX[f][i] / atlasWidth;
+      g.v0 = (float)cellY[f][i] / height;
+      g.u1 = (float)(cellX[f][i] + g.width) / atlasWidth;
+      g.v1 = (float)(cellY[f][i] + g.height) / height;
+      g.blank = true;
+      for (int row = 0; row < g.height && g.blank; row++) {
+        const unsigned char *p =
+            &alpha[(cellY[f][i] + row) * atlasWidth + cellX[f][i]];
+        for (int col = 0; col < g.width; col++)
+          if (p[col] != 0)
+            g.blank = false;
+      }
+    }
+  }
+  whiteU = 0.5f * whiteSize / atlasWidth;
+  whiteV = 0.5f * whiteSize / height;
+
+  // Glyph pixels map one to one onto window pixels
+  glGenTextures(1, &atlasTexture);
+  glBindTexture(GL_TEXTURE_2D, atlasTexture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, atlasWidth, height, 0, GL_ALPHA,
+               GL_UNSIGNED_BYTE, alpha.data());
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+GLuint GlyphAtlas::texture() { return atlasTexture; }
+
+const GlyphAtlas::Glyph *GlyphAtlas::glyph(void *font, unsigned char c) {
+  if (atlasTexture == 0 || c < firstGlyph || c >= firstGlyph + glyphCount)
+    return nullptr;
+  for (int f = 0; f < fontCount; f++)
+    if (atlasFonts[f].font == font)
+      return &glyphs[f][c - firstGlyph];
+  return nullptr;
+}
+
+// ============================================================================
+// STROKE FONT
+// ============================================================================
+static void captureStrokeGlyphs(StrokeFont::Glyph *glyphs) {
+  // Feedback reports window coordinates: map stroke units 1:1 onto a
+  // viewport with room for any glyph's descender and overhang
+  const float margin = 64.0f;
+  const GLsizei span = 256;
+  glPushAttrib(GL_VIEWPORT_BIT | GL_TRANSFORM_BIT);
+  glViewport(0, 0, span, span);
+  glMatrixMode(GL_PROJECTION);
+  glPushMatrix();
+  glLoadIdentity();
+  gluOrtho2D(-margin, span - margin, -margin, span - margin);
+  glMatrixMode(GL_MODELVIEW);
+  glPushMatrix();
+
+  std::vector<GLfloat> feedback(2048);
+  for (int i = 0; i < glyphCount; i++) {
+    GLint size;
+    while (true) {
+      glLoadIdentity();
+      glFeedbackBuffer((GLsizei)feedback.size(), GL_2D, feedback.data());
+      glRenderMode(GL_FEEDBACK);
+      glutStrokeCharacter(GLUT_STROKE_ROMAN, firstGlyph + i);
+      size = glRenderMode(GL_RENDER);
+      if (size >= 0)
+        break;
+      feedback.resize(feedback.size() * 2); // Overflowed
+    }
+
+    StrokeFont::Glyph &g = glyphs[i];
+    g.advance = (float)glutStrokeWidth(GLUT_STROKE_ROMAN, firstGlyph + i);
+    for (GLint j = 0; j < size;) {
+      GLint token = (GLint)feedback[j++];
+      if (token == GL_LINE_TOKEN || token == GL_LINE_RESET_TOKEN) {
+        for (int k = 0; k < 4; k++)
+          g.lines.push_back(feedback[j + k] - margin);
+        j += 4;
+      } else if (token == GL_POLYGON_TOKEN) {
+        j += 1 + 2 * (GLint)feedback[j];
+      } else if (token == GL_PASS_THROUGH_TOKEN) {
+        j += 1;
+      } else {
+        j += 2; // Point, bitmap and pixel tokens carry one vertex
+      }
+    }
+  }
+
+  glPopMatrix();
+  glMatrixMode(GL_PROJECTION);
+  glPopMatrix();
+  glPopAttrib();
+}
+
+const StrokeFont::Glyph &StrokeFont::glyph(unsigned char c) {
+  static Glyph glyphs[glyphCount];
+  static bool captured = false;
+  if (!captured) {
+    captureStrokeGlyphs(glyphs);
+    captured = true;
+  }
+  if (c < firstGlyph || c >= firstGlyph + glyphCount)
+    c = ' ';
+  return glyphs[c - firstGlyph];
+}
+
+void StrokeLabel::set(const char *newText, float newSpacing) {
+  if (text == newText && spacing == newSpacing)
+    return;
+  text = newText;
+  spacing = newSpacing;
+  lines.clear();
+  float pen = 0.0f;
+  for (unsigned char c : text) {
+    const StrokeFont::Glyph &g = StrokeFont::glyph(c);
+    for (size_t i = 0; i < g.lines.size(); i += 2) {
+      lines.push_back(pen + g.lines[i]);
+      lines.push_back(g.lines[i + 1]);
+    }
+    pen += spacing > 0.0f ? spacing : g.advance;
+  }
+}
+
+void StrokeLabel::draw() const {
+  if (lines.empty())
+    return;
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glVertexPointer(2, GL_FLOAT, 0, lines.data());
+  glDrawArrays(GL_LINES, 0, (GLsizei)(lines.size() / 2));
+  glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+// ============================================================================
+// HUD WIDGET
+// ============================================================================
+HudWidget::HudWidget() {
+  current[0] = current[1] = current[2] = current[3] = 255;
+}
+
+void HudWidget::clear() {
+  triangles.clear();
+  lines.clear();
+  current[0] = current[1] = current[2] = current[3] = 255;
+}
+
+static unsigned char toByte(float value) {
+  value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+  return (unsigned char)(value * 255.0f + 0.5f);
+}
+
+void HudWidget::color(float r, float g, float b, float a) {
+  current[0] = toByte(r);
+  current[1] = toByte(g);
+  current[2] = toByte(b);
+  current[3] = toByte(a);
+}
+
+void HudWidget::vertex(std::vector<HudVertex> &list, float x, float y,
+                       float u, float v, const unsigned char *color) {
+  HudVertex vertex;
+  vertex.position[0] = x;
+  vertex.position[1] = y;
+  vertex.uv[0] = u;
+  vertex.uv[1] = v;
+  memcpy(vertex.color, color, 4);
+  list.push_back(vertex);
+}
+
+void HudWidget::quad(float x0, float y0, float x1, float y1, float u0,
+                     float v0, float u1, float v1) {
+  vertex(triangles, x0, y0, u0, v0, current);
+  vertex(triangles, x1, y0, u1, v0, current);
+  vertex(triangles, x1, y1, u1, v1, current);
+  vertex(triangles, x0, y0, u0, v0, current);
+  vertex(triangles, x1, y1, u1, v1, current);
+  vertex(triangles, x0, y1, u0, v1, current);
+}
+
+void HudWidget::rect(float x0, float y0, float x1, float y1) {
+  float u = GlyphAtlas::whiteU, v = GlyphAtlas::whiteV;
+  quad(x0, y0, x1, y1, u, v, u, v);
+}
+
+void HudWidget::gradientRect(float x0, float y0, float x1, float y1, float r,
+                             float g, float b, float a) {
+  unsigned char top[4] = {toByte(r), toByte(g), toByte(b), toByte(a)};
+  float u = GlyphAtlas::whiteU, v = GlyphAtlas::whiteV;
+  vertex(triangles, x0, y0, u, v, current);
+  vertex(triangles, x1, y0, u, v, current);
+  vertex(triangles, x1, y1, u, v, top);
+  vertex(triangles, x0, y0, u, v, current);
+  vertex(triangles, x1, y1, u, v, top);
+  vertex(triangles, x0, y1, u, v, top);
+}
+
+void HudWidget::outline(float x0, float y0, float x1, float y1,
+                        float width) {
+  float h = width * 0.5f;
+  rect(x0 - h, y0 - h, x1 + h, y0 + h); // Bottom
+  rect(x0 - h, y1 - h, x1 + h, y1 + h); // Top
+  rect(x0 - h, y0 + h, x0 + h, y1 - h); // Left
+  rect(x1 - h, y0 + h, x1 + h, y1 - h); // Right
+}
+
+void HudWidget::triangle(float x0, float y0, float x1, float y1, float x2,
+                         float y2) {
+  float u = GlyphAtlas::whiteU, v = GlyphAtlas::whiteV;
+  vertex(triangles, x0, y0, u, v, current);
+  vertex(triangles, x1, y1, u, v, current);
+  vertex(triangles, x2, y2, u, v, current);
+}
+
+void HudWidget::text(float x, float y, const char *text, void *font) {
+  for (const char *c = text; *c != '\0'; c++) {
+    const GlyphAtlas::Glyph *g = GlyphAtlas::glyph(font, (unsigned char)*c);
+    if (g == nullptr)
+      continue;
+    if (!g->blank)
+      quad(x + g->left, y + g->bottom, x + g->left + g->width,
+           y + g->bottom + g->height, g->u0, g->v0, g->u1, g->v1);
+    x += g->advance;
+  }
+}
+
+void HudWidget::strokeText(float x, float y, float scale, const char *text) {
+  float pen = 0.0f;
+  for (const char *c = text; *c != '\0'; c++) {
+    const StrokeFont::Glyph &g = StrokeFont::glyph((unsigned char)*c);
+    for (size_t i = 0; i < g.lines.size(); i += 2)
+      vertex(lines, x + (pen + g.lines[i]) * scale, y + g.lines[i + 1] * scale,
+             0.0f, 0.0f, current);
+    pen += g.advance;
+  }
+}
+
+// ============================================================================
+// HUD LAYER
+// ============================================================================
+int HudLayer::rebuiltCount = 0;
+int HudLayer::drawCalls = 0;
+int HudLayer::vertexCount = 0;
+double HudLayer::cpuMs = 0.0;
+
+HudLayer::HudLayer() : uploaded(false) { buffers[0] = buffers[1] = 0; }
+
+HudLayer::~HudLayer() {
+  if (buffers[0] != 0)
+    glDeleteBuffers(2, buffers);
+}
+
+void HudLayer::begin() {
+  frameStart = std::chrono::steady_clock::now();
+  for (Slot &slot : slots) {
+    slot.wasVisible = slot.visible;
+    slot.visible = false;
+    slot.changed = false;
+  }
+}
+
+HudWidget *HudLayer::widget(int id, long long key) {
+  if (id >= (int)slots.size())
+    slots.resize(id + 1);
+  Slot &slot = slots[id];
+  slot.visible = true;
+  if (slot.built && slot.key == key)
+    return nullptr;
+  slot.key = key;
+  slot.built = true;
+  slot.changed = true;
+  slot.widget.clear();
+  rebuiltCount++;
+  return &slot.widget;
+}
+
+void HudLayer::upload(bool relayout) {
+  bool useBuffers = Model::useVertexBuffers && Model::vertexBuffersSupported();
+  if (useBuffers && buffers[0] == 0)
+    glGenBuffers(2, buffers);
+
+  if (relayout) {
+    // Widgets appeared, disappeared or changed size: repack everything
+    triangles.clear();
+    lines.clear();
+    for (Slot &slot : slots) {
+      if (!slot.visible)
+        continue;
+      slot.triangleFirst = triangles.size();
+      slot.triangleCount = slot.widget.triangles.size();
+      slot.lineFirst = lines.size();
+      slot.lineCount = slot.widget.lines.size();
+      triangles.insert(triangles.end(), slot.widget.triangles.begin(),
+                       slot.widget.triangles.end());
+      lines.insert(lines.end(), slot.widget.lines.begin(),
+                   slot.widget.lines.end());
+    }
+    if (useBuffers) {
+      glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+      glBufferData(GL_ARRAY_BUFFER, triangles.size() * sizeof(HudVertex),
+                   triangles.data(), GL_DYNAMIC_DRAW);
+      glBindBuffer(GL_ARRAY_BUFFER, buffers[1]);
+      glBufferData(GL_ARRAY_BUFFER, lines.size() * sizeof(HudVertex),
+                   lines.data(), GL_DYNAMIC_DRAW);
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    return;
+  }
+
+  // Same layout: overwrite the ranges of the widgets that were rebuilt
+  for (Slot &slot : slots) {
+    if (!slot.visible || !slot.changed)
+      continue;
+    std::copy(slot.widget.triangles.begin(), slot.widget.triangles.end(),
+              triangles.begin() + slot.triangleFirst);
+    std::copy(slot.widget.lines.begin(), slot.widget.lines.end(),
+              lines.begin() + slot.lineFirst);
+    if (!useBuffers)
+      continue;
+    if (slot.triangleCount > 0) {
+      glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+      glBufferSubData(GL_ARRAY_BUFFER,
+                      slot.triangleFirst * sizeof(HudVertex),
+                      slot.triangleCount * sizeof(HudVertex),
+                      &triangles[slot.triangleFirst]);
+    }
+    if (slot.lineCount > 0) {
+      glBindBuffer(GL_ARRAY_BUFFER, buffers[1]);
+      glBufferSubData(GL_ARRAY_BUFFER, slot.lineFirst * sizeof(HudVertex),
+                      slot.lineCount * sizeof(HudVertex),
+                      &lines[slot.lineFirst]);
+    }
+  }
+  if (useBuffers)
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void HudLayer::drawList(GLenum mode, GLuint buffer,
+                        const std::vector<HudVertex> &list) {
+  if (list.empty())
+    return;
+  const char *base = (const char *)list.data();
+  if (buffer != 0 && Model::useVertexBuffers &&
+      Model::vertexBuffersSupported()) {
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    base = nullptr;
+  }
+  const GLsizei stride = sizeof(HudVertex);
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+  glEnableClientState(GL_COLOR_ARRAY);
+  glVertexPointer(2, GL_FLOAT, stride, base + offsetof(HudVertex, position));
+  glTexCoordPointer(2, GL_FLOAT, stride, base + offsetof(HudVertex, uv));
+  glColorPointer(4, GL_UNSIGNED_BYTE, stride,
+                 base + offsetof(HudVertex, color));
+  glDrawArrays(mode, 0, (GLsizei)list.size());
+  glDisableClientState(GL_COLOR_ARRAY);
+  glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+  glDisableClientState(GL_VERTEX_ARRAY);
+  if (base == nullptr)
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  drawCalls++;
+  vertexCount += (int)list.size();
+}
+
+void HudLayer::draw() {
+  bool relayout = !uploaded;
+  bool changed = relayout;
+  for (const Slot &slot : slots) {
+    if (slot.visible != slot.wasVisible)
+      relayout = true;
+    if (slot.visible && slot.changed) {
+      changed = true;
+      if (slot.widget.triangles.size() != slot.triangleCount ||
+          slot.widget.lines.size() != slot.lineCount)
+        relayout = true;
+    }
+  }
+  if (relayout || changed)
+    upload(relayout);
+  uploaded = true;
+
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+  // Stroke text sits under the panels and full-screen fades
+  glDisable(GL_TEXTURE_2D);
+  glLineWidth(3.0f);
+  drawList(GL_LINES, buffers[1], lines);
+  glLineWidth(1.0f);
+
+  glEnable(GL_TEXTURE_2D);
+  bindTexture(GlyphAtlas::texture());
+  drawList(GL_TRIANGLES, buffers[0], triangles);
+  glDisable(GL_TEXTURE_2D);
+  glDisable(GL_BLEND);
+
+  cpuMs += std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - frameStart)
+               .count();
+}
@@ -0,0 +1,170 @@
+// ============================================================================
+// Hud.h - Cached HUD Layer
+// Text comes from a glyph atlas and every HUD widget is kept as vertices
+// that are rebuilt only when the value it shows changes; the whole HUD is
+// one line draw and one textured triangle draw
+// ============================================================================
+
+#ifndef HUD_H
+#define HUD_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+#ifdef __APPLE__
+#include <GLUT/glut.h>
+#else
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES // glGenBuffers & co. live in glext.h on Mesa
+#endif
+#include <GL/glut.h>
+#endif
+
+// The GLUT bitmap fonts (Helvetica 12 and 18, Times Roman 24) rasterized
+// once into one alpha texture, with a white block for untextured fills
+class GlyphAtlas {
+public:
+    struct Glyph {
+        float u0, v0, u1, v1; // Cell in the atlas
+        int left, bottom;     // Cell corner relative to the pen on the baseline
+        int width, height;    // Cell size in pixels
+        int advance;
+        bool blank;           // No pixels set (space)
+    };
+
+    // Draws the glyphs through GLUT into the back buffer and reads them
+    // back, so call it before a frame is drawn (GL thread). Does nothing
+    // once built.
+    static void build();
+    static GLuint texture(); // 0 before build()
+    // nullptr before build() and for fonts not in the atlas
+    static const Glyph* glyph(void* font, unsigned char c);
+    // Texture coordinates of a fully opaque texel
+    static float whiteU, whiteV;
+};
+
+// GLUT_STROKE_ROMAN glyphs as line lists, captured once through GL
+// feedback instead of being re-issued as line strips every frame
+class StrokeFont {
+public:
+    struct Glyph {
+        std::vector<float> lines; // x, y per line end, in stroke units
+        float advance;
+    };
+    // Captured on first use (GL thread, draws nothing)
+    static const Glyph& glyph(unsigned char c);
+};
+
+// A line of stroke text kept as one line list, rebuilt when its text
+// changes
+class StrokeLabel {
+private:
+    std::string text;
+    float spacing;
+    std::vector<float> lines;
+
+public:
+    StrokeLabel() : spacing(0.0f) {}
+    // Glyphs are spaced by their own width, or every spacing units
+    void set(const char* text, float spacing = 0.0f);
+    // One line draw at the origin, in stroke units and the current colour
+    void draw() const;
+};
+
+struct HudVertex {
+    float position[2];
+    float uv[2];
+    unsigned char color[4];
+};
+
+// Vertices of one HUD element in window pixels (origin bottom left),
+// built through the calls below
+class HudWidget {
+private:
+    friend class HudLayer;
+    std::vector<HudVertex> triangles;
+    std::vector<HudVertex> lines;
+    unsigned char current[4];
+
+    void vertex(std::vector<HudVertex>& list, float x, float y, float u,
+                float v, const unsigned char* color);
+    void quad(float x0, float y0, float x1, float y1, float u0, float v0,
+              float u1, float v1);
+
+public:
+    HudWidget();
+    void clear();
+
+    void color(float r, float g, float b, float a = 1.0f);
+    void rect(float x0, float y0, float x1, float y1);
+    // Current colour along y0 fading to r, g, b, a along y1
+    void gradientRect(float x0, float y0, float x1, float y1, float r,
+                      float g, float b, float a);
+    // A line loop around the rectangle, width pixels wide
+    void outline(float x0, float y0, float x1, float y1, float width);
+    void triangle(float x0, float y0, float x1, float y1, float x2, float y2);
+    // Bitmap text from the glyph atlas with the pen starting at x on the
+    // baseline y, like glRasterPos + glutBitmapCharacter
+    void text(float x, float y, const char* text,
+              void* font = GLUT_BITMAP_HELVETICA_18);
+    // GLUT_STROKE_ROMAN text, stroke units scaled by scale, drawn as lines
+    // three pixels wide
+    void strokeText(float x, float y, float scale, const char* text);
+};
+
+// The HUD's widgets, each rebuilt only when its key changes, drawn in id
+// order from one buffer per primitive type
+class HudLayer {
+private:
+    struct Slot {
+        HudWidget widget;
+        long long key;
+        bool built;
+        bool visible, wasVisible;
+        bool changed;
+        size_t triangleFirst, triangleCount;
+        size_t lineFirst, lineCount;
+        Slot()
+            : key(0), built(false), visible(false), wasVisible(false),
+              changed(false), triangleFirst(0), triangleCount(0),
+              lineFirst(0), lineCount(0) {}
+    };
+    std::vector<Slot> slots;
+    std::vector<HudVertex> triangles; // Every visible widget, as uploaded
+    std::vector<HudVertex> lines;
+    GLuint buffers[2]; // Triangles, lines
+    bool uploaded;
+    std::chrono::steady_clock::time_point frameStart;
+
+    void upload(bool relayout);
+    void drawList(GLenum mode, GLuint buffer,
+                  const std::vector<HudVertex>& list);
+
+public:
+    HudLayer();
+    ~HudLayer();
+    HudLayer(const HudLayer&) = delete;
+    HudLayer& operator=(const HudLayer&) = delete;
+
+    void begin();
+    // The widget to rebuild, cleared, when key differs from the one it was
+    // last built for, else nullptr. Widgets not asked for between begin()
+    // and draw() are hidden that frame.
+    HudWidget* widget(int id, long long key);
+    // Uploads what changed and draws every visible widget in the current
+    // window-pixel projection, lines first
+    void draw();
+
+    // Per-frame HUD cost: widgets rebuilt, draw calls, vertices drawn and
+    // CPU time from begin() to the end of draw()
+    static int rebuiltCount;
+    static int drawCalls;
+    static int vertexCount;
+    static double cpuMs;
+    static void resetCounts() {
+        rebuiltCount = drawCalls = vertexCount = 0;
+        cpuMs = 0.0;
+    }
+};
+
+#endif // HUD_H
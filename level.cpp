@@ -4,60 +4,94 @@
 // ============================================================================
 
 #include "level.h"
+#include "assets.h"
 #include "camera.h" // Added for camera shake
+#include "primitives.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
 
 #define PI 3.14159265359f
 
 // ============================================================================
-// BASE LEVEL CLASS
+// INSTANCE CLUSTERS
 // ============================================================================
 
-// Initialize static members
-Model *Level::pillarModel = nullptr;
-Model *Level::snowmanModel = nullptr;
-Model *Level::christmasTreeModel = nullptr;
-Model *Level::snakeModel = nullptr;
-Model *Level::trapModel = nullptr;
-Model *Level::chestModel = nullptr;
-
-void Level::cleanupCommonAssets() {
-  if (pillarModel) {
-    delete pillarModel;
-    pillarModel = nullptr;
-  }
-  if (snowmanModel) {
-    delete snowmanModel;
-    snowmanModel = nullptr;
-  }
-  if (christmasTreeModel) {
-    delete christmasTreeModel;
-    christmasTreeModel = nullptr;
-  }
-  if (snakeModel) {
-    delete snakeModel;
-    snakeModel = nullptr;
-  }
-  if (trapModel) {
-    delete trapModel;
-    trapModel = nullptr;
+void InstanceClusters::clear() {
+  for (size_t i = 0; i < used; i++) {
+    clusters[i].transforms.clear();
+    clusters[i].bounds.clear();
   }
-  if (chestModel) {
-    delete chestModel;
-    chestModel = nullptr;
+  used = 0;
+}
+
+void InstanceClusters::add(const Transform &transform, float x, float y,
+                           float z, float radius) {
+  int cx = (int)floorf(x / LightManager::cellSize);
+  int cz = (int)floorf(z / LightManager::cellSize);
+  size_t i = 0;
+  while (i < used && (clusters[i].cx != cx || clusters[i].cz != cz))
+    i++;
+  if (i == used) {
+    if (used == clusters.size())
+      clusters.push_back(Cluster());
+    clusters[i].cx = cx;
+    clusters[i].cz = cz;
+    used++;
+  }
+  clusters[i].transforms.push_back(transform);
+  float bounds[] = {x, y, z, radius};
+  clusters[i].bounds.insert(clusters[i].bounds.end(), bounds, bounds + 4);
+}
+
+void InstanceClusters::submit(
+    RenderQueue &queue, const RenderState &state,
+    std::function<void(const Transform *, size_t)> draw) const {
+  for (size_t i = 0; i < used; i++) {
+    const Cluster &cluster = clusters[i];
+    size_t count = cluster.transforms.size();
+    float center[3] = {0.0f, 0.0f, 0.0f};
+    for (size_t k = 0; k < count; k++)
+      for (int axis = 0; axis < 3; axis++)
+        center[axis] += cluster.bounds[k * 4 + axis] / count;
+    float radius = 0.0f;
+    for (size_t k = 0; k < count; k++) {
+      const float *b = &cluster.bounds[k * 4];
+      float dx = b[0] - center[0], dy = b[1] - center[1],
+            dz = b[2] - center[2];
+      radius = std::max(radius, sqrtf(dx * dx + dy * dy + dz * dz) + b[3]);
+    }
+    const Transform *transforms = cluster.transforms.data();
+    queue.submit(state, center[0], center[1], center[2], radius,
+                 [=] { draw(transforms, count); });
   }
 }
 
+// ============================================================================
+// BASE LEVEL CLASS
+// ============================================================================
+
 Level::Level() {
   player = nullptr;
   portal = nullptr;
   levelComplete = false;
   isExiting = false;
   exitTimer = 0.0f;
+  queue.setLights(&lights);
+  prepareStarted = false;
+  rebakePending = false;
+  textureBatch = nullptr;
+  surfacesChanged = false;
+  bakeMs = 0.0;
+  bakeWaitMs = 0.0;
+  uploadMs = 0.0;
 }
 
 Level::~Level() {
+  waitForBake();
+  delete textureBatch; // Waits for in-flight decodes
   if (portal)
     delete portal;
   for (auto c : collectibles)
@@ -71,171 +105,398 @@ Level::~Level() {
   for (auto t : torches)
     delete t;
 
-  // Instance models are deleted here
-  if (treeModel) {
-    delete treeModel;
-    treeModel = nullptr;
-  }
-  if (rockModel) {
-    delete rockModel;
-    rockModel = nullptr;
-  }
-  if (groundModel) {
-    delete groundModel;
-    groundModel = nullptr;
-  }
-  if (cactusModel) {
-    delete cactusModel;
-    cactusModel = nullptr;
-  }
+  // The model and texture handles go back to the registry, which keeps
+  // the assets loaded for the next level and restarts
+}
 
-  // STATIC models (pillarModel, etc.) are managed by cleanupCommonAssets()
-  // Do NOT delete them here, or they will be double-freed on restart
+static double msSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
 }
 
-void Level::loadCommonAssets() {
-  // Initialize models if they don't exist
-  if (!pillarModel) {
-    pillarModel = new Model();
-    pillarModel->load("assets/pillar.obj");
-  }
-  if (!snowmanModel) {
-    snowmanModel = new Model();
-    snowmanModel->load("assets/snowman.obj");
-  }
-  if (!christmasTreeModel) {
-    christmasTreeModel = new Model();
-    christmasTreeModel->load("assets/christmasTree.obj");
-  }
-  if (!snakeModel) {
-    snakeModel = new Model();
-    snakeModel->load("assets/snake.obj");
-  }
-  if (!trapModel) {
-    trapModel = new Model();
-    trapModel->load("assets/traps.obj");
-  }
-  if (!chestModel) {
-    chestModel = new Model();
-    chestModel->load("assets/chest.obj");
+void Level::prepare() {
+  if (prepareStarted)
+    return;
+  prepareStarted = true;
+  setup();
+  captureSceneryMeshes();
+  bakeJob = ThreadPool::shared().submit([this] {
+    auto start = std::chrono::steady_clock::now();
+    bake();
+    bakeMs = msSince(start);
+  });
+}
+
+bool Level::isPrepared() const {
+  return bakeJob.valid() && bakeJob.wait_for(std::chrono::seconds(0)) ==
+                                std::future_status::ready;
+}
+
+void Level::waitForBake() {
+  if (bakeJob.valid())
+    bakeJob.wait();
+  if (rebakeJob.valid())
+    rebakeJob.wait();
+}
+
+void Level::finishPreparing() {
+  prepare();
+  auto waitStart = std::chrono::steady_clock::now();
+  if (bakeJob.valid())
+    bakeJob.get();
+  bakeWaitMs = msSince(waitStart);
+
+  auto uploadStart = std::chrono::steady_clock::now();
+  staticGeometry.upload();
+  uploadMs = msSince(uploadStart);
+  bakedModels.clear();
+  for (const SceneryMesh &mesh : bakedMeshes)
+    bakedModels.push_back(mesh.model);
+  // Scenery that streamed in while this level was being prepared
+  rebakePending = true;
+  printf("%s static geometry: %zu triangles in %zu groups, %zu vertices "
+         "light-baked (bake %.1f ms on the pool, upload %.1f ms)\n",
+         isDesert() ? "Desert" : "Ice", staticGeometry.getTriangleCount(),
+         staticGeometry.getGroupCount(), staticGeometry.getBakedVertexCount(),
+         bakeMs, uploadMs);
+}
+
+// Per instance; denser scenery is baked from its first LOD under this
+static const size_t maxSceneryTriangles = 8192;
+
+bool Level::captureSceneryMeshes() {
+  bool captured = false;
+  for (const Model *model : sceneryModels()) {
+    if (!model)
+      continue;
+    bool known = false;
+    for (const SceneryMesh &mesh : bakedMeshes)
+      known = known || mesh.model == model;
+    if (known)
+      continue;
+    SceneryMesh mesh;
+    mesh.model = model;
+    if (!model->getMesh(maxSceneryTriangles, mesh.vertices, mesh.indices))
+      continue; // Still streaming
+    bakedMeshes.push_back(std::move(mesh));
+    captured = true;
+  }
+  return captured;
+}
+
+const Level::SceneryMesh *
+Level::findSceneryMesh(const ModelHandle &model) const {
+  for (const SceneryMesh &mesh : bakedMeshes)
+    if (model && mesh.model == model.get())
+      return &mesh;
+  return nullptr;
+}
+
+bool Level::isBaked(const ModelHandle &model) const {
+  return model && std::find(bakedModels.begin(), bakedModels.end(),
+                            model.get()) != bakedModels.end();
+}
+
+void Level::updateRebake() {
+  if (rebakeJob.valid()) {
+    if (rebakeJob.wait_for(std::chrono::seconds(0)) !=
+        std::future_status::ready)
+      return;
+    rebakeJob.get();
+    rebuiltGeometry.upload();
+    staticGeometry.swap(rebuiltGeometry);
+    rebuiltGeometry.release();
+    bakedModels.clear();
+    for (const SceneryMesh &mesh : bakedMeshes)
+      bakedModels.push_back(mesh.model);
+    printf("%s static geometry re-baked with %zu scenery models: %zu "
+           "triangles\n",
+           isDesert() ? "Desert" : "Ice", bakedModels.size(),
+           staticGeometry.getTriangleCount());
+  }
+  // bakedMeshes only changes while no bake job reads it
+  if (!rebakePending || (bakeJob.valid() && !isPrepared()))
+    return;
+  rebakePending = false;
+  if (!captureSceneryMeshes() && !surfacesChanged)
+    return;
+  surfacesChanged = false;
+  LightSource sun = sunLight; // The desert sun keeps moving meanwhile
+  rebakeJob = ThreadPool::shared().submit(
+      [this, sun] { bakeStaticGeometry(rebuiltGeometry, sun); });
+}
+
+void Level::updateAssets() {
+  if (!textureBatch || !textureBatch->isDecoded())
+    return;
+  // The bake reads the surfaces, so they only change between bakes
+  if (bakeJob.valid() || rebakeJob.valid())
+    return;
+  textureBatch->finish();
+  delete textureBatch;
+  textureBatch = nullptr;
+  acquireTextures();
+  surfacesChanged = true;
+  rebakePending = true;
+}
+
+void Level::queueCommonAssets(AssetBatch &batch) {
+  batch.addModel("assets/pillar.obj", true, true);
+  batch.addModel("assets/snowman.obj", true, true);
+  batch.addModel("assets/christmasTree.obj", true, true);
+  batch.addModel("assets/snake.obj");
+  batch.addModel("assets/traps.obj");
+  batch.addModel("assets/chest.obj");
+  batch.addModel("assets/tree.obj", true, true);
+  batch.addModel("assets/rock.obj", false, true);
+  batch.addModel("assets/ground.obj");
+  batch.addModel("assets/cactus.obj", true, true);
+  batch.addTexture("assets/wall.bmp");
+  batch.addTexture("assets/ground.bmp");
+}
+
+void Level::loadCommonAssets(void (*queueAssets)(AssetBatch &batch)) {
+  // Decode everything this level needs on the worker pool first; the
+  // acquire calls below then find the assets resident. Streaming loads
+  // already decode on the pool and must not block here.
+  if (!Model::streaming) {
+    AssetBatch batch;
+    queueAssets(batch);
+    batch.finish();
+  }
+
+  // Scenery meshes that are instanced many times get a LOD chain, and those
+  // baked into the static geometry (sceneryModels()) keep their CPU copy
+  // for it; the registry shares the loaded data between levels
+  pillarModel = AssetRegistry::acquireModel("assets/pillar.obj", true, true);
+  snowmanModel =
+      AssetRegistry::acquireModel("assets/snowman.obj", true, true);
+  christmasTreeModel =
+      AssetRegistry::acquireModel("assets/christmasTree.obj", true, true);
+  snakeModel = AssetRegistry::acquireModel("assets/snake.obj");
+  trapModel = AssetRegistry::acquireModel("assets/traps.obj");
+  chestModel = AssetRegistry::acquireModel("assets/chest.obj");
+  treeModel = AssetRegistry::acquireModel("assets/tree.obj", true, true);
+  rockModel = AssetRegistry::acquireModel("assets/rock.obj", false, true);
+  groundModel = AssetRegistry::acquireModel("assets/ground.obj");
+  cactusModel = AssetRegistry::acquireModel("assets/cactus.obj", true, true);
+
+  // Streaming leaves the textures to a batch of their own (the models above
+  // are registered, so it skips them). Until it is in, the surfaces are
+  // baked untextured.
+  if (Model::streaming) {
+    textureBatch = new AssetBatch();
+    queueAssets(*textureBatch);
+    if (textureBatch->size() > 0) {
+      textureBatch->start();
+      return;
+    }
+    delete textureBatch; // Prefetched
+    textureBatch = nullptr;
   }
+  acquireTextures();
+}
 
-  // Load non-static models
-  treeModel = new Model();
-  rockModel = new Model();
-  groundModel = new Model();
-  cactusModel = new Model();
+void Level::acquireTextures() {
+  wallTexture = AssetRegistry::acquireTexture("assets/wall.bmp");
+  groundTexture = AssetRegistry::acquireTexture("assets/ground.bmp");
+}
 
-  treeModel->load("assets/tree.obj");
-  if (!rockModel->load("assets/rock.obj")) {
-    printf("Failed to load rock model\n");
+void Level::loadSurfaceTextures(const char *groundPath, const char *wallPath,
+                                TextureHandle &ground, TextureHandle &wall) {
+  if (TextureAtlas::enabled) {
+    surfaceAtlas = AssetRegistry::acquireAtlas({groundPath, wallPath});
+    if (surfaceAtlas->id != 0) {
+      groundSurface = surfaceAtlas.getRegion(0);
+      wallSurface = surfaceAtlas.getRegion(1);
+      return;
+    }
+    surfaceAtlas.reset(); // A source is missing: bind them separately
   }
-  if (!groundModel->load("assets/ground.obj")) {
-    printf("Failed to load ground model\n");
+  ground = AssetRegistry::acquireTexture(groundPath);
+  wall = AssetRegistry::acquireTexture(wallPath);
+  groundSurface = TextureRegion(ground.get());
+  wallSurface = TextureRegion(wall.get());
+}
+
+bool Level::sphereVisible(float x, float y, float z, float radius) const {
+  return frustum.sphereVisible(x, y, z, radius) &&
+         occlusion.sphereVisible(x, y, z, radius);
+}
+
+bool Level::obstacleVisible(const Obstacle *obs, float margin) const {
+  float hw = obs->width / 2 + margin;
+  float hd = obs->depth / 2 + margin;
+  float minX = obs->x - hw, minY = obs->y - margin, minZ = obs->z - hd;
+  float maxX = obs->x + hw, maxY = obs->y + obs->height + margin;
+  float maxZ = obs->z + hd;
+  return frustum.boxVisible(minX, minY, minZ, maxX, maxY, maxZ) &&
+         occlusion.boxVisible(minX, minY, minZ, maxX, maxY, maxZ);
+}
+
+// Culling margin for a model drawn at scale around an entity's position,
+// at least fallback (the size of the primitive drawn while it streams in)
+static float modelMargin(const ModelHandle &model, float scale,
+                         float fallback) {
+  float radius = model ? model->getBoundingRadius() * scale : 0.0f;
+  return radius > fallback ? radius : fallback;
+}
+
+// Point lights that never move: gatherLights() adds them live for the
+// entities, and the bakes add them (torches at their mean flicker) to the
+// static geometry
+static const float torchColor[3] = {1.0f, 0.55f, 0.2f};
+static const float torchAttenuation[3] = {1.0f, 0.09f, 0.032f};
+static const float crystalColor[3] = {0.3f, 0.7f, 1.0f};
+static const float crystalAttenuation[3] = {1.0f, 0.22f, 0.2f};
+
+static PointLight bakedLight(float x, float y, float z, const float *color,
+                             float scale, const float *attenuation) {
+  PointLight light;
+  light.x = x;
+  light.y = y;
+  light.z = z;
+  for (int k = 0; k < 3; k++) {
+    light.color[k] = color[k] * scale;
+    light.attenuation[k] = attenuation[k];
+  }
+  light.specular = false;
+  light.range = 0.0f;
+  light.baked = true;
+  return light;
+}
+
+// Draws a face spanned by du and dv from origin as tilesU x tilesV quads,
+// each mapping the whole surface region (an atlas region cannot GL_REPEAT).
+// du x dv points along normal. Each tile is split into subdivisions x
+// subdivisions quads, for vertices enough to carry baked light pools.
+static void bakeTiledFace(MeshBuilder &mesh, const Vec3 &origin,
+                          const Vec3 &du, const Vec3 &dv, const Vec3 &normal,
+                          int tilesU, int tilesV,
+                          const TextureRegion &surface,
+                          int subdivisions = 1) {
+  static const float corners[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+  mesh.normal(normal.x, normal.y, normal.z);
+  for (int i = 0; i < tilesU; i++) {
+    for (int j = 0; j < tilesV; j++) {
+      for (int a = 0; a < subdivisions; a++) {
+        for (int b = 0; b < subdivisions; b++) {
+          for (const float *c : corners) {
+            float fu = (a + c[0]) / subdivisions;
+            float fv = (b + c[1]) / subdivisions;
+            float s = (i + fu) / tilesU;
+            float t = (j + fv) / tilesV;
+            mesh.texCoord(surface.u(fu), surface.v(fv));
+            mesh.vertex(origin.x + du.x * s + dv.x * t,
+                        origin.y + du.y * s + dv.y * t,
+                        origin.z + du.z * s + dv.z * t);
+          }
+        }
+      }
+    }
   }
-  cactusModel->load("assets/cactus.obj");
+}
 
-  // Load textures
-  wallTexture = loadBMP("assets/wall.bmp");
-  groundTexture = loadBMP("assets/ground.bmp");
+static int tileCount(float length, float tileSize) {
+  int tiles = (int)(length / tileSize + 0.5f);
+  return tiles > 0 ? tiles : 1;
 }
 
-void Level::renderGround(float size, Texture &texture) {
-  glEnable(GL_TEXTURE_2D);
-  glBindTexture(GL_TEXTURE_2D, texture.id);
-  glEnable(GL_LIGHTING);
-  glColor3f(1.0f, 1.0f, 1.0f); // White to show texture colors
+// Axis-aligned box around (cx, cy, cz) with the surface repeated every
+// tileSize units on each face
+static void bakeTexturedBox(MeshBuilder &mesh, float cx, float cy, float cz,
+                            float hx, float hy, float hz, float tileSize,
+                            const TextureRegion &surface) {
+  int tx = tileCount(2 * hx, tileSize);
+  int ty = tileCount(2 * hy, tileSize);
+  int tz = tileCount(2 * hz, tileSize);
+  mesh.begin(GL_QUADS);
+  bakeTiledFace(mesh, Vec3(cx - hx, cy - hy, cz + hz), Vec3(2 * hx, 0, 0),
+                Vec3(0, 2 * hy, 0), Vec3(0, 0, 1), tx, ty, surface);
+  bakeTiledFace(mesh, Vec3(cx + hx, cy - hy, cz - hz), Vec3(-2 * hx, 0, 0),
+                Vec3(0, 2 * hy, 0), Vec3(0, 0, -1), tx, ty, surface);
+  bakeTiledFace(mesh, Vec3(cx + hx, cy - hy, cz + hz), Vec3(0, 0, -2 * hz),
+                Vec3(0, 2 * hy, 0), Vec3(1, 0, 0), tz, ty, surface);
+  bakeTiledFace(mesh, Vec3(cx - hx, cy - hy, cz - hz), Vec3(0, 0, 2 * hz),
+                Vec3(0, 2 * hy, 0), Vec3(-1, 0, 0), tz, ty, surface);
+  bakeTiledFace(mesh, Vec3(cx - hx, cy + hy, cz + hz), Vec3(2 * hx, 0, 0),
+                Vec3(0, 0, -2 * hz), Vec3(0, 1, 0), tx, tz, surface);
+  bakeTiledFace(mesh, Vec3(cx - hx, cy - hy, cz - hz), Vec3(2 * hx, 0, 0),
+                Vec3(0, 0, 2 * hz), Vec3(0, -1, 0), tx, tz, surface);
+  mesh.end();
+}
 
-  // Always use simple quad (no model) for smooth ground
-  glBegin(GL_QUADS);
-  glNormal3f(0, 1, 0);
-  glTexCoord2f(0, 0);
-  glVertex3f(-size, 0, -size);
-  glTexCoord2f(10, 0);
-  glVertex3f(size, 0, -size);
-  glTexCoord2f(10, 10);
-  glVertex3f(size, 0, size);
-  glTexCoord2f(0, 10);
-  glVertex3f(-size, 0, size);
-  glEnd();
+// Baked into a lit group textured with the surface
+void Level::bakeGround(MeshBuilder &mesh, float size,
+                       const TextureRegion &surface, int subdivisions) {
+  mesh.color(1.0f, 1.0f, 1.0f); // White to show texture colors
+
+  // Always use simple quads (no model) for smooth ground; the texture
+  // repeats 10 times across it
+  mesh.begin(GL_QUADS);
+  bakeTiledFace(mesh, Vec3(-size, 0, -size), Vec3(2 * size, 0, 0),
+                Vec3(0, 0, 2 * size), Vec3(0, 1, 0), 10, 10, surface,
+                subdivisions);
+  mesh.end();
 }
 
-void Level::renderSkybox(float r, float g, float b) {
-  glDisable(GL_LIGHTING);
-  glColor3f(r, g, b);
+// Baked into an unlit, untextured group
+void Level::bakeSkybox(MeshBuilder &mesh, float r, float g, float b) {
+  mesh.color(r, g, b);
 
   float size = 200.0f;
-  glBegin(GL_QUADS);
+  mesh.begin(GL_QUADS);
   // Back
-  glVertex3f(-size, 0, -size);
-  glVertex3f(size, 0, -size);
-  glVertex3f(size, size, -size);
-  glVertex3f(-size, size, -size);
+  mesh.vertex(-size, 0, -size);
+  mesh.vertex(size, 0, -size);
+  mesh.vertex(size, size, -size);
+  mesh.vertex(-size, size, -size);
 
   // Left
-  glVertex3f(-size, 0, size);
-  glVertex3f(-size, 0, -size);
-  glVertex3f(-size, size, -size);
-  glVertex3f(-size, size, size);
+  mesh.vertex(-size, 0, size);
+  mesh.vertex(-size, 0, -size);
+  mesh.vertex(-size, size, -size);
+  mesh.vertex(-size, size, size);
 
   // Right
-  glVertex3f(size, 0, -size);
-  glVertex3f(size, 0, size);
-  glVertex3f(size, size, size);
-  glVertex3f(size, size, -size);
+  mesh.vertex(size, 0, -size);
+  mesh.vertex(size, 0, size);
+  mesh.vertex(size, size, size);
+  mesh.vertex(size, size, -size);
 
   // Front
-  glVertex3f(size, 0, size);
-  glVertex3f(-size, 0, size);
-  glVertex3f(-size, size, size);
-  glVertex3f(size, size, size);
+  mesh.vertex(size, 0, size);
+  mesh.vertex(-size, 0, size);
+  mesh.vertex(-size, size, size);
+  mesh.vertex(size, size, size);
 
   // Top
-  glColor3f(r * 0.8f, g * 0.8f, b * 1.2f);
-  glVertex3f(-size, size, -size);
-  glVertex3f(size, size, -size);
-  glVertex3f(size, size, size);
-  glVertex3f(-size, size, size);
-  glEnd();
-  glEnable(GL_LIGHTING);
+  mesh.color(r * 0.8f, g * 0.8f, b * 1.2f);
+  mesh.vertex(-size, size, -size);
+  mesh.vertex(size, size, -size);
+  mesh.vertex(size, size, size);
+  mesh.vertex(-size, size, size);
+  mesh.end();
 }
 
-void Level::renderWalls(float size, float height, Texture &texture) {
-  glEnable(GL_LIGHTING);
-  glEnable(GL_TEXTURE_2D);
-  glBindTexture(GL_TEXTURE_2D, texture.id);
-
-  glColor3f(1.0f, 1.0f, 1.0f);
-
-  float thickness = 1.0f;
-
-  // North wall
-  glPushMatrix();
-  glTranslatef(0, height / 2, -size);
-  glScalef(size * 2, height, thickness);
-  glutSolidCube(1.0f);
-  glPopMatrix();
-
-  // South wall
-  glPushMatrix();
-  glTranslatef(0, height / 2, size);
-  glScalef(size * 2, height, thickness);
-  glutSolidCube(1.0f);
-  glPopMatrix();
-
-  // West wall
-  glPushMatrix();
-  glTranslatef(-size, height / 2, 0);
-  glScalef(thickness, height, size * 2);
-  glutSolidCube(1.0f);
-  glPopMatrix();
-
-  // East wall
-  glPushMatrix();
-  glTranslatef(size, height / 2, 0);
-  glScalef(thickness, height, size * 2);
-  glutSolidCube(1.0f);
-  glPopMatrix();
+// Baked into a lit group textured with the surface
+void Level::bakeWalls(MeshBuilder &mesh, float size, float height,
+                      const TextureRegion &surface) {
+  mesh.color(1.0f, 1.0f, 1.0f);
+
+  float half = 0.5f; // 1 unit thick
+  float tile = height / 2;
+
+  // North, south, west, east
+  bakeTexturedBox(mesh, 0, height / 2, -size, size, height / 2, half, tile,
+                  surface);
+  bakeTexturedBox(mesh, 0, height / 2, size, size, height / 2, half, tile,
+                  surface);
+  bakeTexturedBox(mesh, -size, height / 2, 0, half, height / 2, size, tile,
+                  surface);
+  bakeTexturedBox(mesh, size, height / 2, 0, half, height / 2, size, tile,
+                  surface);
 }
 
 // ============================================================================
@@ -251,25 +512,40 @@ DesertLevel::DesertLevel() : Level() {
 }
 
 DesertLevel::~DesertLevel() {
+  waitForBake();
   for (auto c : chests)
     delete c;
 }
 
+void DesertLevel::queueAssets(AssetBatch &batch) {
+  queueCommonAssets(batch);
+  if (TextureAtlas::enabled) {
+    batch.addAtlas({"assets/sand_ground.bmp", "assets/sandstone_wall.bmp"});
+  } else {
+    batch.addTexture("assets/sand_ground.bmp");
+    batch.addTexture("assets/sandstone_wall.bmp");
+  }
+}
+
 void DesertLevel::init(Player *p) {
   player = p;
   levelComplete = false;
   levelTimer = maxTime; // Reset timer
 
+  // Set Normal Physics (High acceleration, High friction)
+  // Faster movement as requested
+  player->setPhysics(80.0f, 10.0f, 11.0f);
+
+  finishPreparing();
+}
+
+void DesertLevel::setup() {
   // Setup lighting
   sunLight.position = {0, 100, -80, 1}; // High up and visible
   sunLight.ambient = {0.5f, 0.5f, 0.5f, 1.0f};
   sunLight.diffuse = {1.0f, 0.9f, 0.8f, 1.0f}; // Warm sunlight
   sunLight.specular = {1.0f, 1.0f, 1.0f, 1.0f};
 
-  // Set Normal Physics (High acceleration, High friction)
-  // Faster movement as requested
-  player->setPhysics(80.0f, 10.0f, 11.0f);
-
   // Spawn level elements
   spawnOrbs();
   spawnChests();
@@ -292,11 +568,106 @@ void DesertLevel::init(Player *p) {
   // Create portal
   portal = new Portal(0, 1, -80);
 
-  loadCommonAssets();
+  loadCommonAssets(queueAssets);
+}
 
-  // Load desert textures
-  sandTexture = loadBMP("assets/sand_ground.bmp");
-  desertWallTexture = loadBMP("assets/sandstone_wall.bmp");
+void DesertLevel::acquireTextures() {
+  Level::acquireTextures();
+  loadSurfaceTextures("assets/sand_ground.bmp", "assets/sandstone_wall.bmp",
+                      sandTexture, desertWallTexture);
+}
+
+void DesertLevel::bake() { bakeStaticGeometry(staticGeometry, sunLight); }
+
+void DesertLevel::bakeStaticGeometry(StaticGeometry &target,
+                                     const LightSource &sun) {
+  RenderState solid;
+  RenderState unlit(BLEND_NONE, false);
+  RenderState ground(BLEND_NONE, true, groundSurface.id);
+  RenderState walled(BLEND_NONE, true, wallSurface.id);
+  target.release();
+
+  // Ground and skybox scaled for the map size (90.0); the ground is
+  // slightly larger (100.0) to avoid edges
+  bakeGround(target.group(ground), 100.0f, groundSurface, 6);
+  bakeSkybox(target.group(unlit, false), 0.5f, 0.7f, 0.9f);
+  bakeWalls(target.group(walled), 90.0f, 15.0f, wallSurface);
+
+  for (auto obs : obstacles) {
+    float x = obs->x, y = obs->y, z = obs->z;
+    if (obs->type == PILLAR) {
+      bakePillar(target.group(solid), x, y, z);
+      bakePillarShaft(target.group(walled), x, y, z);
+    } else if (obs->type == PYRAMID) {
+      bakePyramid(target.group(walled), x, y, z, obs->width, obs->height);
+      bakePyramidCapstone(target.group(solid), x, y, z, obs->height);
+    }
+  }
+
+  // Torch sticks (the flames flicker, so they stay dynamic)
+  MeshBuilder &sticks = target.group(solid);
+  sticks.color(0.4f, 0.2f, 0.1f);
+  for (auto torch : torches) {
+    sticks.pushMatrix();
+    sticks.translate(torch->x, torch->y, torch->z);
+    sticks.scale(0.1f, 1.5f, 0.1f);
+    sticks.solidCube(1.0f);
+    sticks.popMatrix();
+  }
+
+  // Sun (higher up and further back for grand scale)
+  MeshBuilder &disc = target.group(unlit, false);
+  disc.pushMatrix();
+  disc.translate(0.0f, 150.0f, -120.0f);
+  disc.color(1.0f, 1.0f, 0.8f);    // Bright yellow-white
+  disc.solidSphere(15.0f, 20, 20); // Massive sun
+  disc.popMatrix();
+
+  // Scenery models that have streamed in, with render()'s transforms
+  const SceneryMesh *pillarMesh = findSceneryMesh(pillarModel);
+  const SceneryMesh *treeMesh = findSceneryMesh(treeModel);
+  const SceneryMesh *rockMesh = findSceneryMesh(rockModel);
+  const SceneryMesh *cactusMesh = findSceneryMesh(cactusModel);
+  MeshBuilder &scenery = target.group(solid);
+  for (auto obs : obstacles) {
+    scenery.pushMatrix();
+    scenery.translate(obs->x, obs->y, obs->z);
+    if (obs->type == PILLAR_ASSET && pillarMesh) {
+      scenery.scale(0.2f, 0.2f, 0.2f);
+      scenery.rotate(-90.0f, 1.0f, 0.0f, 0.0f);
+      scenery.rotate(180.0f, 0.0f, 0.0f, 1.0f);
+      scenery.color(0.7f, 0.6f, 0.5f);
+      scenery.mesh(pillarMesh->vertices, pillarMesh->indices);
+    } else if (obs->type == TREE && treeMesh) {
+      scenery.scale(1.5f, 1.5f, 1.5f);
+      scenery.color(0.35f, 0.55f, 0.25f); // Palm green
+      scenery.mesh(treeMesh->vertices, treeMesh->indices);
+    } else if (obs->type == ROCK && rockMesh) {
+      scenery.scale(3.0f, 3.0f, 3.0f);
+      scenery.color(0.5f, 0.5f, 0.5f);
+      scenery.mesh(rockMesh->vertices, rockMesh->indices);
+    } else if (obs->type == CACTUS && cactusMesh) {
+      scenery.rotate(-90.0f, 1.0f, 0.0f, 0.0f);
+      scenery.scale(0.1f, 0.1f, 0.1f);
+      scenery.color(0.2f, 0.6f, 0.2f);
+      scenery.mesh(cactusMesh->vertices, cactusMesh->indices);
+    }
+    scenery.popMatrix();
+  }
+
+  // The torches light the ground and walls around them for good; the sun
+  // moves, so render() re-bakes its share a slice at a time
+  std::vector<PointLight> bakedLights;
+  for (auto torch : torches)
+    bakedLights.push_back(bakedLight(torch->x, torch->y + 0.8f, torch->z,
+                                     torchColor, 0.8f, torchAttenuation));
+  target.bakeLighting(sun, bakedLights, true);
+  target.buildChunks();
+}
+
+std::vector<const Model *> DesertLevel::sceneryModels() const {
+  return {pillarModel.get(), treeModel.get(), rockModel.get(),
+          cactusModel.get()};
 }
 
 void DesertLevel::spawnOrbs() {
@@ -718,6 +1089,8 @@ void DesertLevel::reset() {
 }
 
 void DesertLevel::render() {
+  updateRebake();
+
   // Setup lighting
   glEnable(GL_LIGHT0);
   glLightfv(GL_LIGHT0, GL_POSITION, sunLight.position.data());
@@ -729,189 +1102,284 @@ void DesertLevel::render() {
   glDisable(GL_BLEND);
   glDepthMask(GL_TRUE);
 
-  // Render ground and skybox scaled for new map size (90.0)
-  // Rendering slightly larger (100.0) to avoid edges
-  renderGround(100.0f, sandTexture);
-  renderSkybox(0.5f, 0.7f, 0.9f);
-  // Walls at 90.0f
-  renderWalls(90.0f, 15.0f, desertWallTexture);
-
-  // Render orbs
+  // Everything below is culled, the baked static geometry a chunk at a time
+  frustum.extract();
+  rasterizeOccluders();
+  gatherLights();
+
+  // Entities go through the render queue, which draws them sorted by state;
+  // the baked opaque groups go first, one draw each, with the sun's share
+  // of their baked lighting brought up to date a slice per frame and the
+  // orb and portal lights added on top
+  queue.begin();
+  staticGeometry.relight(sunLight, 8192);
+  lights.bind(player->getX(), player->getY(), player->getZ());
+  staticGeometry.drawOpaque(frustum, occlusion);
+  staticGeometry.drawDynamicLights(frustum, occlusion, lights);
+  glows.clear();
+  RenderState solid;
+  RenderState additive(BLEND_ADDITIVE);
+
+  // Render orbs (collecting ones grow to 3x with their halo)
   for (auto orb : collectibles) {
-    if (!orb->collected)
-      renderOrb(orb);
+    if (orb->collected ||
+        !sphereVisible(orb->x, orb->y, orb->z, orb->radius * 4.0f))
+      continue;
+    queue.submit(solid, orb->x, orb->y, orb->z, [=] { renderOrb(orb); });
+    addOrbHalo(orb);
   }
 
-  // Render chests
-  for (auto chest : chests)
-    renderChest(chest);
+  // Render chests (sparkle ring and glow reach 2 units out)
+  bool chestReady = chestModel && chestModel->getWidth() > 0;
+  for (auto chest : chests) {
+    if (!sphereVisible(chest->x, chest->y + 0.5f, chest->z, 2.5f))
+      continue;
+    queue.submit(solid, chest->x, chest->y, chest->z,
+                 [=] { renderChest(chest); });
+    if (!chest->opened)
+      queue.submit(additive, chest->x, chest->y, chest->z,
+                   [=] { renderChestSparkles(chest); });
+    if (!chestReady && !chest->opened && chest->hasOrb)
+      addChestGlow(chest);
+  }
 
   // Render enemies
+  float snakeMargin = modelMargin(snakeModel, 0.05f, 0.5f);
   for (auto enemy : enemies)
-    renderScorpion(enemy);
-
-  // Render obstacles
+    if (sphereVisible(enemy->x, enemy->y, enemy->z, snakeMargin))
+      queue.submit(solid, enemy->x, enemy->y, enemy->z,
+                   [=] { renderScorpion(enemy); });
+
+  // Render obstacles; the asset pillars are collected and drawn together
+  bool pillarReady = pillarModel && pillarModel->getWidth() > 0;
+  float pillarMargin = modelMargin(pillarModel, 0.2f, 1.0f);
+  float treeMargin = modelMargin(treeModel, 1.5f, 2.0f);
+  float rockMargin = modelMargin(rockModel, 3.0f, 1.0f);
+  float cactusMargin = modelMargin(cactusModel, 0.1f, 1.0f);
+  pillarInstances.clear();
   for (auto obs : obstacles) {
-    if (obs->type == PILLAR)
-      renderPillar(obs->x, obs->y, obs->z);
-    else if (obs->type == PILLAR_ASSET) {
-      // Render asset pillar inline
-      glPushMatrix();
-      glTranslatef(obs->x, obs->y, obs->z);
-      if (pillarModel && pillarModel->getWidth() > 0) {
-        glColor3f(0.7f, 0.6f, 0.5f);
-        glScalef(0.2f, 0.2f, 0.2f); // Reduced scale from 0.3 to 0.2
-        glRotatef(-90.0f, 1.0f, 0.0f, 0.0f);
-        glRotatef(180.0f, 0.0f, 0.0f, 1.0f);
-        pillarModel->render();
+    if (obs->type == WALL || obs->type == PILLAR || obs->type == PYRAMID)
+      continue; // Baked
+    if ((obs->type == PILLAR_ASSET && isBaked(pillarModel)) ||
+        (obs->type == TREE && isBaked(treeModel)) ||
+        (obs->type == ROCK && isBaked(rockModel)) ||
+        (obs->type == CACTUS && isBaked(cactusModel)))
+      continue; // Baked once streamed in
+    float margin = obs->type == PILLAR_ASSET ? pillarMargin
+                   : obs->type == TREE       ? treeMargin
+                   : obs->type == ROCK       ? rockMargin
+                   : obs->type == CACTUS     ? cactusMargin
+                                             : 1.0f;
+    if (!obstacleVisible(obs, margin))
+      continue;
+    float x = obs->x, y = obs->y, z = obs->z;
+    if (obs->type == PILLAR_ASSET) {
+      if (pillarReady) {
+        pillarInstances.add(Transform()
+                                .translate(x, y, z)
+                                .scale(0.2f) // Reduced scale from 0.3 to 0.2
+                                .rotate(-90.0f, 1.0f, 0.0f, 0.0f)
+                                .rotate(180.0f, 0.0f, 0.0f, 1.0f),
+                            x, y, z, pillarMargin);
       } else {
         // Fallback
-        glColor3f(0.5f, 0.5f, 0.5f);
-        glScalef(1, 3, 1);
-        glutSolidCube(1.0f);
+        queue.submit(solid, x, y, z, [=] {
+          glPushMatrix();
+          glTranslatef(x, y, z);
+          glColor3f(0.5f, 0.5f, 0.5f);
+          glScalef(1, 3, 1);
+          PrimitiveCache::solidCube(1.0f);
+          glPopMatrix();
+        });
       }
-      glPopMatrix();
-    } else if (obs->type == TREE)
-      renderPalmTree(obs->x, obs->y, obs->z);
-    else if (obs->type == ROCK)
-      renderRock(obs->x, obs->y, obs->z);
-    else if (obs->type == CACTUS)
-      renderCactus(obs->x, obs->y, obs->z);
-    else if (obs->type == PYRAMID)
-      renderPyramid(obs->x, obs->y, obs->z, obs->width, obs->height);
+    } else if (obs->type == TREE) {
+      queue.submit(solid, x, y, z, [=] { renderPalmTree(x, y, z); });
+    } else if (obs->type == ROCK) {
+      queue.submit(solid, x, y, z, [=] { renderRock(x, y, z); });
+    } else if (obs->type == CACTUS) {
+      queue.submit(solid, x, y, z, [=] { renderCactus(x, y, z); });
+    }
   }
+  pillarInstances.submit(queue, solid,
+                         [=](const Transform *transforms, size_t count) {
+                           glColor3f(0.7f, 0.6f, 0.5f);
+                           pillarModel->renderInstances(transforms, count);
+                         });
 
   // Render spike traps
-  glColor3f(0.4f, 0.4f, 0.4f);
-  for (auto trap : traps) {
-    glPushMatrix();
-    glTranslatef(trap->x, trap->y, trap->z);
-
-    if (trapModel && trapModel->getWidth() > 0) {
-      glScalef(0.2f, 0.2f, 0.2f); // Adjust scale as needed
-      trapModel->render();
-    } else {
-      glScalef(trap->radius, 0.3f, trap->radius);
-      glutSolidCube(2.0f);
-
-      // Spikes
-      glColor3f(0.3f, 0.3f, 0.3f);
-      for (int i = 0; i < 8; i++) {
-        float angle = i * 45.0f;
+  float trapMargin = modelMargin(trapModel, 0.2f, 1.5f);
+  if (trapModel && trapModel->getWidth() > 0) {
+    trapInstances.clear();
+    for (auto trap : traps)
+      if (sphereVisible(trap->x, trap->y, trap->z, trapMargin))
+        trapInstances.add(Transform()
+                              .translate(trap->x, trap->y, trap->z)
+                              .scale(0.2f), // Adjust scale as needed
+                          trap->x, trap->y, trap->z, trapMargin);
+    trapInstances.submit(queue, solid,
+                         [=](const Transform *transforms, size_t count) {
+                           glColor3f(0.4f, 0.4f, 0.4f);
+                           trapModel->renderInstances(transforms, count);
+                         });
+  } else {
+    for (auto trap : traps) {
+      if (!sphereVisible(trap->x, trap->y, trap->z, trapMargin))
+        continue;
+      queue.submit(solid, trap->x, trap->y, trap->z, [=] {
         glPushMatrix();
-        glRotatef(angle, 0, 1, 0);
-        glTranslatef(0.5f, 0.3f, 0);
-        glRotatef(-90, 1, 0, 0);
-        glutSolidCone(0.1f, 0.5f, 8, 1);
+        glTranslatef(trap->x, trap->y, trap->z);
+        glScalef(trap->radius, 0.3f, trap->radius);
+        glColor3f(0.4f, 0.4f, 0.4f);
+        PrimitiveCache::solidCube(2.0f);
+
+        // Spikes
+        glColor3f(0.3f, 0.3f, 0.3f);
+        for (int i = 0; i < 8; i++) {
+          float angle = i * 45.0f;
+          glPushMatrix();
+          glRotatef(angle, 0, 1, 0);
+          glTranslatef(0.5f, 0.3f, 0);
+          glRotatef(-90, 1, 0, 0);
+          PrimitiveCache::solidCone(0.1f, 0.5f, 8, 1);
+          glPopMatrix();
+        }
         glPopMatrix();
-      }
+      });
     }
-    glPopMatrix();
   }
 
-  // Render portal
-  if (portal)
-    renderPortal();
+  // Render portal (the gate is 12 units wide and tall)
+  if (portal && sphereVisible(portal->x, portal->y + 5.0f, portal->z, 10.0f) &&
+      (portal->active || player->getOrbsCollected() >= totalOrbs)) {
+    queue.submit(solid, portal->x, portal->y, portal->z,
+                 [=] { renderPortal(); });
+    queue.submit(additive, portal->x, portal->y, portal->z,
+                 [=] { renderPortalField(); });
+    if (portal->active)
+      addPortalGlow();
+  }
 
-  // Render Torches
+  // Render torch flames (the sticks are baked)
   for (auto torch : torches) {
-    glPushMatrix();
-    glTranslatef(torch->x, torch->y, torch->z);
-
-    // Torch stick
-    glColor3f(0.4f, 0.2f, 0.1f);
-    glPushMatrix();
-    glScalef(0.1f, 1.5f, 0.1f);
-    glutSolidCube(1.0f);
-    glPopMatrix();
+    torch->flickerOffset += 0.1f; // Keeps flickering while culled
+    if (!sphereVisible(torch->x, torch->y + 0.8f, torch->z, 0.5f))
+      continue;
 
     // Flame (Simple particle effect simulation)
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-    torch->flickerOffset += 0.1f;
-    float flicker = 0.8f + 0.2f * sin(torch->flickerOffset);
-
-    glColor4f(1.0f, 0.5f, 0.0f, 0.8f);
-    glPushMatrix();
-    glTranslatef(0, 0.8f, 0);
-    glScalef(flicker * 0.3f, flicker * 0.5f, flicker * 0.3f);
-    glutSolidSphere(1.0f, 8, 8);
-    glPopMatrix();
-
-    glDisable(GL_BLEND);
-    glPopMatrix();
+    queue.submit(additive, torch->x, torch->y + 0.8f, torch->z, [=] {
+      float flicker = 0.8f + 0.2f * sin(torch->flickerOffset);
+      glColor4f(1.0f, 0.5f, 0.0f, 0.8f);
+      glPushMatrix();
+      glTranslatef(torch->x, torch->y + 0.8f, torch->z);
+      glScalef(flicker * 0.3f, flicker * 0.5f, flicker * 0.3f);
+      PrimitiveCache::solidSphere(1.0f, 8, 8);
+      glPopMatrix();
+    });
   }
 
-  // Render Sun
-  glPushMatrix();
-  glTranslatef(0.0f, 150.0f,
-               -120.0f); // Higher up and further back for grand scale
-  glDisable(GL_LIGHTING);
-  glColor3f(1.0f, 1.0f, 0.8f);    // Bright yellow-white
-  glutSolidSphere(15.0f, 20, 20); // Massive sun
-  glEnable(GL_LIGHTING);
-  glPopMatrix();
+  glows.submit(queue, player->getX(), player->getY(), player->getZ());
+  queue.flush();
+  lights.bind(player->getX(), player->getY(), player->getZ()); // For player
 }
 
-void DesertLevel::renderDesertEnvironment() {
-  // Render professional sand ground
-  renderGround(50, sandTexture);
+void DesertLevel::gatherLights() {
+  lights.clear();
+
+  // Flickering in step with the flame (orange, about 30 units of reach);
+  // the static geometry has them baked in
+  for (auto torch : torches) {
+    float flicker = 0.8f + 0.2f * sin(torch->flickerOffset);
+    lights.add(torch->x, torch->y + 0.8f, torch->z, torchColor[0] * flicker,
+               torchColor[1] * flicker, torchColor[2] * flicker,
+               torchAttenuation[0], torchAttenuation[1], torchAttenuation[2],
+               false, true);
+  }
+
+  // A faint gold pool under each orb still waiting
+  for (auto orb : collectibles) {
+    if (!orb->collected)
+      lights.add(orb->x, orb->y, orb->z, 0.6f, 0.5f, 0.0f, 1.0f, 0.35f,
+                 0.44f);
+  }
 
-  float skyR = 0.53f + 0.2f * sin(timeOfDay);
-  float skyG = 0.81f + 0.1f * sin(timeOfDay);
-  float skyB = 0.92f;
-  renderSkybox(skyR, skyG, skyB);
+  if (portal && portal->active) {
+    float goldenPulse = 0.6f + 0.4f * sin(glutGet(GLUT_ELAPSED_TIME) / 250.0f);
+    lights.add(portal->x, portal->y + 4.5f, portal->z, 1.0f * goldenPulse,
+               0.84f * goldenPulse, 0.0f, 1.0f, 0.1f, 0.0f);
+  }
+}
 
-  // Render sandstone walls
-  renderWalls(45, 8, desertWallTexture);
+void DesertLevel::rasterizeOccluders() {
+  occlusion.begin();
+  // Only what is drawn solid: walls as bakeWalls() lays them out (1 unit
+  // thick), pillars as the box inside their shaft and capital, and pyramid
+  // faces. Off-screen ones cost no more than their triangle setup.
+  for (auto obs : obstacles) {
+    if (obs->type == WALL) {
+      bool alongX = obs->width > obs->depth;
+      float hw = alongX ? obs->width / 2 : 0.5f;
+      float hd = alongX ? 0.5f : obs->depth / 2;
+      occlusion.addBox(obs->x - hw, obs->y, obs->z - hd, obs->x + hw,
+                       obs->y + obs->height, obs->z + hd);
+    } else if (obs->type == PILLAR) {
+      occlusion.addBox(obs->x - 0.55f, obs->y - 0.5f, obs->z - 0.55f,
+                       obs->x + 0.55f, obs->y + 6.1f, obs->z + 0.55f);
+    } else if (obs->type == PYRAMID) {
+      occlusion.addPyramid(obs->x, obs->y, obs->z, obs->width, obs->height);
+    }
+  }
 }
 
-void DesertLevel::renderPillar(float x, float y, float z) {
-  glPushMatrix();
-  glTranslatef(x, y, z);
+void DesertLevel::bakePillar(MeshBuilder &mesh, float x, float y, float z) {
+  mesh.pushMatrix();
+  mesh.translate(x, y, z);
 
   // Professional Manual OpenGL Pillar Implementation
   // Base
-  glColor3f(0.8f, 0.7f, 0.6f); // Sandstone light
-  glPushMatrix();
-  glScalef(1.2f, 0.5f, 1.2f);
-  glutSolidCube(2.0f);
-  glPopMatrix();
+  mesh.color(0.8f, 0.7f, 0.6f); // Sandstone light
+  mesh.pushMatrix();
+  mesh.scale(1.2f, 0.5f, 1.2f);
+  mesh.solidCube(2.0f);
+  mesh.popMatrix();
 
-  // Shaft (Cylinder)
-  glEnable(GL_TEXTURE_2D);
-  glBindTexture(GL_TEXTURE_2D, desertWallTexture.id); // Reuse wall texture
-  glColor3f(1.0f, 1.0f, 1.0f);
+  // Capital (Top) - Simple flared block
+  mesh.color(0.85f, 0.75f, 0.65f);
+  mesh.pushMatrix();
+  mesh.translate(0, 5.5f, 0); // Top of shaft
+  mesh.scale(1.4f, 0.6f, 1.4f);
+  mesh.solidCube(2.0f);
+  mesh.popMatrix();
 
-  GLUquadric *quad = gluNewQuadric();
-  gluQuadricTexture(quad, GL_TRUE); // Enable texture coords
+  // Gold Trim on Capital
+  mesh.color(1.0f, 0.84f, 0.0f); // Gold
+  mesh.pushMatrix();
+  mesh.translate(0, 5.8f, 0);
+  mesh.scale(1.5f, 0.1f, 1.5f);
+  mesh.solidCube(2.0f);
+  mesh.popMatrix();
+
+  mesh.popMatrix();
+}
 
-  glPushMatrix();
-  glTranslatef(0, 0.5f, 0);            // Start on top of base
-  glRotatef(-90.0f, 1.0f, 0.0f, 0.0f); // Upright
-  gluCylinder(quad, 0.8f, 0.8f, 5.0f, 16, 1);
-  glPopMatrix();
+// Baked with the wall texture, apart from the stone of bakePillar()
+void DesertLevel::bakePillarShaft(MeshBuilder &mesh, float x, float y,
+                                  float z) {
+  mesh.pushMatrix();
+  mesh.translate(x, y, z);
 
-  gluDeleteQuadric(quad);
-  glDisable(GL_TEXTURE_2D);
+  // Shaft (Cylinder)
+  mesh.color(1.0f, 1.0f, 1.0f);
 
-  // Capital (Top) - Simple flared block
-  glColor3f(0.85f, 0.75f, 0.65f);
-  glPushMatrix();
-  glTranslatef(0, 5.5f, 0); // Top of shaft
-  glScalef(1.4f, 0.6f, 1.4f);
-  glutSolidCube(2.0f);
-  glPopMatrix();
+  // The cylinder's 0..1 coordinates are mapped into the wall's atlas region
+  mesh.textureWindow(wallSurface.u0, wallSurface.v0, wallSurface.u1,
+                     wallSurface.v1);
 
-  // Gold Trim on Capital
-  glColor3f(1.0f, 0.84f, 0.0f); // Gold
-  glPushMatrix();
-  glTranslatef(0, 5.8f, 0);
-  glScalef(1.5f, 0.1f, 1.5f);
-  glutSolidCube(2.0f);
-  glPopMatrix();
+  mesh.translate(0, 0.5f, 0);            // Start on top of base
+  mesh.rotate(-90.0f, 1.0f, 0.0f, 0.0f); // Upright
+  mesh.cylinder(0.8f, 0.8f, 5.0f, 16, 1);
 
-  glPopMatrix();
+  mesh.textureWindow(0.0f, 0.0f, 1.0f, 1.0f);
+  mesh.popMatrix();
 }
 
 void DesertLevel::renderPalmTree(float x, float y, float z) {
@@ -919,13 +1387,13 @@ void DesertLevel::renderPalmTree(float x, float y, float z) {
   glTranslatef(x, y, z);
 
   if (treeModel && treeModel->getWidth() > 0) {
+    glColor3f(0.35f, 0.55f, 0.25f); // Palm green
     glScalef(1.5f, 1.5f, 1.5f);
     treeModel->render();
   } else {
     glColor3f(0.55f, 0.35f, 0.2f);
-    GLUquadric *quad = gluNewQuadric();
     glRotatef(-90, 1, 0, 0);
-    gluCylinder(quad, 0.5f, 0.3f, 6, 12, 1);
+    PrimitiveCache::cylinder(0.5f, 0.3f, 6, 12, 1);
 
     glColor3f(0.2f, 0.6f, 0.2f);
     for (int i = 0; i < 6; i++) {
@@ -935,10 +1403,9 @@ void DesertLevel::renderPalmTree(float x, float y, float z) {
       glTranslatef(0, 0, 6.5f);
       glRotatef(30, 1, 0, 0);
       glScalef(0.5f, 0.5f, 2.0f);
-      glutSolidSphere(1.0f, 8, 8);
+      PrimitiveCache::solidSphere(1.0f, 8, 8);
       glPopMatrix();
     }
-    gluDeleteQuadric(quad);
   }
   glPopMatrix();
 }
@@ -961,94 +1428,88 @@ void DesertLevel::renderCactus(float x, float y, float z) {
     // Fallback cactus cube - SOLID
     glColor3f(0.2f, 0.6f, 0.2f);
     glScalef(0.5f, 2.0f, 0.5f);
-    glutSolidCube(1.0f);
+    PrimitiveCache::solidCube(1.0f);
   }
 
   glPopMatrix();
 }
 
-void DesertLevel::renderPyramid(float x, float y, float z, float baseSize,
-                                float height) {
-  glPushMatrix();
-  glTranslatef(x, y, z);
+void DesertLevel::bakePyramid(MeshBuilder &mesh, float x, float y, float z,
+                              float baseSize, float height) {
+  mesh.pushMatrix();
+  mesh.translate(x, y, z);
 
   // Professional Manual OpenGL Pyramid Implementation
   float halfSize = baseSize / 2.0f;
 
-  glEnable(GL_TEXTURE_2D);
-  glBindTexture(GL_TEXTURE_2D, desertWallTexture.id); // Re-use wall texture
-
-  glColor3f(1.0f, 1.0f, 1.0f); // White to apply texture
+  // Baked with the wall texture
+  mesh.color(1.0f, 1.0f, 1.0f); // White to apply texture
 
-  glBegin(GL_TRIANGLES);
+  mesh.begin(GL_TRIANGLES);
 
   // Front Face
-  glNormal3f(0.0f, 0.5f, 1.0f);
-  glTexCoord2f(0.0f, 0.0f);
-  glVertex3f(-halfSize, 0.0f, halfSize);
-  glTexCoord2f(1.0f, 0.0f);
-  glVertex3f(halfSize, 0.0f, halfSize);
-  glTexCoord2f(0.5f, 1.0f);
-  glVertex3f(0.0f, height, 0.0f);
+  mesh.normal(0.0f, 0.5f, 1.0f);
+  mesh.texCoord(wallSurface.u(0.0f), wallSurface.v(0.0f));
+  mesh.vertex(-halfSize, 0.0f, halfSize);
+  mesh.texCoord(wallSurface.u(1.0f), wallSurface.v(0.0f));
+  mesh.vertex(halfSize, 0.0f, halfSize);
+  mesh.texCoord(wallSurface.u(0.5f), wallSurface.v(1.0f));
+  mesh.vertex(0.0f, height, 0.0f);
 
   // Right Face
-  glNormal3f(1.0f, 0.5f, 0.0f);
-  glTexCoord2f(0.0f, 0.0f);
-  glVertex3f(halfSize, 0.0f, halfSize);
-  glTexCoord2f(1.0f, 0.0f);
-  glVertex3f(halfSize, 0.0f, -halfSize);
-  glTexCoord2f(0.5f, 1.0f);
-  glVertex3f(0.0f, height, 0.0f);
+  mesh.normal(1.0f, 0.5f, 0.0f);
+  mesh.texCoord(wallSurface.u(0.0f), wallSurface.v(0.0f));
+  mesh.vertex(halfSize, 0.0f, halfSize);
+  mesh.texCoord(wallSurface.u(1.0f), wallSurface.v(0.0f));
+  mesh.vertex(halfSize, 0.0f, -halfSize);
+  mesh.texCoord(wallSurface.u(0.5f), wallSurface.v(1.0f));
+  mesh.vertex(0.0f, height, 0.0f);
 
   // Back Face
-  glNormal3f(0.0f, 0.5f, -1.0f);
-  glTexCoord2f(0.0f, 0.0f);
-  glVertex3f(halfSize, 0.0f, -halfSize);
-  glTexCoord2f(1.0f, 0.0f);
-  glVertex3f(-halfSize, 0.0f, -halfSize);
-  glTexCoord2f(0.5f, 1.0f);
-  glVertex3f(0.0f, height, 0.0f);
+  mesh.normal(0.0f, 0.5f, -1.0f);
+  mesh.texCoord(wallSurface.u(0.0f), wallSurface.v(0.0f));
+  mesh.vertex(halfSize, 0.0f, -halfSize);
+  mesh.texCoord(wallSurface.u(1.0f), wallSurface.v(0.0f));
+  mesh.vertex(-halfSize, 0.0f, -halfSize);
+  mesh.texCoord(wallSurface.u(0.5f), wallSurface.v(1.0f));
+  mesh.vertex(0.0f, height, 0.0f);
 
   // Left Face
-  glNormal3f(-1.0f, 0.5f, 0.0f);
-  glTexCoord2f(0.0f, 0.0f);
-  glVertex3f(-halfSize, 0.0f, -halfSize);
-  glTexCoord2f(1.0f, 0.0f);
-  glVertex3f(-halfSize, 0.0f, halfSize);
-  glTexCoord2f(0.5f, 1.0f);
-  glVertex3f(0.0f, height, 0.0f);
+  mesh.normal(-1.0f, 0.5f, 0.0f);
+  mesh.texCoord(wallSurface.u(0.0f), wallSurface.v(0.0f));
+  mesh.vertex(-halfSize, 0.0f, -halfSize);
+  mesh.texCoord(wallSurface.u(1.0f), wallSurface.v(0.0f));
+  mesh.vertex(-halfSize, 0.0f, halfSize);
+  mesh.texCoord(wallSurface.u(0.5f), wallSurface.v(1.0f));
+  mesh.vertex(0.0f, height, 0.0f);
 
-  glEnd();
+  mesh.end();
 
   // Bottom Face (Square)
-  glBegin(GL_QUADS);
-  glNormal3f(0.0f, -1.0f, 0.0f);
-  glTexCoord2f(0.0f, 0.0f);
-  glVertex3f(-halfSize, 0.0f, halfSize);
-  glTexCoord2f(1.0f, 0.0f);
-  glVertex3f(-halfSize, 0.0f, -halfSize);
-  glTexCoord2f(1.0f, 1.0f);
-  glVertex3f(halfSize, 0.0f, -halfSize);
-  glTexCoord2f(0.0f, 1.0f);
-  glVertex3f(halfSize, 0.0f, halfSize);
-  glEnd();
+  mesh.begin(GL_QUADS);
+  mesh.normal(0.0f, -1.0f, 0.0f);
+  mesh.texCoord(wallSurface.u(0.0f), wallSurface.v(0.0f));
+  mesh.vertex(-halfSize, 0.0f, halfSize);
+  mesh.texCoord(wallSurface.u(1.0f), wallSurface.v(0.0f));
+  mesh.vertex(-halfSize, 0.0f, -halfSize);
+  mesh.texCoord(wallSurface.u(1.0f), wallSurface.v(1.0f));
+  mesh.vertex(halfSize, 0.0f, -halfSize);
+  mesh.texCoord(wallSurface.u(0.0f), wallSurface.v(1.0f));
+  mesh.vertex(halfSize, 0.0f, halfSize);
+  mesh.end();
+
+  mesh.popMatrix();
+}
 
+void DesertLevel::bakePyramidCapstone(MeshBuilder &mesh, float x, float y,
+                                      float z, float height) {
   // Capstone (Gold)
-  glDisable(GL_TEXTURE_2D);
-  glColor3f(1.0f, 0.84f, 0.0f); // Gold
-  glPushMatrix();
-  glTranslatef(0, height - 0.5f, 0);
-  glScalef(0.1f, 0.1f, 0.1f);
-  // Simple diamond shape for capstone
-  glBegin(GL_TRIANGLES);
-  // (Simplified mini pyramid logic or just a small cube rotated)
-  glEnd();
-  glutSolidOctahedron(); // Easy professional capstone shape
-  glPopMatrix();
-
-  glEnable(GL_TEXTURE_2D);
-
-  glPopMatrix();
+  mesh.color(1.0f, 0.84f, 0.0f); // Gold
+  mesh.pushMatrix();
+  mesh.translate(x, y + height - 0.5f, z);
+  mesh.scale(0.1f, 0.1f, 0.1f);
+  mesh.solidOctahedron(); // Easy professional capstone shape
+  mesh.popMatrix();
 }
 
 void DesertLevel::renderRock(float x, float y, float z) {
@@ -1057,78 +1518,69 @@ void DesertLevel::renderRock(float x, float y, float z) {
 
   if (rockModel && rockModel->getWidth() > 0) {
     // Armadillo is usually unit size or small, let's scale it up
+    glColor3f(0.5f, 0.5f, 0.5f);
     glScalef(3.0f, 3.0f, 3.0f);
     rockModel->render();
   } else {
     glColor3f(0.5f, 0.5f, 0.5f);
-    glutSolidSphere(1.0f, 8, 8);
+    PrimitiveCache::solidSphere(1.0f, 8, 8);
   }
   glPopMatrix();
 }
 
-void DesertLevel::renderOrb(Collectible *orb) {
-  glPushMatrix();
-  glTranslatef(orb->x, orb->y, orb->z);
+// Bobbing height and scale of an orb: collecting orbs stop bobbing and
+// grow instead
+static float orbBob(const Collectible *orb) {
+  if (orb->isCollecting)
+    return 0.0f;
+  return sin(glutGet(GLUT_ELAPSED_TIME) * 0.003f) * 0.2f;
+}
+
+static float orbScale(const Collectible *orb) {
+  return orb->isCollecting ? 1.0f + (orb->collectTimer / 0.5f) * 2.0f : 1.0f;
+}
+
+// Bobbing and spinning frame of an orb
+static void applyOrbTransform(const Collectible *orb) {
+  glTranslatef(orb->x, orb->y + orbBob(orb), orb->z);
 
   // Animation: Bobbing and Rotating
   float rotation = orb->rotation + glutGet(GLUT_ELAPSED_TIME) * 0.1f;
-  float bob = sin(glutGet(GLUT_ELAPSED_TIME) * 0.003f) * 0.2f;
-
-  if (orb->isCollecting) {
-    // Scale up and spin fast
-    float scale = 1.0f + (orb->collectTimer / 0.5f) * 2.0f;
-    glScalef(scale, scale, scale);
+  float scale = orbScale(orb);
+  glScalef(scale, scale, scale);
+  if (orb->isCollecting)
     rotation *= 10.0f; // Fast spin
-  } else {
-    glTranslatef(0, bob, 0);
-  }
 
   glRotatef(rotation, 0, 1, 0);
+}
 
+void DesertLevel::renderOrb(Collectible *orb) {
+  glPushMatrix();
+  applyOrbTransform(orb);
   glColor3f(1.0f, 0.84f, 0.0f);
-  glutSolidSphere(orb->radius, 20, 20);
-
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-  glColor4f(1.0f, 0.84f, 0.0f, 0.3f);
-  glutSolidSphere(orb->radius * 1.3f, 20, 20);
-  glDisable(GL_BLEND);
-
+  PrimitiveCache::solidSphere(orb->radius, 20, 20);
   glPopMatrix();
 }
 
-void DesertLevel::renderChest(Chest *chest) {
-  glPushMatrix();
-
-  // Floating Animation
-  float time = glutGet(GLUT_ELAPSED_TIME) / 1000.0f;
-  // Offset based on position to unsync chests
-  float bobOffset = sin(time * 2.0f + chest->x) * 0.3f;
+void DesertLevel::addOrbHalo(Collectible *orb) {
+  float radius = orb->radius * 1.3f * orbScale(orb);
+  glows.add(orb->x, orb->y + orbBob(orb), orb->z, radius, radius, 1.0f,
+            0.84f, 0.0f, 0.3f);
+}
 
-  glTranslatef(chest->x, chest->y + 0.5f + bobOffset,
-               chest->z); // Lift up slightly for floating effect
+// Floating Animation: lifts the chest slightly and bobs it, offset by its
+// position to unsync chests
+static float chestLift(const Chest *chest, float time) {
+  return 0.5f + sin(time * 2.0f + chest->x) * 0.3f;
+}
 
-  // Magical Particle Ring (Spinning)
-  if (!chest->opened) {
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-    for (int i = 0; i < 8; i++) {
-      float angle = time * 2.0f + i * (2.0f * 3.14159f / 8.0f);
-      float r = 1.8f; // Radius
-      float px = sin(angle) * r;
-      float pz = cos(angle) * r;
-      float py = sin(time * 3.0f + i) * 0.5f; // Vertical variance
+static void applyChestTransform(const Chest *chest, float time) {
+  glTranslatef(chest->x, chest->y + chestLift(chest, time), chest->z);
+}
 
-      glPushMatrix();
-      glTranslatef(px, py, pz);
-      // Sparkle color (Gold/Magic)
-      glColor4f(1.0f, 0.9f, 0.4f, 0.8f);
-      glScalef(0.15f, 0.15f, 0.15f);
-      glutSolidOctahedron();
-      glPopMatrix();
-    }
-    glDisable(GL_BLEND);
-  }
+void DesertLevel::renderChest(Chest *chest) {
+  glPushMatrix();
+  applyChestTransform(chest, glutGet(GLUT_ELAPSED_TIME) / 1000.0f);
 
   if (chestModel && chestModel->getWidth() > 0) {
     // Scale to appropriate size
@@ -1144,7 +1596,7 @@ void DesertLevel::renderChest(Chest *chest) {
     glColor3f(0.6f, 0.4f, 0.2f); // Brown
     glPushMatrix();
     glScalef(2.0f, 1.2f, 1.5f); // Larger chest
-    glutSolidCube(1.0f);
+    PrimitiveCache::solidCube(1.0f);
     glPopMatrix();
 
     // Animate lid opening (Logic moved to update for frame-rate independence)
@@ -1159,26 +1611,47 @@ void DesertLevel::renderChest(Chest *chest) {
     glTranslatef(0, 0, 0.75f);
     glColor3f(0.7f, 0.5f, 0.3f); // Lighter brown for lid
     glScalef(2.0f, 0.2f, 1.5f);
-    glutSolidCube(1.0f);
+    PrimitiveCache::solidCube(1.0f);
     glPopMatrix();
+  }
 
-    // Add glow effect for unopened chests with orbs
-    if (!chest->opened && chest->hasOrb) {
-      glEnable(GL_BLEND);
-      glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+  glPopMatrix();
+}
 
-      // Pulsing Glow
-      float pulse = 0.5f + 0.5f * sin(time * 4.0f);
-      glColor4f(1.0f, 0.84f, 0.0f, 0.2f + 0.2f * pulse); // Golden glow
+// Magical Particle Ring (Spinning) around unopened chests, drawn with
+// additive blending
+void DesertLevel::renderChestSparkles(Chest *chest) {
+  float time = glutGet(GLUT_ELAPSED_TIME) / 1000.0f;
+  glPushMatrix();
+  applyChestTransform(chest, time);
+  for (int i = 0; i < 8; i++) {
+    float angle = time * 2.0f + i * (2.0f * 3.14159f / 8.0f);
+    float r = 1.8f; // Radius
+    float px = sin(angle) * r;
+    float pz = cos(angle) * r;
+    float py = sin(time * 3.0f + i) * 0.5f; // Vertical variance
 
-      glutSolidSphere(2.0f, 20, 20); // Larger sphere
-      glDisable(GL_BLEND);
-    }
+    glPushMatrix();
+    glTranslatef(px, py, pz);
+    // Sparkle color (Gold/Magic)
+    glColor4f(1.0f, 0.9f, 0.4f, 0.8f);
+    glScalef(0.15f, 0.15f, 0.15f);
+    PrimitiveCache::solidOctahedron();
+    glPopMatrix();
   }
-
   glPopMatrix();
 }
 
+// Glow of a fallback chest that still holds an orb
+void DesertLevel::addChestGlow(Chest *chest) {
+  float time = glutGet(GLUT_ELAPSED_TIME) / 1000.0f;
+
+  // Pulsing Glow
+  float pulse = 0.5f + 0.5f * sin(time * 4.0f);
+  glows.add(chest->x, chest->y + chestLift(chest, time), chest->z, 2.0f,
+            2.0f, 1.0f, 0.84f, 0.0f, 0.2f + 0.2f * pulse); // Golden glow
+}
+
 void DesertLevel::renderScorpion(Enemy *enemy) {
   // Distance Culling
   float dx = enemy->x - player->getX();
@@ -1196,20 +1669,19 @@ void DesertLevel::renderScorpion(Enemy *enemy) {
   glRotatef(enemy->rotation, 0, 1, 0);
 
   if (snakeModel && snakeModel->getWidth() > 0) {
+    glColor3f(0.6f, 0.4f, 0.2f);
     glScalef(0.05f, 0.05f, 0.05f); // Adjust scale as needed
     snakeModel->render();
   } else {
     // Fallback rendering
     glColor3f(1.0f, 0.0f, 0.0f);
-    glutSolidSphere(0.5f, 20, 20);
+    PrimitiveCache::solidSphere(0.5f, 20, 20);
   }
   glPopMatrix();
 }
 
+// Shown once the portal is active or every orb is collected
 void DesertLevel::renderPortal() {
-  if (!portal->active && player->getOrbsCollected() < totalOrbs)
-    return;
-
   glPushMatrix();
   glTranslatef(portal->x, portal->y, portal->z);
   // glRotatef(portal->rotation, 0, 1, 0); // REMOVED ROTATION
@@ -1226,7 +1698,7 @@ void DesertLevel::renderPortal() {
   glTranslatef(-2.5f, 3.0f, 0);
   glColor3f(0.82f, 0.70f, 0.55f); // Sandstone
   glScalef(1.5f, 6.0f, 1.5f);
-  glutSolidCube(1.0f);
+  PrimitiveCache::solidCube(1.0f);
   glPopMatrix();
 
   // 2. Right Pillar (Monolithic Block)
@@ -1234,7 +1706,7 @@ void DesertLevel::renderPortal() {
   glTranslatef(2.5f, 3.0f, 0);
   glColor3f(0.82f, 0.70f, 0.55f); // Sandstone
   glScalef(1.5f, 6.0f, 1.5f);
-  glutSolidCube(1.0f);
+  PrimitiveCache::solidCube(1.0f);
   glPopMatrix();
 
   // 3. Lintel (Top Beam)
@@ -1242,7 +1714,7 @@ void DesertLevel::renderPortal() {
   glTranslatef(0, 6.5f, 0);
   glColor3f(0.82f, 0.70f, 0.55f); // Sandstone
   glScalef(8.0f, 1.5f, 1.8f);
-  glutSolidCube(1.0f);
+  PrimitiveCache::solidCube(1.0f);
   glPopMatrix();
 
   // 4. Decorative Gold Cornice (Simple Strip)
@@ -1250,12 +1722,21 @@ void DesertLevel::renderPortal() {
   glTranslatef(0, 7.3f, 0);
   glColor3f(1.0f, 0.84f, 0.0f); // Gold
   glScalef(8.2f, 0.3f, 2.0f);
-  glutSolidCube(1.0f);
+  PrimitiveCache::solidCube(1.0f);
+  glPopMatrix();
+
   glPopMatrix();
+}
+
+// Energy field, particles and glow inside the gate, drawn with additive
+// blending
+void DesertLevel::renderPortalField() {
+  glPushMatrix();
+  glTranslatef(portal->x, portal->y, portal->z);
+  float gateScale = 1.5f;
+  glScalef(gateScale, gateScale, gateScale);
 
   // 5. Portal Energy Field (The actual "gate")
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE);
 
   if (portal->active) {
     // Pulsing blue/gold energy
@@ -1269,7 +1750,7 @@ void DesertLevel::renderPortal() {
   glPushMatrix();
   glTranslatef(0, 3.0f, 0);
   glScalef(4.0f, 5.5f, 0.2f);
-  glutSolidCube(1.0f);
+  PrimitiveCache::solidCube(1.0f);
   glPopMatrix();
 
   // Swirling particles effect for active portal
@@ -1286,29 +1767,27 @@ void DesertLevel::renderPortal() {
       glutSolidDodecahedron();
       glPopMatrix();
     }
-
-    // Golden Glow Aura (Large outer glow)
-    float goldenPulse = 0.6f + 0.4f * sin(glutGet(GLUT_ELAPSED_TIME) / 250.0f);
-    glColor4f(1.0f, 0.84f, 0.0f, 0.3f * goldenPulse); // Golden color
-    glPushMatrix();
-    glTranslatef(0, 3.0f, 0);
-    glScalef(3.5f, 5.0f, 3.5f); // Large aura sphere
-    glutSolidSphere(1.0f, 24, 24);
-    glPopMatrix();
-
-    // Bright Golden Core Glow
-    glColor4f(1.0f, 0.9f, 0.4f, 0.5f * goldenPulse); // Bright golden
-    glPushMatrix();
-    glTranslatef(0, 3.0f, 0);
-    glScalef(2.2f, 4.0f, 2.2f); // Mid-sized glow
-    glutSolidSphere(1.0f, 20, 20);
-    glPopMatrix();
   }
 
-  glDisable(GL_BLEND);
   glPopMatrix();
 }
 
+// Golden aura and core of the active gate, centred in its field (the gate
+// is drawn at 1.5x)
+void DesertLevel::addPortalGlow() {
+  float gateScale = 1.5f;
+  float cy = portal->y + 3.0f * gateScale;
+  float goldenPulse = 0.6f + 0.4f * sin(glutGet(GLUT_ELAPSED_TIME) / 250.0f);
+
+  // Golden Glow Aura (Large outer glow)
+  glows.add(portal->x, cy, portal->z, 3.5f * gateScale, 5.0f * gateScale,
+            1.0f, 0.84f, 0.0f, 0.3f * goldenPulse);
+
+  // Bright Golden Core Glow
+  glows.add(portal->x, cy, portal->z, 2.2f * gateScale, 4.0f * gateScale,
+            1.0f, 0.9f, 0.4f, 0.5f * goldenPulse);
+}
+
 // ============================================================================
 // ICE LEVEL IMPLEMENTATION
 // ============================================================================
@@ -1321,7 +1800,19 @@ IceLevel::IceLevel() : Level() {
   icicleSpawnInterval = 3.0f;
 }
 
-IceLevel::~IceLevel() {}
+IceLevel::~IceLevel() {
+  waitForBake(); // bake() fills snow
+}
+
+void IceLevel::queueAssets(AssetBatch &batch) {
+  queueCommonAssets(batch);
+  if (TextureAtlas::enabled) {
+    batch.addAtlas({"assets/snow_ground.bmp", "assets/ice_wall.bmp"});
+  } else {
+    batch.addTexture("assets/snow_ground.bmp");
+    batch.addTexture("assets/ice_wall.bmp");
+  }
+}
 
 void IceLevel::init(Player *p) {
   player = p;
@@ -1333,6 +1824,10 @@ void IceLevel::init(Player *p) {
   // Set Snow Physics (Low acceleration, Low friction/sliding, Higher max speed)
   player->setPhysics(15.0f, 1.5f, 9.0f);
 
+  finishPreparing();
+}
+
+void IceLevel::setup() {
   // Cold blue lighting
   sunLight.position = {0, 50, 0, 1};
   sunLight.ambient = {0.3f, 0.35f, 0.4f, 1.0f}; // Cool ambient
@@ -1344,21 +1839,82 @@ void IceLevel::init(Player *p) {
 
   portal = new Portal(0, 1, -35);
 
-  loadCommonAssets();
+  loadCommonAssets(queueAssets);
+}
+
+void IceLevel::acquireTextures() {
+  Level::acquireTextures();
+  loadSurfaceTextures("assets/snow_ground.bmp", "assets/ice_wall.bmp",
+                      snowTexture, iceWallTexture);
+}
+
+void IceLevel::bake() {
+  bakeStaticGeometry(staticGeometry, sunLight);
+
+  // Initialize snow particles (flakes 0.2 units across over the arena)
+  snow.init(Snowfall::defaultCount, 50.0f, 50.0f, 0.2f);
+}
+
+void IceLevel::bakeStaticGeometry(StaticGeometry &target,
+                                  const LightSource &sun) {
+  target.release();
 
-  // Load ice-specific textures
-  snowTexture = loadBMP("assets/snow_ground.bmp");
-  iceWallTexture = loadBMP("assets/ice_wall.bmp");
+  // Icy ground with high specularity, cold blue sky, icy blue walls
+  bakeGround(
+      target.group(RenderState(BLEND_NONE, true, groundSurface.id, 100.0f)),
+      50, groundSurface);
+  bakeSkybox(target.group(RenderState(BLEND_NONE, false), false), 0.6f,
+             0.7f, 0.85f);
+  bakeWalls(target.group(RenderState(BLEND_NONE, true, wallSurface.id)), 45,
+            8, wallSurface);
 
-  // Initialize snow particles
-  for (int i = 0; i < 2000; i++) { // Increased to 2000 for "a lot" of snow
-    Snowflake s;
-    s.x = (rand() % 100) - 50.0f;
-    s.y = (rand() % 50);
-    s.z = (rand() % 100) - 50.0f;
-    s.speed = 2.0f + (float)(rand() % 100) / 50.0f;
-    snowParticles.push_back(s);
+  // One group() call per transparent piece, so each is depth sorted alone
+  for (auto obs : obstacles) {
+    float x = obs->x, y = obs->y, z = obs->z;
+    if (obs->type == ICE_PILLAR) {
+      // Professional Ice Material on the shards; the core glows unlit
+      bakeIcePillar(target.group(RenderState(BLEND_ALPHA, true, 0, 120.0f)),
+                    x, y, z, obs->twists);
+      bakeIcePillarCore(target.group(RenderState(BLEND_ALPHA, false)), x, y,
+                        z);
+    } else if (obs->type == CRYSTAL) {
+      // The glow around it is a sprite, added in render()
+      bakeCrystal(target.group(RenderState()), x, y, z);
+    }
   }
+
+  // Christmas trees and snowmen that have streamed in, placed as render()
+  // places them
+  const SceneryMesh *treeMesh = findSceneryMesh(christmasTreeModel);
+  const SceneryMesh *snowmanMesh = findSceneryMesh(snowmanModel);
+  MeshBuilder &scenery = target.group(RenderState());
+  scenery.color(1.0f, 1.0f, 1.0f);
+  for (auto obs : obstacles) {
+    scenery.pushMatrix();
+    scenery.translate(obs->x, obs->y, obs->z);
+    if (obs->type == CHRISTMAS_TREE && treeMesh) {
+      scenery.scale(0.15f, 0.15f, 0.15f);
+      scenery.mesh(treeMesh->vertices, treeMesh->indices);
+    } else if (obs->type == ROCK && snowmanMesh) {
+      scenery.rotate(180.0f, 0.0f, 1.0f, 0.0f);
+      scenery.mesh(snowmanMesh->vertices, snowmanMesh->indices);
+    }
+    scenery.popMatrix();
+  }
+
+  // The icy ground and pillars keep their live highlights; the walls and
+  // crystals take the crystals' glow for good
+  std::vector<PointLight> bakedLights;
+  for (auto obs : obstacles)
+    if (obs->type == CRYSTAL)
+      bakedLights.push_back(bakedLight(obs->x, obs->y, obs->z, crystalColor,
+                                       1.0f, crystalAttenuation));
+  target.bakeLighting(sun, bakedLights, false);
+  target.buildChunks();
+}
+
+std::vector<const Model *> IceLevel::sceneryModels() const {
+  return {christmasTreeModel.get(), snowmanModel.get()};
 }
 
 void IceLevel::spawnEnemies() {
@@ -1424,6 +1980,10 @@ void IceLevel::spawnObstacles() {
   obstacles.push_back(new Obstacle(-18, 0, 8, 2, 6, 2, ICE_PILLAR));
   obstacles.push_back(new Obstacle(5, 0, -25, 2, 6, 2, ICE_PILLAR));
   obstacles.push_back(new Obstacle(-25, 0, 5, 2, 6, 2, ICE_PILLAR));
+  for (auto obs : obstacles)
+    if (obs->type == ICE_PILLAR)
+      for (float &twist : obs->twists)
+        twist = (float)(rand() % 45); // Random twist of each shard
 
   // Christmas Trees (Nature decoration)
   obstacles.push_back(new Obstacle(15, 0, 5, 2, 5, 2, CHRISTMAS_TREE));
@@ -1571,14 +2131,7 @@ void IceLevel::update(float deltaTime) {
   }
 
   // Update snow particles
-  for (auto &s : snowParticles) {
-    s.y -= s.speed * deltaTime;
-    if (s.y < 0) {
-      s.y = 50.0f;
-      s.x = (rand() % 100) - 50.0f; // Randomize X/Z on respawn for variety
-      s.z = (rand() % 100) - 50.0f;
-    }
-  }
+  snow.update(deltaTime);
 }
 
 void IceLevel::updateTimer(float deltaTime) {
@@ -1643,17 +2196,7 @@ void IceLevel::updateIcicles(float deltaTime) {
         } else if (icicle->y <= 0.5f) {
           // Hit ground - Shatter logic
           playSound(SOUND_ICICLE_CRACK); // Shatter sound
-          // Spawn shatter particles (simple burst using existing snow system
-          // for now, or just logic)
-          for (int j = 0; j < 20; j++) {
-            Snowflake s;
-            s.x = icicle->x + (rand() % 20 - 10) / 20.0f;
-            s.y = 0.5f;
-            s.z = icicle->z + (rand() % 20 - 10) / 20.0f;
-            s.speed = -5.0f; // Fly up? No, simpler to just delete for now or
-                             // reuse particle system if accessible
-            // Actually, we can just delete. The sound is the key feedback.
-          }
+          // The sound is the key feedback
           traps.erase(traps.begin() + i);
         }
       }
@@ -1738,92 +2281,75 @@ void IceLevel::reset() {
   traps.clear();
 }
 
-void IceLevel::renderIcePillar(float x, float y, float z) {
-  glPushMatrix();
-  glTranslatef(x, y, z);
-
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-  // Professional Ice Material
-  GLfloat iceSpec[] = {1.0f, 1.0f, 1.0f, 1.0f};
-  glMaterialfv(GL_FRONT, GL_SPECULAR, iceSpec);
-  glMaterialf(GL_FRONT, GL_SHININESS, 120.0f);
+// Baked alpha blended with the shiny ice material
+void IceLevel::bakeIcePillar(MeshBuilder &mesh, float x, float y, float z,
+                             const float *twists) {
+  mesh.pushMatrix();
+  mesh.translate(x, y, z);
 
   // Icy Blue Color with transparency
-  glColor4f(0.5f, 0.7f, 1.0f, 0.7f);
+  mesh.color(0.5f, 0.7f, 1.0f, 0.7f);
 
   // 1. Central Main Shard (Large Hexagonal Crystal)
-  glPushMatrix();
-  glScalef(1.2f, 1.5f, 1.2f);
-  glRotatef(-90, 1, 0, 0); // Upright
+  mesh.pushMatrix();
+  mesh.scale(1.2f, 1.5f, 1.2f);
+  mesh.rotate(-90, 1, 0, 0); // Upright
 
   // Base shaft
-  GLUquadric *quad = gluNewQuadric();
-  gluCylinder(quad, 1.0f, 0.6f, 4.0f, 6, 1); // Tapering slightly
+  mesh.cylinder(1.0f, 0.6f, 4.0f, 6, 1); // Tapering slightly
 
   // Pointed Top
-  glPushMatrix();
-  glTranslatef(0, 0, 4.0f);
-  glutSolidCone(0.6f, 1.5f, 6, 1);
-  glPopMatrix();
+  mesh.pushMatrix();
+  mesh.translate(0, 0, 4.0f);
+  mesh.solidCone(0.6f, 1.5f, 6, 1);
+  mesh.popMatrix();
 
-  gluDeleteQuadric(quad);
-  glPopMatrix();
+  mesh.popMatrix();
 
   // 2. Surrounding Crystal Clusters
   for (int i = 0; i < 5; i++) {
-    glPushMatrix();
+    mesh.pushMatrix();
     float angle = i * 72.0f;
-    glRotatef(angle, 0, 1, 0);
-    glTranslatef(0.8f, 0, 0);            // Move out
-    glRotatef(15.0f, 0, 0, 1);           // Tilt outward
-    glRotatef(rand() % 45, 0, 1, 0);     // Random twist
+    mesh.rotate(angle, 0, 1, 0);
+    mesh.translate(0.8f, 0, 0);          // Move out
+    mesh.rotate(15.0f, 0, 0, 1);         // Tilt outward
+    mesh.rotate(twists[i], 0, 1, 0);     // Rolled in spawnObstacles()
     float scale = 0.5f + (i % 3) * 0.2f; // Varied sizes
 
-    glScalef(scale, scale * 1.5f, scale);
-    glRotatef(-90, 1, 0, 0); // Upright
+    mesh.scale(scale, scale * 1.5f, scale);
+    mesh.rotate(-90, 1, 0, 0); // Upright
 
     // Small crystal shard
-    glutSolidCone(0.5f, 3.0f, 5, 1);
+    mesh.solidCone(0.5f, 3.0f, 5, 1);
 
-    glPopMatrix();
+    mesh.popMatrix();
   }
 
-  // 3. Inner Glow (Core)
-  glDisable(GL_LIGHTING);
-  glColor4f(0.8f, 0.9f, 1.0f, 0.9f); // Bright core
-  glPushMatrix();
-  glScalef(0.4f, 4.0f, 0.4f);
-  glutSolidSphere(1.0f, 8, 8);
-  glPopMatrix();
-  glEnable(GL_LIGHTING);
+  mesh.popMatrix();
+}
 
-  // Reset material defaults
-  glMaterialf(GL_FRONT, GL_SHININESS, 0.0f);
-  glDisable(GL_BLEND);
-  glPopMatrix();
+// Inner Glow (Core), baked alpha blended without lighting
+void IceLevel::bakeIcePillarCore(MeshBuilder &mesh, float x, float y,
+                                 float z) {
+  mesh.pushMatrix();
+  mesh.translate(x, y, z);
+  mesh.color(0.8f, 0.9f, 1.0f, 0.9f); // Bright core
+  mesh.scale(0.4f, 4.0f, 0.4f);
+  mesh.solidSphere(1.0f, 8, 8);
+  mesh.popMatrix();
 }
 
-void IceLevel::renderCrystal(float x, float y, float z) {
-  glPushMatrix();
-  glTranslatef(x, y, z);
+void IceLevel::bakeCrystal(MeshBuilder &mesh, float x, float y, float z) {
+  mesh.pushMatrix();
+  mesh.translate(x, y, z);
 
   // Glowing crystal
-  glColor3f(0.4f, 0.7f, 1.0f);
-  glRotatef(45, 0, 1, 0);
-  glScalef(0.5f, 1.5f, 0.5f);
-  glutSolidOctahedron();
-
-  // Glow effect
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-  glColor4f(0.4f, 0.7f, 1.0f, 0.3f);
-  glScalef(1.5f, 1.5f, 1.5f);
-  glutSolidSphere(1.0f, 12, 12);
-  glDisable(GL_BLEND);
+  mesh.color(0.4f, 0.7f, 1.0f);
+  mesh.rotate(45, 0, 1, 0);
+  mesh.scale(0.5f, 1.5f, 0.5f);
+  mesh.solidOctahedron();
 
-  glPopMatrix();
+  mesh.popMatrix();
 }
 
 void IceLevel::renderIcicle(Trap *icicle) {
@@ -1833,27 +2359,25 @@ void IceLevel::renderIcicle(Trap *icicle) {
   if (icicle->type == FALLING_ICICLE) {
     // Render as Ice Ball (Sphere)
     glColor3f(0.8f, 0.9f, 1.0f);   // Ice color
-    glutSolidSphere(1.0f, 16, 16); // Ice ball
+    PrimitiveCache::solidSphere(1.0f, 16, 16); // Ice ball
   } else if (icicle->type == SPIKE_TRAP) {
     // Render as Spike Trap (Ground Trap)
     if (trapModel && trapModel->getWidth() > 0) {
+      glColor3f(0.4f, 0.4f, 0.4f);
       glScalef(0.2f, 0.2f, 0.2f); // Adjust scale as needed
       trapModel->render();
     } else {
       // Fallback
       glColor3f(0.5f, 0.5f, 0.5f);
-      glutSolidCone(0.5f, 1.0f, 8, 1);
+      PrimitiveCache::solidCone(0.5f, 1.0f, 8, 1);
     }
   }
 
   glPopMatrix();
 }
 
+// Drawn alpha blended without lighting
 void IceLevel::renderWarningCircle(float x, float z, float radius) {
-  glDisable(GL_LIGHTING);
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
   glPushMatrix();
   glTranslatef(x, 0.05f, z);
   glRotatef(-90, 1, 0, 0);
@@ -1881,8 +2405,6 @@ void IceLevel::renderWarningCircle(float x, float z, float radius) {
   glEnd();
 
   glPopMatrix();
-  glDisable(GL_BLEND);
-  glEnable(GL_LIGHTING);
 }
 
 void IceLevel::renderIceElemental(Enemy *enemy) {
@@ -1892,7 +2414,7 @@ void IceLevel::renderIceElemental(Enemy *enemy) {
 
   // Crystalline body
   glColor3f(0.6f, 0.8f, 1.0f);
-  glutSolidSphere(0.7f, 12, 12);
+  PrimitiveCache::solidSphere(0.7f, 12, 12);
 
   // Floating shards around it
   float time = glutGet(GLUT_ELAPSED_TIME) / 1000.0f;
@@ -1903,32 +2425,23 @@ void IceLevel::renderIceElemental(Enemy *enemy) {
     glTranslatef(1.2f, sin(time * 2 + i) * 0.3f, 0);
     glRotatef(time * 100 + i * 30, 1, 1, 0);
     glScalef(0.2f, 0.5f, 0.1f);
-    glutSolidCube(1.0f);
+    PrimitiveCache::solidCube(1.0f);
     glPopMatrix();
   }
 
   glPopMatrix();
 }
 
+// Shown while the portal is active, drawn with additive blending
 void IceLevel::renderPortal() {
-  if (!portal->active)
-    return;
-
   glPushMatrix();
   glTranslatef(portal->x, portal->y + 2, portal->z);
   glRotatef(portal->rotation, 0, 1, 0);
   glScalef(portal->scale, portal->scale, portal->scale);
 
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-
   glColor4f(0.4f, 0.7f, 1.0f, 0.7f);
-  glutSolidTorus(0.3f, 2.0f, 20, 30);
+  PrimitiveCache::solidTorus(0.3f, 2.0f, 20, 30); // The glow inside is a sprite
 
-  glColor4f(0.6f, 0.9f, 1.0f, 0.5f);
-  glutSolidSphere(1.8f, 20, 20);
-
-  glDisable(GL_BLEND);
   glPopMatrix();
 }
 
@@ -1937,7 +2450,7 @@ void IceLevel::renderTimer3D() {
   if (timeLeft < 0)
     timeLeft = 0;
 
-  glDisable(GL_LIGHTING);
+  // Drawn without lighting
   glPushMatrix();
 
   // Position timer in 3D space above portal area
@@ -1964,25 +2477,22 @@ void IceLevel::renderTimer3D() {
     glColor3f(1.0f, 1.0f, 1.0f);
   }
 
-  // Render time as 3D numbers
+  // Render time as 3D numbers, one unit apart (50 stroke units at 0.02),
+  // from lines rebuilt only when the displayed seconds change
   char timeStr[16];
   sprintf(timeStr, "%.0f", timeLeft);
+  timerLabel.set(timeStr, 50.0f);
 
-  float x = -0.5f * strlen(timeStr);
-  for (char *c = timeStr; *c != '\0'; c++) {
-    glPushMatrix();
-    glTranslatef(x, 0, 0);
-    glScalef(0.02f, 0.03f, 0.02f);
-    glutStrokeCharacter(GLUT_STROKE_ROMAN, *c);
-    glPopMatrix();
-    x += 1.0f;
-  }
+  glTranslatef(-0.5f * strlen(timeStr), 0, 0);
+  glScalef(0.02f, 0.03f, 0.02f);
+  timerLabel.draw();
 
   glPopMatrix();
-  glEnable(GL_LIGHTING);
 }
 
 void IceLevel::render() {
+  updateRebake();
+
   glEnable(GL_LIGHT0);
   glLightfv(GL_LIGHT0, GL_POSITION, sunLight.position.data());
   glLightfv(GL_LIGHT0, GL_AMBIENT, sunLight.ambient.data());
@@ -1992,120 +2502,166 @@ void IceLevel::render() {
   // Reset color to white to prevent state leakage (e.g. from red timer)
   glColor3f(1.0f, 1.0f, 1.0f);
 
-  renderIceEnvironment();
+  // Everything below except the snow is culled (the baked static geometry
+  // by chunk), and everything but that geometry goes through the render
+  // queue
+  frustum.extract();
+  gatherLights();
+  queue.begin();
+  lights.bind(player->getX(), player->getY(), player->getZ());
+  staticGeometry.drawOpaque(frustum, occlusion);
+  staticGeometry.drawDynamicLights(frustum, occlusion, lights);
+  glows.clear();
+  RenderState solid;
+
+  // Every flake in one draw, unlit
+  queue.submit(RenderState(BLEND_NONE, false), player->getX(), player->getY(),
+               player->getZ(), [=] {
+                 glColor3f(1.0f, 1.0f, 1.0f);
+                 snow.render();
+               });
 
   for (auto enemy : enemies) {
-    renderIceElemental(enemy);
+    if (sphereVisible(enemy->x, enemy->y, enemy->z, 1.7f))
+      queue.submit(solid, enemy->x, enemy->y, enemy->z,
+                   [=] { renderIceElemental(enemy); });
   }
 
+  // Ground spike traps share one instanced draw
+  bool trapReady = trapModel && trapModel->getWidth() > 0;
+  float trapMargin = modelMargin(trapModel, 0.2f, 1.0f);
+  trapInstances.clear();
   for (auto icicle : traps) {
     if (icicle->showWarning) {
-      renderWarningCircle(icicle->x, icicle->z, icicle->radius);
+      if (sphereVisible(icicle->x, 0.0f, icicle->z, icicle->radius))
+        queue.submit(RenderState(BLEND_ALPHA, false), icicle->x, 0.0f,
+                     icicle->z, [=] {
+                       renderWarningCircle(icicle->x, icicle->z,
+                                           icicle->radius);
+                     });
+    } else if (!sphereVisible(icicle->x, icicle->y, icicle->z, trapMargin)) {
+      continue;
+    } else if (icicle->type == SPIKE_TRAP && trapReady) {
+      trapInstances.add(Transform()
+                            .translate(icicle->x, icicle->y, icicle->z)
+                            .scale(0.2f),
+                        icicle->x, icicle->y, icicle->z, trapMargin);
     } else {
-      renderIcicle(icicle);
+      queue.submit(solid, icicle->x, icicle->y, icicle->z,
+                   [=] { renderIcicle(icicle); });
     }
   }
+  trapInstances.submit(queue, solid,
+                       [=](const Transform *transforms, size_t count) {
+                         glColor3f(0.4f, 0.4f, 0.4f); // Desert traps' steel
+                         trapModel->renderInstances(transforms, count);
+                       });
+
+  bool treeReady = christmasTreeModel && christmasTreeModel->getWidth() > 0;
+  bool snowmanReady = snowmanModel && snowmanModel->getWidth() > 0;
+  float treeMargin = modelMargin(christmasTreeModel, 0.15f, 2.0f);
+  float snowmanMargin = modelMargin(snowmanModel, 1.0f, 1.0f);
+  treeInstances.clear();
+  snowmanInstances.clear();
   for (auto obs : obstacles) {
-    if (obs->type == ICE_PILLAR) {
-      renderIcePillar(obs->x, obs->y, obs->z);
-    } else if (obs->type == CRYSTAL) {
-      renderCrystal(obs->x, obs->y, obs->z);
-    } else if (obs->type == CHRISTMAS_TREE) {
-      glPushMatrix();
-      glTranslatef(obs->x, obs->y, obs->z);
-      if (christmasTreeModel && christmasTreeModel->getWidth() > 0) {
-        glScalef(0.15f, 0.15f,
-                 0.15f);             // Increased scale from 0.05f to 0.15f
-        glColor3f(1.0f, 1.0f, 1.0f); // Reset color to white
-        christmasTreeModel->render();
+    // Glow effect around a crystal (0.75 x 2.25 x 0.75)
+    if (obs->type == CRYSTAL && sphereVisible(obs->x, obs->y, obs->z, 2.25f))
+      glows.add(obs->x, obs->y, obs->z, 0.75f, 2.25f, 0.4f, 0.7f, 1.0f, 0.3f);
+    if (obs->type == ICE_PILLAR || obs->type == CRYSTAL)
+      continue; // Baked
+    if ((obs->type == CHRISTMAS_TREE && isBaked(christmasTreeModel)) ||
+        (obs->type == ROCK && isBaked(snowmanModel)))
+      continue; // Baked once streamed in
+    float margin = obs->type == CHRISTMAS_TREE ? treeMargin
+                   : obs->type == ROCK         ? snowmanMargin
+                                               : 1.0f;
+    if (!obstacleVisible(obs, margin))
+      continue;
+    float x = obs->x, y = obs->y, z = obs->z;
+    if (obs->type == CHRISTMAS_TREE) {
+      if (treeReady) {
+        treeInstances.add(
+            Transform()
+                .translate(x, y, z)
+                .scale(0.15f), // Increased scale from 0.05f to 0.15f
+            x, y, z, treeMargin);
       } else {
         // Fallback: Green cone
-        glColor3f(0.0f, 0.5f, 0.0f);
-        glRotatef(-90, 1, 0, 0);
-        glutSolidCone(2.0f, 5.0f, 8, 1);
+        queue.submit(solid, x, y, z, [=] {
+          glPushMatrix();
+          glTranslatef(x, y, z);
+          glColor3f(0.0f, 0.5f, 0.0f);
+          glRotatef(-90, 1, 0, 0);
+          PrimitiveCache::solidCone(2.0f, 5.0f, 8, 1);
+          glPopMatrix();
+        });
       }
-      glPopMatrix();
     } else if (obs->type == ROCK) { // We're using ROCK type for snowmen
-      renderSnowman(obs->x, obs->y, obs->z);
+      if (snowmanReady)
+        snowmanInstances.add(Transform()
+                                 .translate(x, y, z)
+                                 .rotate(180.0f, 0.0f, 1.0f, 0.0f),
+                             x, y, z, snowmanMargin);
+      else
+        queue.submit(solid, x, y, z, [=] { renderSnowman(x, y, z); });
     }
   }
+  // White for trees and snowmen
+  treeInstances.submit(queue, solid,
+                       [=](const Transform *transforms, size_t count) {
+                         glColor3f(1.0f, 1.0f, 1.0f);
+                         christmasTreeModel->renderInstances(transforms,
+                                                             count);
+                       });
+  snowmanInstances.submit(queue, solid,
+                          [=](const Transform *transforms, size_t count) {
+                            glColor3f(1.0f, 1.0f, 1.0f);
+                            snowmanModel->renderInstances(transforms, count);
+                          });
+
+  if (portal && portal->active &&
+      sphereVisible(portal->x, portal->y + 5.0f, portal->z, 10.0f)) {
+    queue.submit(RenderState(BLEND_ADDITIVE), portal->x, portal->y + 2.0f,
+                 portal->z, [=] { renderPortal(); });
+    float radius = 1.8f * portal->scale;
+    glows.add(portal->x, portal->y + 2.0f, portal->z, radius, radius, 0.6f,
+              0.9f, 1.0f, 0.5f);
+  }
+  queue.submit(RenderState(BLEND_NONE, false), portal->x, 8.0f,
+               portal->z - 10.0f, [=] { renderTimer3D(); });
+  staticGeometry.submitTransparent(queue, frustum, occlusion);
+  glows.submit(queue, player->getX(), player->getY(), player->getZ());
+  queue.flush();
+  lights.bind(player->getX(), player->getY(), player->getZ()); // For player
+}
 
-  if (portal)
-    renderPortal();
-  renderTimer3D();
+void IceLevel::gatherLights() {
+  lights.clear();
 
-  // --- RED WARNING LIGHT FOR ICICLES (GL_LIGHT2) ---
-  bool warningActive = false;
-  float wx, wz;
+  // Red pulse under every icicle about to fall, kept local
+  float pulse = 0.5f + 0.5f * sin(glutGet(GLUT_ELAPSED_TIME) * 0.02f);
   for (auto icicle : traps) {
-    if (icicle->showWarning) {
-      warningActive = true;
-      wx = icicle->x;
-      wz = icicle->z;
-      break; // One light for now
-    }
+    if (icicle->showWarning)
+      lights.add(icicle->x, 2.0f, icicle->z, 1.0f * pulse, 0.0f, 0.0f, 1.0f,
+                 0.5f, 0.2f, true);
   }
 
-  if (warningActive) {
-    glEnable(GL_LIGHT2);
-    float pulse = 0.5f + 0.5f * sin(glutGet(GLUT_ELAPSED_TIME) * 0.02f);
-    GLfloat lightPos[] = {wx, 2.0f, wz, 1.0f};
-    GLfloat lightColor[] = {1.0f * pulse, 0.0f, 0.0f, 1.0f};
-    glLightfv(GL_LIGHT2, GL_POSITION, lightPos);
-    glLightfv(GL_LIGHT2, GL_DIFFUSE, lightColor);
-    glLightfv(GL_LIGHT2, GL_SPECULAR, lightColor);
-
-    // Attenuation to keep it local
-    glLightf(GL_LIGHT2, GL_CONSTANT_ATTENUATION, 1.0f);
-    glLightf(GL_LIGHT2, GL_LINEAR_ATTENUATION, 0.5f);
-    glLightf(GL_LIGHT2, GL_QUADRATIC_ATTENUATION, 0.2f);
-  } else {
-    glDisable(GL_LIGHT2);
+  // Cold glow around each crystal, baked into the static geometry
+  for (auto obs : obstacles) {
+    if (obs->type == CRYSTAL)
+      lights.add(obs->x, obs->y, obs->z, crystalColor[0], crystalColor[1],
+                 crystalColor[2], crystalAttenuation[0], crystalAttenuation[1],
+                 crystalAttenuation[2], false, true);
   }
 
-  // --- PORTAL PULSING LIGHT (GL_LIGHT3) ---
+  // Portal pulsing light (gold), reaching across the level
   if (portal && portal->active) {
-    glEnable(GL_LIGHT3);
-    float pulse = 0.8f + 0.2f * sin(glutGet(GLUT_ELAPSED_TIME) * 0.005f);
-    GLfloat lightPos[] = {portal->x, portal->y + 2.0f, portal->z, 1.0f};
-    GLfloat lightColor[] = {1.0f * pulse, 0.8f, 0.2f, 1.0f}; // Gold
-    glLightfv(GL_LIGHT3, GL_POSITION, lightPos);
-    glLightfv(GL_LIGHT3, GL_DIFFUSE, lightColor);
-    glLightf(GL_LIGHT3, GL_LINEAR_ATTENUATION, 0.1f);
-  } else {
-    glDisable(GL_LIGHT3);
+    float portalPulse = 0.8f + 0.2f * sin(glutGet(GLUT_ELAPSED_TIME) * 0.005f);
+    lights.add(portal->x, portal->y + 2.0f, portal->z, 1.0f * portalPulse,
+               0.8f, 0.2f, 1.0f, 0.1f, 0.0f);
   }
 }
 
-void IceLevel::renderIceEnvironment() {
-  // Render icy ground with high specularity
-  glEnable(GL_LIGHTING);
-  glMaterialfv(GL_FRONT, GL_SPECULAR, (GLfloat[]){1.0f, 1.0f, 1.0f, 1.0f});
-  glMaterialf(GL_FRONT, GL_SHININESS, 100.0f); // High shininess for ice
-
-  renderGround(50, snowTexture);
-
-  // Reset material properties
-  glMaterialfv(GL_FRONT, GL_SPECULAR, (GLfloat[]){0.0f, 0.0f, 0.0f, 1.0f});
-  glMaterialf(GL_FRONT, GL_SHININESS, 0.0f);
-
-  // Cold blue sky
-  renderSkybox(0.6f, 0.7f, 0.85f);
-
-  // Icy blue walls
-  renderWalls(45, 8, iceWallTexture);
-
-  // Render snow particles as small spheres for better visibility
-  glDisable(GL_LIGHTING);
-  glColor3f(1.0f, 1.0f, 1.0f);
-  for (const auto &s : snowParticles) {
-    glPushMatrix();
-    glTranslatef(s.x, s.y, s.z);
-    glutSolidSphere(0.1f, 4, 4); // Small sphere
-    glPopMatrix();
-  }
-  glEnable(GL_LIGHTING);
-}
 void IceLevel::renderSnowman(float x, float y, float z) {
   glPushMatrix();
   glTranslatef(x, y, z);
@@ -2127,19 +2683,19 @@ void IceLevel::renderSnowman(float x, float y, float z) {
     // Bottom sphere
     glPushMatrix();
     glTranslatef(0, 0.8f, 0);
-    glutSolidSphere(0.8f, 16, 16);
+    PrimitiveCache::solidSphere(0.8f, 16, 16);
     glPopMatrix();
 
     // Middle sphere
     glPushMatrix();
     glTranslatef(0, 1.8f, 0);
-    glutSolidSphere(0.6f, 16, 16);
+    PrimitiveCache::solidSphere(0.6f, 16, 16);
     glPopMatrix();
 
     // Head sphere
     glPushMatrix();
     glTranslatef(0, 2.6f, 0);
-    glutSolidSphere(0.4f, 16, 16);
+    PrimitiveCache::solidSphere(0.4f, 16, 16);
     glPopMatrix();
 
     // Carrot nose
@@ -2147,7 +2703,7 @@ void IceLevel::renderSnowman(float x, float y, float z) {
     glPushMatrix();
     glTranslatef(0, 2.6f, 0.4f);
     glRotatef(90, 1, 0, 0);
-    glutSolidCone(0.1f, 0.3f, 8, 1);
+    PrimitiveCache::solidCone(0.1f, 0.3f, 8, 1);
     glPopMatrix();
   }
 
@@ -5,8 +5,18 @@
 #ifndef LEVEL_H
 #define LEVEL_H
 
+#include "assets.h"
+#include "atlas.h"
+#include "frustum.h"
+#include "glow.h"
+#include "hud.h"
+#include "lights.h"
 #include "model.h"
+#include "occlusion.h"
 #include "player.h"
+#include "renderqueue.h"
+#include "snowfall.h"
+#include "staticgeometry.h"
 #include "utils.h"
 #ifdef __APPLE__
 #include <GLUT/glut.h>
@@ -14,8 +24,12 @@
 #include <GL/glut.h>
 #endif
 #include <cmath>
+#include <functional>
+#include <future>
 #include <vector>
 
+class AssetBatch;
+
 // ============================================================================
 // ENTITY STRUCTURES
 // ============================================================================
@@ -80,10 +94,14 @@ struct Obstacle {
   float x, y, z;
   float width, height, depth;
   ObstacleType type;
+  // Ice pillars: twist of each surrounding shard in degrees, rolled once at
+  // spawn so every bake of the pillar comes out the same
+  float twists[5];
 
   Obstacle(float px, float py, float pz, float w, float h, float d,
            ObstacleType t)
-      : x(px), y(py), z(pz), width(w), height(h), depth(d), type(t) {}
+      : x(px), y(py), z(pz), width(w), height(h), depth(d), type(t),
+        twists{0, 0, 0, 0, 0} {}
 };
 
 struct Portal {
@@ -110,6 +128,33 @@ struct Chest {
         hasCoins(coins) {}
 };
 
+// Instances of one model, grouped by LightManager cell. Each group is drawn
+// as one queue item at its centroid, with a radius covering its instances,
+// so it is lit by the point lights around it rather than around the player.
+class InstanceClusters {
+private:
+  struct Cluster {
+    int cx, cz;
+    std::vector<Transform> transforms;
+    std::vector<float> bounds; // x, y, z, radius per instance
+  };
+  std::vector<Cluster> clusters; // Kept across frames to reuse storage
+  size_t used;
+
+public:
+  InstanceClusters() : used(0) {}
+
+  void clear();
+  bool empty() const { return used == 0; }
+  // An instance whose bounding sphere is centred at x, y, z
+  void add(const Transform &transform, float x, float y, float z,
+           float radius);
+  // One item per cluster; draw gets the cluster's transforms. They stay
+  // valid until the next clear() or add().
+  void submit(RenderQueue &queue, const RenderState &state,
+              std::function<void(const Transform *, size_t)> draw) const;
+};
+
 // ============================================================================
 // BASE LEVEL CLASS
 // ============================================================================
@@ -130,27 +175,106 @@ protected:
 
   // Lighting
   LightSource sunLight;
-  std::vector<LightSource> lights;
+  // Torches, orbs, portals, crystals etc., refilled every frame; the queue
+  // binds the nearest few to each lit item
+  LightManager lights;
 
   // Resources
-  Texture wallTexture;
-  Texture groundTexture;
+  TextureHandle wallTexture;
+  TextureHandle groundTexture;
+  // Ground and wall surfaces: regions of surfaceAtlas, or whole registry
+  // textures when the atlas is off
+  TextureHandle surfaceAtlas;
+  TextureRegion groundSurface;
+  TextureRegion wallSurface;
   // Sphinx removed
-  static Model *pillarModel;
-  Model *treeModel;
-  Model *rockModel;
-  Model *groundModel;
-  Model *cactusModel; // NEW
+  ModelHandle pillarModel;
+  ModelHandle treeModel;
+  ModelHandle rockModel;
+  ModelHandle groundModel;
+  ModelHandle cactusModel; // NEW
   // pyramidModel removed
-  static Model *snowmanModel;
-  static Model *christmasTreeModel;
-  static Model *snakeModel;
-  static Model *trapModel;
-  static Model *chestModel;
+  ModelHandle snowmanModel;
+  ModelHandle christmasTreeModel;
+  ModelHandle snakeModel;
+  ModelHandle trapModel;
+  ModelHandle chestModel;
+
+  // View volume of the frame being rendered (extracted in render())
+  Frustum frustum;
+  // Depth of the large occluders this frame; levels that rasterize none
+  // never begin() it, so it occludes nothing
+  OcclusionBuffer occlusion;
+  // Entity draws of the frame, sorted by the state they need
+  RenderQueue queue;
+  // Ground, sky, walls, the procedural obstacles and the scenery models,
+  // baked by bake() and re-baked as scenery meshes stream in
+  StaticGeometry staticGeometry;
+  // The frame's soft glows, queued as one draw
+  GlowBatch glows;
+
+  // Per-frame transforms for the instanced model draws (members so their
+  // storage is reused)
+  InstanceClusters pillarInstances;
+  InstanceClusters trapInstances;
+
+  // Level content that does not depend on the player, in two halves:
+  // setup() runs on the GL thread (sun, spawns, portal, registry assets),
+  // bake() on the thread pool (the static geometry and any other CPU-only
+  // work; no GL calls). prepare() starts both.
+  virtual void setup() = 0;
+  virtual void bake() = 0;
+  // Everything static into target, lit by sun, with the scenery meshes of
+  // bakedMeshes; CPU only, run from bake() and re-bakes
+  virtual void bakeStaticGeometry(StaticGeometry &target,
+                                  const LightSource &sun) = 0;
+
+  // Model meshes baked into the static geometry, copied on the GL thread
+  // before a bake starts and only read by the bake job
+  struct SceneryMesh {
+    const Model *model;
+    std::vector<MeshVertex> vertices;
+    std::vector<unsigned int> indices;
+  };
+  std::vector<SceneryMesh> bakedMeshes;
+  // Models whose instances the static geometry being drawn holds; render()
+  // skips those and draws the others live
+  std::vector<const Model *> bakedModels;
+  // Models the level bakes once their meshes are resident
+  virtual std::vector<const Model *> sceneryModels() const = 0;
+  // Copies the meshes of scenery models that became resident since the
+  // last call; false if there were none
+  bool captureSceneryMeshes();
+  const SceneryMesh *findSceneryMesh(const ModelHandle &model) const;
+  bool isBaked(const ModelHandle &model) const;
+  // Swaps in a finished re-bake, and starts one when meshesStreamed()
+  // brought new scenery or updateAssets() new surfaces; call at the start
+  // of render()
+  void updateRebake();
+  // The registry textures the level draws with; the levels add their
+  // surfaces. Called once their batch is in (see loadCommonAssets()).
+  virtual void acquireTextures();
+  // Waits for bake() and uploads its result (GL thread); init() ends with it
+  void finishPreparing();
+  // Derived destructors call this first: bake() may still use their members
+  void waitForBake();
 
-public:
-  static void cleanupCommonAssets();
+private:
+  std::future<void> bakeJob;
+  // Re-bake into rebuiltGeometry, swapped with staticGeometry when done
+  std::future<void> rebakeJob;
+  StaticGeometry rebuiltGeometry;
+  bool rebakePending;
+  // Textures still decoding when streaming, and whether they have since
+  // replaced the surfaces the static geometry was baked with
+  AssetBatch *textureBatch;
+  bool surfacesChanged;
+  bool prepareStarted;
+  double bakeMs;     // bake() on the worker
+  double bakeWaitMs; // finishPreparing() blocked on it
+  double uploadMs;
 
+public:
   Level();
   virtual ~Level();
 
@@ -158,6 +282,21 @@ public:
     return (exitTimer > 0.0f) ? (exitTimer / 2.0f) : 0.0f; // 2 seconds fade
   }
 
+  // Runs setup() and starts bake(), so a level can be made ready ahead of
+  // the switch to it; init() does this itself if nobody did
+  void prepare();
+  // bake() has finished (never blocks)
+  bool isPrepared() const;
+  double getBakeMs() const { return bakeMs; }
+  double getBakeWaitMs() const { return bakeWaitMs; }
+  double getUploadMs() const { return uploadMs; }
+  // Model::updateStreaming() swapped in meshes; scenery among them is baked
+  // by the next render()
+  void meshesStreamed() { rebakePending = true; }
+  // Uploads the textures a streaming load left decoding once they are in,
+  // and re-bakes the surfaces with them; call once per frame (GL thread)
+  void updateAssets();
+
   virtual void init(Player *p) = 0;
   virtual void update(float deltaTime) = 0;
   virtual void render() = 0;
@@ -166,13 +305,34 @@ public:
   virtual bool isDesert() const = 0;
 
   bool isComplete() const { return levelComplete; }
-
-  // Common render helpers - UPDATED SIGNATURES
-  void renderGround(float size, Texture &texture);
-  void renderSkybox(float r, float g, float b);
-  void renderWalls(float size, float height, Texture &texture);
-
-  void loadCommonAssets();
+  bool isPortalActive() const { return portal && portal->active; }
+  OcclusionBuffer &getOcclusion() { return occlusion; }
+
+  // Common bake helpers, adding to a staticGeometry group's mesh; the
+  // ground's 10 x 10 tiles are split into subdivisions x subdivisions quads
+  void bakeGround(MeshBuilder &mesh, float size, const TextureRegion &surface,
+                  int subdivisions = 1);
+  void bakeSkybox(MeshBuilder &mesh, float r, float g, float b);
+  void bakeWalls(MeshBuilder &mesh, float size, float height,
+                 const TextureRegion &surface);
+
+  // Frustum test, then occlusion test of what survives it
+  bool sphereVisible(float x, float y, float z, float radius) const;
+  // Obstacle bounds from its dimensions, grown by margin on every side
+  bool obstacleVisible(const Obstacle *obs, float margin) const;
+
+  // Acquires the shared models and then acquireTextures(). Without
+  // streaming the level's whole asset list is decoded in parallel first;
+  // with it the models decode as they stream and the textures in a batch
+  // that updateAssets() finishes, unless the registry already holds them.
+  void loadCommonAssets(void (*queueAssets)(AssetBatch &batch));
+  // Acquires the level's ground and wall textures as one registry atlas;
+  // without the atlas they are acquired separately into ground and wall
+  void loadSurfaceTextures(const char *groundPath, const char *wallPath,
+                           TextureHandle &ground, TextureHandle &wall);
+
+  // Adds the models/textures every level uses, for parallel loading
+  static void queueCommonAssets(AssetBatch &batch);
 };
 
 // ============================================================================
@@ -193,8 +353,8 @@ private:
   float maxTime;
 
   // Desert-specific textures
-  Texture sandTexture;
-  Texture desertWallTexture;
+  TextureHandle sandTexture;
+  TextureHandle desertWallTexture;
 
 public:
   DesertLevel();
@@ -206,10 +366,20 @@ public:
   void reset() override;
   void interact(float px, float py, float pz) override;
   bool isDesert() const override { return true; }
+  // Every model/texture the level uses, for loading ahead of init()
+  static void queueAssets(AssetBatch &batch);
 
   int getTotalOrbs() const { return totalOrbs; }
   float getTimeRemaining() const { return levelTimer; }
 
+protected:
+  void setup() override;
+  void bake() override;
+  void bakeStaticGeometry(StaticGeometry &target,
+                          const LightSource &sun) override;
+  std::vector<const Model *> sceneryModels() const override;
+  void acquireTextures() override;
+
 private:
   void spawnOrbs();
   void spawnChests();
@@ -221,17 +391,28 @@ private:
   void updateEnemies(float deltaTime);
   void checkEnemyCollision();
 
-  void renderDesertEnvironment();
-  void renderPillar(float x, float y, float z);
+  // Walls, entrance pillars and pyramids into the occlusion buffer
+  void rasterizeOccluders();
+  // Torch flames, uncollected orbs and the open portal into lights
+  void gatherLights();
+  void bakePillar(MeshBuilder &mesh, float x, float y, float z);
+  void bakePillarShaft(MeshBuilder &mesh, float x, float y, float z);
   void renderPalmTree(float x, float y, float z);
   void renderCactus(float x, float y, float z); // NEW
-  void renderPyramid(float x, float y, float z, float baseSize,
-                     float height); // NEW
+  void bakePyramid(MeshBuilder &mesh, float x, float y, float z,
+                   float baseSize, float height); // NEW
+  void bakePyramidCapstone(MeshBuilder &mesh, float x, float y, float z,
+                           float height);
   void renderRock(float x, float y, float z);
   void renderOrb(Collectible *orb);
+  void addOrbHalo(Collectible *orb);
   void renderChest(Chest *chest);
+  void renderChestSparkles(Chest *chest);
+  void addChestGlow(Chest *chest);
   void renderScorpion(Enemy *enemy);
   void renderPortal();
+  void renderPortalField();
+  void addPortalGlow();
 };
 
 // ============================================================================
@@ -247,14 +428,14 @@ private:
   float icicleSpawnInterval;
 
   // Ice-specific textures
-  Texture snowTexture;
-  Texture iceWallTexture;
+  TextureHandle snowTexture;
+  TextureHandle iceWallTexture;
 
-  struct Snowflake {
-    float x, y, z;
-    float speed;
-  };
-  std::vector<Snowflake> snowParticles;
+  Snowfall snow;
+  StrokeLabel timerLabel; // Countdown above the portal
+
+  InstanceClusters treeInstances;
+  InstanceClusters snowmanInstances;
 
 public:
   IceLevel();
@@ -266,9 +447,18 @@ public:
   void reset() override;
   void interact(float px, float py, float pz) override;
   bool isDesert() const override { return false; }
+  static void queueAssets(AssetBatch &batch);
 
   float getTimeRemaining() const { return maxTime - survivalTimer; }
 
+protected:
+  void setup() override;
+  void bake() override;
+  void bakeStaticGeometry(StaticGeometry &target,
+                          const LightSource &sun) override;
+  std::vector<const Model *> sceneryModels() const override;
+  void acquireTextures() override;
+
 private:
   void spawnEnemies();
   void spawnObstacles();
@@ -279,9 +469,12 @@ private:
   void checkEnemyCollision();
   void spawnSphinx();
 
-  void renderIceEnvironment();
-  void renderIcePillar(float x, float y, float z);
-  void renderCrystal(float x, float y, float z);
+  // Icicle warnings, crystals and the open portal into lights
+  void gatherLights();
+  void bakeIcePillar(MeshBuilder &mesh, float x, float y, float z,
+                     const float *twists);
+  void bakeIcePillarCore(MeshBuilder &mesh, float x, float y, float z);
+  void bakeCrystal(MeshBuilder &mesh, float x, float y, float z);
   void renderIcicle(Trap *icicle);
   void renderWarningCircle(float x, float z, float radius);
   void renderIceElemental(Enemy *enemy);
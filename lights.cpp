@@ -0,0 +1,195 @@
+// ============================================================================
+// Lights.cpp - Point Light Selection Implementation
+// ============================================================================
+
+#include "lights.h"
+#include <algorithm>
+#include <cmath>
+
+int LightManager::budget = 4;
+float LightManager::cellSize = 16.0f;
+float LightManager::maxRange = 48.0f;
+float LightManager::cutoff = 1.0f / 32.0f;
+int LightManager::selectionCount = 0;
+int LightManager::candidateCount = 0;
+int LightManager::slotChanges = 0;
+
+int LightManager::bound[maxLights] = {-1, -1, -1, -1, -1, -1, -1};
+
+long long LightManager::cellKey(int cx, int cz) {
+  return ((long long)cx << 32) ^ (unsigned int)cz;
+}
+
+void LightManager::clear() {
+  lights.clear();
+  unbounded.clear();
+  for (long long key : filledCells)
+    buckets[key].clear();
+  filledCells.clear();
+  // Slots keep their GL state, but the indices no longer mean anything
+  // (positions were also transformed by an older view)
+  for (int i = 0; i < maxLights; i++)
+    if (bound[i] != -1)
+      bound[i] = -2;
+}
+
+void LightManager::add(float x, float y, float z, float r, float g, float b,
+                       float constant, float linear, float quadratic,
+                       bool specular, bool baked) {
+  PointLight light;
+  light.x = x;
+  light.y = y;
+  light.z = z;
+  light.color[0] = r;
+  light.color[1] = g;
+  light.color[2] = b;
+  light.attenuation[0] = constant;
+  light.attenuation[1] = linear;
+  light.attenuation[2] = quadratic;
+  light.specular = specular;
+  light.baked = baked;
+
+  // Distance where brightest * 1 / (c + l*d + q*d^2) reaches the cutoff
+  float brightest = std::max(r, std::max(g, b));
+  float c = constant - brightest / cutoff;
+  if (c >= 0.0f)
+    light.range = -1.0f; // Never bright enough to matter
+  else if (quadratic > 0.0f)
+    light.range = (-linear + sqrtf(linear * linear - 4.0f * quadratic * c)) /
+                  (2.0f * quadratic);
+  else if (linear > 0.0f)
+    light.range = -c / linear;
+  else
+    light.range = 0.0f; // No falloff
+  if (light.range < 0.0f)
+    return;
+
+  int index = (int)lights.size();
+  lights.push_back(light);
+  if (light.range == 0.0f || light.range > maxRange) {
+    unbounded.push_back(index);
+    return;
+  }
+  int x0 = (int)floorf((x - light.range) / cellSize);
+  int x1 = (int)floorf((x + light.range) / cellSize);
+  int z0 = (int)floorf((z - light.range) / cellSize);
+  int z1 = (int)floorf((z + light.range) / cellSize);
+  for (int cx = x0; cx <= x1; cx++) {
+    for (int cz = z0; cz <= z1; cz++) {
+      long long key = cellKey(cx, cz);
+      std::vector<int> &bucket = buckets[key];
+      if (bucket.empty())
+        filledCells.push_back(key);
+      bucket.push_back(index);
+    }
+  }
+}
+
+int LightManager::bind(float x, float y, float z, float radius,
+                       bool skipBaked) {
+  selectionCount++;
+
+  // Score the lights reaching the cells under the object and those
+  // reaching everywhere
+  candidates.clear();
+  if (scoredPass.size() < lights.size())
+    scoredPass.resize(lights.size(), 0);
+  if (++pass == 0) { // Wrapped: older stamps could collide
+    std::fill(scoredPass.begin(), scoredPass.end(), 0);
+    pass = 1;
+  }
+  auto score = [&](int index) {
+    if (scoredPass[index] == pass)
+      return;
+    scoredPass[index] = pass;
+    const PointLight &l = lights[index];
+    if (skipBaked && l.baked)
+      return;
+    float dx = l.x - x, dy = l.y - y, dz = l.z - z;
+    float d = sqrtf(dx * dx + dy * dy + dz * dz) - radius;
+    if (d < 0.0f)
+      d = 0.0f;
+    if (l.range > 0.0f && d > l.range)
+      return;
+    float brightest = std::max(l.color[0], std::max(l.color[1], l.color[2]));
+    float weight = brightest / (l.attenuation[0] + l.attenuation[1] * d +
+                                l.attenuation[2] * d * d);
+    candidates.push_back(std::make_pair(weight, index));
+  };
+  int budgetLights = std::max(0, std::min(budget, (int)maxLights));
+  if (budgetLights > 0) {
+    int x0 = (int)floorf((x - radius) / cellSize);
+    int x1 = (int)floorf((x + radius) / cellSize);
+    int z0 = (int)floorf((z - radius) / cellSize);
+    int z1 = (int)floorf((z + radius) / cellSize);
+    for (int cx = x0; cx <= x1; cx++) {
+      for (int cz = z0; cz <= z1; cz++) {
+        auto cell = buckets.find(cellKey(cx, cz));
+        if (cell != buckets.end())
+          for (int index : cell->second)
+            score(index);
+      }
+    }
+    for (int index : unbounded)
+      score(index);
+  }
+  candidateCount += (int)candidates.size();
+  int count = std::min(budgetLights, (int)candidates.size());
+  std::partial_sort(candidates.begin(), candidates.begin() + count,
+                    candidates.end(),
+                    [](const std::pair<float, int> &a,
+                       const std::pair<float, int> &b) {
+                      return a.first > b.first;
+                    });
+
+  // Lights that keep their slot are left alone; the rest take free slots
+  bool keep[maxLights] = {false};
+  bool placed[maxLights] = {false};
+  for (int i = 0; i < count; i++)
+    for (int s = 0; s < maxLights; s++)
+      if (bound[s] == candidates[i].second) {
+        keep[s] = true;
+        placed[i] = true;
+      }
+  int slot = 0;
+  for (int i = 0; i < count; i++) {
+    if (placed[i])
+      continue;
+    while (keep[slot])
+      slot++;
+    const PointLight &l = lights[candidates[i].second];
+    GLenum id = GL_LIGHT1 + slot;
+    GLfloat position[] = {l.x, l.y, l.z, 1.0f};
+    GLfloat color[] = {l.color[0], l.color[1], l.color[2], 1.0f};
+    GLfloat black[] = {0.0f, 0.0f, 0.0f, 1.0f};
+    if (bound[slot] == -1)
+      glEnable(id);
+    glLightfv(id, GL_POSITION, position);
+    glLightfv(id, GL_DIFFUSE, color);
+    glLightfv(id, GL_SPECULAR, l.specular ? color : black);
+    glLightf(id, GL_CONSTANT_ATTENUATION, l.attenuation[0]);
+    glLightf(id, GL_LINEAR_ATTENUATION, l.attenuation[1]);
+    glLightf(id, GL_QUADRATIC_ATTENUATION, l.attenuation[2]);
+    bound[slot] = candidates[i].second;
+    keep[slot] = true;
+    slotChanges++;
+  }
+  for (int s = 0; s < maxLights; s++) {
+    if (!keep[s] && bound[s] != -1) {
+      glDisable(GL_LIGHT1 + s);
+      bound[s] = -1;
+      slotChanges++;
+    }
+  }
+  return count;
+}
+
+void LightManager::unbindAll() {
+  for (int s = 0; s < maxLights; s++) {
+    if (bound[s] != -1) {
+      glDisable(GL_LIGHT1 + s);
+      bound[s] = -1;
+      slotChanges++;
+    }
+  }
+}
@@ -0,0 +1,90 @@
+// ============================================================================
+// Lights.h - Point Light Selection
+// Holds any number of point lights in a grid of buckets and binds the few
+// that matter most to each drawn object to GL_LIGHT1..7 (GL_LIGHT0 stays
+// the sun)
+// ============================================================================
+
+#ifndef LIGHTS_H
+#define LIGHTS_H
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#ifdef __APPLE__
+#include <GLUT/glut.h>
+#else
+#include <GL/glut.h>
+#endif
+
+struct PointLight {
+    float x, y, z;
+    float color[3];     // Diffuse, and specular when the light has it
+    float attenuation[3]; // GL constant, linear and quadratic terms
+    bool specular;
+    float range;        // Where it falls below cutoff; 0 never does
+    bool baked;         // Already in the static geometry's vertex colours
+};
+
+class LightManager {
+public:
+    static const int maxLights = 7; // GL_LIGHT1..GL_LIGHT7
+
+private:
+    std::vector<PointLight> lights;
+    // Lights reaching each cell of the x/z grid; the vectors are kept
+    // across frames so refilling them does not allocate
+    std::unordered_map<long long, std::vector<int>> buckets;
+    std::vector<long long> filledCells;
+    std::vector<int> unbounded; // Reach further than maxRange
+    std::vector<std::pair<float, int>> candidates;
+    // bind() pass that last scored each light, so a light bucketed in
+    // several of the cells an object overlaps is scored once
+    std::vector<unsigned> scoredPass;
+    unsigned pass = 0;
+    // Light in GL_LIGHT1 + i, -1 when disabled and -2 when left enabled
+    // from an earlier frame (or level); GL state is shared, so this is too
+    static int bound[maxLights];
+
+    static long long cellKey(int cx, int cz);
+
+public:
+    // Forgets the lights and bindings; call at the start of every frame
+    void clear();
+    // A light with GL-style attenuation 1 / (c + l*d + q*d^2); a baked one
+    // also lights the baked static geometry through its vertex colours
+    void add(float x, float y, float z, float r, float g, float b,
+             float constant, float linear, float quadratic,
+             bool specular = false, bool baked = false);
+    // Binds the budget most influential lights for an object of this radius
+    // at x, y, z, from every cell the radius overlaps, and disables the
+    // other slots; with skipBaked only the lights the bake left out count.
+    // A light already in a slot stays there untouched. Light positions are
+    // transformed by the current modelview, so call it with the camera's
+    // view loaded. Returns how many lights are bound.
+    int bind(float x, float y, float z, float radius = 0.0f,
+             bool skipBaked = false);
+    // Disables GL_LIGHT1..7
+    void unbindAll();
+
+    size_t getCount() const { return lights.size(); }
+
+    // Lights bound per object (0..maxLights, set with --lights=N)
+    static int budget;
+    // Bucket size on x and z, and the reach beyond which a light is
+    // checked for every object instead of bucketed
+    static float cellSize;
+    static float maxRange;
+    // A light stops counting where colour times attenuation drops below
+    static float cutoff;
+
+    // Per-frame counts: bind() calls, lights scored, GL light slots changed
+    static int selectionCount;
+    static int candidateCount;
+    static int slotChanges;
+    static void resetCounts() {
+        selectionCount = candidateCount = slotChanges = 0;
+    }
+};
+
+#endif // LIGHTS_H
@@ -3,35 +3,379 @@
 // ============================================================================
 
 #include "model.h"
-#include <fstream>
+#include "objparser.h"
+#include "pack.h"
+#include "quantize.h"
+#include "simplify.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
 #include <iostream>
-#include <sstream>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <OpenGL/glext.h> // ARB instancing entry points
+#endif
+
+bool Model::cacheEnabled = true;
+int Model::cacheHits = 0;
+int Model::cacheMisses = 0;
+double Model::totalLoadMs = 0.0;
+bool Model::useVertexBuffers = true;
+bool Model::useInstancing = true;
+bool Model::retainCpuData = false;
+bool Model::streaming = false;
+Model::ObjImporter Model::objImporter = Model::IMPORTER_BUILTIN;
+unsigned Model::objParseThreads = 1;
+std::vector<Model *> Model::streamQueue;
+float Model::lodThresholds[Model::MAX_LODS - 1] = {0.25f, 0.10f, 0.04f};
+float Model::lodBias = 1.0f;
+
+// Target triangle ratio of each decimated LOD relative to the full mesh
+static const float kLodRatios[Model::MAX_LODS - 1] = {0.5f, 0.25f, 0.1f};
+// Meshes below this are cheap enough that LODs only add draw-time overhead
+static const size_t kMinLodTriangles = 1024;
+
+// ============================================================================
+// BINARY MESH CACHE FORMAT
+// ============================================================================
+// [MeshCacheHeader][source path, padded to 4 bytes]
+// [PackedVertex * vertexCount][uint32 * indexCount][LodLevel * lodCount]
+// The cache is only trusted when the source path, its mtime/size, the
+// importer and the Assimp post-process flags all match what produced it.
+
+// aiProcess_Triangulate: Convert all faces to triangles
+// aiProcess_FlipUVs: Flip texture coordinates along y-axis
+// aiProcess_GenSmoothNormals: Generate visuals normals if missing
+// aiProcess_JoinIdenticalVertices: Optimize vertices
+static const unsigned int kImportFlags =
+    aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals |
+    aiProcess_JoinIdenticalVertices | aiProcess_OptimizeMeshes |
+    aiProcess_OptimizeGraph | aiProcess_ImproveCacheLocality;
+
+static const char kCacheMagic[8] = {'S', 'T', 'E', 'M', 'E', 'S', 'H', '1'};
+static const uint32_t kCacheVersion = 4;
+
+struct MeshCacheHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t importFlags;
+  int64_t sourceMtime;
+  int64_t sourceSize;
+  uint32_t pathLength;
+  uint32_t vertexCount;
+  uint32_t indexCount;
+  float bounds[6]; // minX, minY, minZ, maxX, maxY, maxZ
+  uint32_t lodCount;
+  uint32_t importer; // Model::ObjImporter that was selected for the source
+};
+
+// Importer decode() tries first for filename
+static Model::ObjImporter importerFor(const char *filename) {
+  size_t len = strlen(filename);
+  bool isObj = len >= 4 && strcasecmp(filename + len - 4, ".obj") == 0;
+  return isObj ? Model::objImporter : Model::IMPORTER_ASSIMP;
+}
+
+// Vertex layout uploaded when the GL accepts half-float texcoords (16 bytes)
+struct GpuPackedVertex {
+  int16_t position[4];
+  int8_t normal[4];
+  uint16_t uv[2];
+};
+
+#ifndef GL_HALF_FLOAT
+#define GL_HALF_FLOAT 0x140B
+#endif
+
+static size_t paddedPathLength(size_t len) { return (len + 3) & ~size_t(3); }
+
+static bool statSource(const char *filename, int64_t &mtime, int64_t &size) {
+  struct stat st;
+  if (stat(filename, &st) != 0)
+    return false;
+  mtime = (int64_t)st.st_mtime;
+  size = (int64_t)st.st_size;
+  return true;
+}
 
 Model::Model() {
+  vertexBufferId = 0;
+  indexBufferId = 0;
+  instanceBufferId = 0;
+  indexType = GL_UNSIGNED_INT;
+  compactVertices = false;
+  vertexCount = 0;
+  totalIndexCount = 0;
+  center[0] = center[1] = center[2] = 0.0f;
+  quantScale = 1.0f;
   displayListId = 0;
+  displayListCount = 0;
   loaded = false;
+  keepCpuData = false;
+  decoded = false;
+  decodedFromCache = false;
+  decodedFromPack = false;
+  decodedWithObjParser = false;
+  decodeMs = 0.0;
+  streamStaging = nullptr;
   minX = minY = minZ = 1e9;
   maxX = maxY = maxZ = -1e9;
 }
 
 Model::~Model() {
+  cancelStreaming();
+  releaseGpuResources();
+}
+
+void Model::releaseGpuResources() {
   if (displayListId != 0) {
-    glDeleteLists(displayListId, 1);
+    glDeleteLists(displayListId, displayListCount);
+    displayListId = 0;
+    displayListCount = 0;
+  }
+  if (vertexBufferId != 0) {
+    glDeleteBuffers(1, &vertexBufferId);
+    vertexBufferId = 0;
+  }
+  if (indexBufferId != 0) {
+    glDeleteBuffers(1, &indexBufferId);
+    indexBufferId = 0;
+  }
+  if (instanceBufferId != 0) {
+    glDeleteBuffers(1, &instanceBufferId);
+    instanceBufferId = 0;
+  }
+  instanceRows.clear();
+}
+
+bool Model::vertexBuffersSupported() {
+  // Buffer objects are core since GL 1.5; older contexts need the ARB ext
+  static int supported = -1;
+  if (supported < 0) {
+    const char *version = (const char *)glGetString(GL_VERSION);
+    const char *extensions = (const char *)glGetString(GL_EXTENSIONS);
+    int major = 0, minor = 0;
+    if (version)
+      sscanf(version, "%d.%d", &major, &minor);
+    supported = (major > 1 || (major == 1 && minor >= 5) ||
+                 (extensions &&
+                  strstr(extensions, "GL_ARB_vertex_buffer_object")))
+                    ? 1
+                    : 0;
+  }
+  return supported == 1;
+}
+
+bool Model::halfFloatVerticesSupported() {
+  // GL_HALF_FLOAT vertex attributes are core since GL 3.0
+  static int supported = -1;
+  if (supported < 0) {
+    const char *version = (const char *)glGetString(GL_VERSION);
+    const char *extensions = (const char *)glGetString(GL_EXTENSIONS);
+    int major = 0;
+    if (version)
+      sscanf(version, "%d", &major);
+    supported =
+        (major >= 3 ||
+         (extensions && strstr(extensions, "GL_ARB_half_float_vertex")))
+            ? 1
+            : 0;
+  }
+  return supported == 1;
+}
+
+bool Model::load(const char *filename, bool withLods) {
+  if (streaming)
+    return queueStreamingLoad(filename, withLods);
+  return decode(filename, withLods) && upload();
+}
+
+bool Model::queueStreamingLoad(const char *filename, bool withLods) {
+  cancelStreaming();
+
+  // The worker only touches the staging model, so this one keeps rendering
+  // (placeholder or previous mesh) until the swap
+  Model *staging = new Model();
+  std::string path = filename;
+  streamStaging = staging;
+  streamJob = ThreadPool::shared().submit(
+      [staging, path, withLods] { staging->decode(path.c_str(), withLods); });
+  streamQueue.push_back(this);
+  return true;
+}
+
+void Model::cancelStreaming() {
+  if (!streamStaging)
+    return;
+  streamJob.wait();
+  delete streamStaging;
+  streamStaging = nullptr;
+  streamQueue.erase(std::remove(streamQueue.begin(), streamQueue.end(), this),
+                    streamQueue.end());
+}
+
+bool Model::finishStreaming() {
+  streamJob.get();
+  Model *staging = streamStaging;
+  streamStaging = nullptr;
+  bool ok = staging->decoded;
+  if (ok) {
+    takeDecoded(*staging);
+    ok = upload();
   }
+  delete staging;
+  return ok;
+}
+
+void Model::takeDecoded(Model &other) {
+  vertices.swap(other.vertices);
+  indices.swap(other.indices);
+  lods.swap(other.lods);
+  vertexCount = other.vertexCount;
+  totalIndexCount = other.totalIndexCount;
+  name = other.name;
+  for (int i = 0; i < 3; i++)
+    center[i] = other.center[i];
+  quantScale = other.quantScale;
+  minX = other.minX;
+  minY = other.minY;
+  minZ = other.minZ;
+  maxX = other.maxX;
+  maxY = other.maxY;
+  maxZ = other.maxZ;
+  decoded = other.decoded;
+  decodedFromCache = other.decodedFromCache;
+  decodedFromPack = other.decodedFromPack;
+  decodedWithObjParser = other.decodedWithObjParser;
+  decodeMs = other.decodeMs;
+  other.decoded = false;
 }
 
-bool Model::load(const char *filename) {
+int Model::updateStreaming(int maxUploads) {
+  int uploads = 0;
+  for (size_t i = 0; i < streamQueue.size();) {
+    Model *model = streamQueue[i];
+    if (model->streamJob.wait_for(std::chrono::seconds(0)) !=
+        std::future_status::ready) {
+      i++;
+      continue;
+    }
+    streamQueue.erase(streamQueue.begin() + i);
+    model->finishStreaming();
+    uploads++;
+    if (maxUploads > 0 && uploads >= maxUploads)
+      break;
+  }
+  return uploads;
+}
+
+bool Model::decode(const char *filename, bool withLods) {
+  auto start = std::chrono::steady_clock::now();
+  std::string cachePath = std::string(filename) + ".meshcache";
+  decoded = false;
+
+  // Full-precision vertices only exist while importing or simplifying
+  std::vector<MeshVertex> full;
+  bool fromPack = loadFromPack(filename);
+  bool fromCache =
+      fromPack || (cacheEnabled && loadFromCache(cachePath, filename));
+  bool fromObjParser = !fromCache &&
+                       importerFor(filename) == IMPORTER_BUILTIN &&
+                       importWithObjParser(filename, full);
+  if (!fromCache && !fromObjParser && !importWithAssimp(filename, full))
+    return false;
+
+  // LODs are stored in the cache, so they are only built on a cold load
+  bool lodsBuilt = false;
+  if (withLods && lods.size() == 1 && getTriangleCount() >= kMinLodTriangles) {
+    if (full.empty())
+      unpackVertices(full);
+    generateLods(full);
+    lodsBuilt = lods.size() > 1;
+  }
+  if (!withLods && lods.size() > 1) {
+    // Packed meshes always carry LODs; keep only the full-detail range
+    indices.resize(lods[0].indexCount);
+    lods.resize(1);
+  }
+  if (!fromCache)
+    packVertices(full);
+  std::vector<MeshVertex>().swap(full);
+  indices.shrink_to_fit();
+  totalIndexCount = indices.size();
+
+  if (cacheEnabled && !fromPack && (!fromCache || lodsBuilt) &&
+      !saveToCache(cachePath, filename))
+    std::cerr << "Could not write mesh cache: " << cachePath << std::endl;
+
+  name = filename;
+  decodedFromCache = fromCache;
+  decodedFromPack = fromPack;
+  decodedWithObjParser = fromObjParser;
+  decodeMs = std::chrono::duration<double, std::milli>(
+                 std::chrono::steady_clock::now() - start)
+                 .count();
+  decoded = true;
+  return true;
+}
+
+bool Model::upload() {
+  if (!decoded)
+    return false;
+  auto start = std::chrono::steady_clock::now();
+
+  releaseGpuResources();
+  if (!(useVertexBuffers && vertexBuffersSupported() && uploadVertexBuffers()))
+    buildDisplayList();
+  loaded = true;
+  decoded = false;
+
+  // Resident memory: what the old float layout would hold, the packed copy,
+  // and what is left once the GPU owns the mesh
+  size_t floatBytes =
+      vertexCount * sizeof(MeshVertex) + totalIndexCount * sizeof(unsigned);
+  size_t packedBytes = getResidentBytes();
+  if (!retainCpuData && !keepCpuData)
+    releaseCpuData();
+
+  double ms = decodeMs + std::chrono::duration<double, std::milli>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  totalLoadMs += ms;
+  if (decodedFromCache)
+    cacheHits++;
+  else
+    cacheMisses++;
+
+  std::cout << "Loaded model: " << name << " (Vertices: " << vertexCount
+            << ", Faces: " << getTriangleCount() << ", "
+            << (decodedFromPack        ? "pack"
+                : decodedFromCache     ? "cache"
+                : decodedWithObjParser ? "objparser"
+                                       : "assimp")
+            << ", " << ms
+            << " ms)" << std::endl;
+  printReport();
+  printf("Model memory: %-28s %10zu bytes float -> %10zu packed -> %10zu "
+         "resident\n",
+         name.c_str(), floatBytes, packedBytes, getResidentBytes());
+  return true;
+}
+
+bool Model::importWithAssimp(const char *filename,
+                             std::vector<MeshVertex> &out) {
   Assimp::Importer importer;
   // Read file with post-processing flags
-  // aiProcess_Triangulate: Convert all faces to triangles
-  // aiProcess_FlipUVs: Flip texture coordinates along y-axis
-  // aiProcess_GenSmoothNormals: Generate visuals normals if missing
-  // aiProcess_JoinIdenticalVertices: Optimize vertices
-  const aiScene *scene = importer.ReadFile(
-      filename, aiProcess_Triangulate | aiProcess_FlipUVs |
-                    aiProcess_GenSmoothNormals |
-                    aiProcess_JoinIdenticalVertices | aiProcess_OptimizeMeshes |
-                    aiProcess_OptimizeGraph | aiProcess_ImproveCacheLocality);
+  const aiScene *scene = importer.ReadFile(filename, kImportFlags);
 
   if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE ||
       !scene->mRootNode) {
@@ -40,10 +384,8 @@ bool Model::load(const char *filename) {
   }
 
   // Clear existing data
-  vertices.clear();
-  texCoords.clear();
-  normals.clear();
-  faces.clear();
+  out.clear();
+  indices.clear();
 
   // Reset bounding box
   minX = minY = minZ = 1e9;
@@ -51,18 +393,18 @@ bool Model::load(const char *filename) {
 
   // Process all meshes in the scene
   // For simplicity in this project, we flatten all meshes into one
-  int baseVertexIndex = 0;
+  unsigned int baseVertexIndex = 0;
 
   for (unsigned int m = 0; m < scene->mNumMeshes; m++) {
     aiMesh *mesh = scene->mMeshes[m];
 
     // Process vertices
     for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
-      Vertex v;
+      MeshVertex mv;
+      Vertex &v = mv.position;
       v.x = mesh->mVertices[i].x;
       v.y = mesh->mVertices[i].y;
       v.z = mesh->mVertices[i].z;
-      vertices.push_back(v);
 
       // Update bounding box
       if (v.x < minX)
@@ -78,85 +420,842 @@ bool Model::load(const char *filename) {
       if (v.z > maxZ)
         maxZ = v.z;
 
-      Normal n;
       if (mesh->HasNormals()) {
-        n.x = mesh->mNormals[i].x;
-        n.y = mesh->mNormals[i].y;
-        n.z = mesh->mNormals[i].z;
+        mv.normal.x = mesh->mNormals[i].x;
+        mv.normal.y = mesh->mNormals[i].y;
+        mv.normal.z = mesh->mNormals[i].z;
       } else {
-        n.x = 0.0f;
-        n.y = 1.0f;
-        n.z = 0.0f;
+        mv.normal.x = 0.0f;
+        mv.normal.y = 1.0f;
+        mv.normal.z = 0.0f;
       }
-      normals.push_back(n);
 
-      TexCoord t;
       if (mesh->mTextureCoords[0]) {
-        t.u = mesh->mTextureCoords[0][i].x;
-        t.v = mesh->mTextureCoords[0][i].y;
+        mv.uv.u = mesh->mTextureCoords[0][i].x;
+        mv.uv.v = mesh->mTextureCoords[0][i].y;
       } else {
-        t.u = 0.0f;
-        t.v = 0.0f;
+        mv.uv.u = 0.0f;
+        mv.uv.v = 0.0f;
       }
-      texCoords.push_back(t);
+      out.push_back(mv);
     }
 
     // Process faces
     for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
-      aiFace face = mesh->mFaces[i];
+      const aiFace &face = mesh->mFaces[i];
       if (face.mNumIndices != 3)
         continue; // Skip non-triangles (shouldn't happen with Triangulate flag)
 
-      Face f;
-      for (int j = 0; j < 3; j++) {
-        f.vIndex[j] = face.mIndices[j] + baseVertexIndex;
-        f.tIndex[j] = face.mIndices[j] + baseVertexIndex;
-        f.nIndex[j] = face.mIndices[j] + baseVertexIndex;
-      }
-      faces.push_back(f);
+      for (int j = 0; j < 3; j++)
+        indices.push_back(face.mIndices[j] + baseVertexIndex);
     }
 
     baseVertexIndex += mesh->mNumVertices;
   }
 
-  // Create display list
-  if (displayListId == 0) {
-    displayListId = glGenLists(1);
+  vertexCount = out.size();
+  lods.clear();
+  lods.push_back({0, (unsigned int)indices.size()});
+  return true;
+}
+
+bool Model::importWithObjParser(const char *filename,
+                                std::vector<MeshVertex> &out) {
+  ObjMesh mesh;
+  if (!parseObj(filename, mesh, objParseThreads))
+    return false;
+
+  out.swap(mesh.vertices);
+  indices.swap(mesh.indices);
+  minX = mesh.bounds[0];
+  minY = mesh.bounds[1];
+  minZ = mesh.bounds[2];
+  maxX = mesh.bounds[3];
+  maxY = mesh.bounds[4];
+  maxZ = mesh.bounds[5];
+
+  vertexCount = out.size();
+  lods.clear();
+  lods.push_back({0, (unsigned int)indices.size()});
+  return true;
+}
+
+void Model::packVertices(const std::vector<MeshVertex> &full) {
+  // One uniform scale keeps normals valid under the dequantising glScalef
+  center[0] = (minX + maxX) * 0.5f;
+  center[1] = (minY + maxY) * 0.5f;
+  center[2] = (minZ + maxZ) * 0.5f;
+  quantScale = fmaxf(getWidth(), fmaxf(getHeight(), getDepth())) * 0.5f;
+  if (quantScale <= 0.0f)
+    quantScale = 1.0f;
+
+  vertices.resize(full.size());
+  for (size_t i = 0; i < full.size(); i++) {
+    const MeshVertex &mv = full[i];
+    PackedVertex &pv = vertices[i];
+    pv.position[0] = quantizeSnorm16((mv.position.x - center[0]) / quantScale);
+    pv.position[1] = quantizeSnorm16((mv.position.y - center[1]) / quantScale);
+    pv.position[2] = quantizeSnorm16((mv.position.z - center[2]) / quantScale);
+    encodeOctahedral(mv.normal.x, mv.normal.y, mv.normal.z, pv.normal);
+    pv.uv[0] = floatToHalf(mv.uv.u);
+    pv.uv[1] = floatToHalf(mv.uv.v);
   }
-  glNewList(displayListId, GL_COMPILE);
-  glBegin(GL_TRIANGLES);
-  for (const auto &face : faces) {
-    for (int i = 0; i < 3; i++) {
-      // Normals
-      if (face.nIndex[i] < (int)normals.size()) {
-        glNormal3f(normals[face.nIndex[i]].x, normals[face.nIndex[i]].y,
-                   normals[face.nIndex[i]].z);
-      }
-      // TexCoords
-      if (face.tIndex[i] < (int)texCoords.size()) {
-        glTexCoord2f(texCoords[face.tIndex[i]].u, texCoords[face.tIndex[i]].v);
-      }
-      // Vertices
-      if (face.vIndex[i] < (int)vertices.size()) {
-        glVertex3f(vertices[face.vIndex[i]].x, vertices[face.vIndex[i]].y,
-                   vertices[face.vIndex[i]].z);
-      }
+  vertexCount = vertices.size();
+}
+
+void Model::unpackVertices(std::vector<MeshVertex> &out) const {
+  float s = quantScale / 32767.0f;
+  out.resize(vertices.size());
+  for (size_t i = 0; i < vertices.size(); i++) {
+    const PackedVertex &pv = vertices[i];
+    MeshVertex &mv = out[i];
+    mv.position.x = center[0] + pv.position[0] * s;
+    mv.position.y = center[1] + pv.position[1] * s;
+    mv.position.z = center[2] + pv.position[2] * s;
+    decodeOctahedral(pv.normal, mv.normal.x, mv.normal.y, mv.normal.z);
+    mv.uv.u = halfToFloat(pv.uv[0]);
+    mv.uv.v = halfToFloat(pv.uv[1]);
+  }
+}
+
+bool Model::getMesh(size_t maxTriangles,
+                    std::vector<MeshVertex> &meshVertices,
+                    std::vector<unsigned int> &meshIndices) const {
+  if (!loaded || vertices.empty() || lods.empty() ||
+      indices.size() < totalIndexCount)
+    return false;
+  size_t lod = 0;
+  while (lod + 1 < lods.size() && lods[lod].indexCount / 3 > maxTriangles)
+    lod++;
+  unpackVertices(meshVertices);
+  meshIndices.assign(indices.begin() + lods[lod].firstIndex,
+                     indices.begin() + lods[lod].firstIndex +
+                         lods[lod].indexCount);
+  return true;
+}
+
+void Model::releaseCpuData() {
+  std::vector<PackedVertex>().swap(vertices);
+  std::vector<unsigned int>().swap(indices);
+}
+
+size_t Model::getResidentBytes() const {
+  return vertices.capacity() * sizeof(PackedVertex) +
+         indices.capacity() * sizeof(unsigned int) +
+         lods.capacity() * sizeof(LodLevel);
+}
+
+void Model::generateLods(const std::vector<MeshVertex> &full) {
+  if (lods.empty() || getTriangleCount() < kMinLodTriangles)
+    return;
+
+  std::vector<unsigned int> base(indices.begin(),
+                                 indices.begin() + lods[0].indexCount);
+  for (int i = 0; i < MAX_LODS - 1; i++) {
+    size_t target = (size_t)(base.size() * kLodRatios[i]) / 3 * 3;
+    std::vector<unsigned int> lod =
+        simplifyMesh(base, &full[0].position.x, full.size(),
+                     sizeof(MeshVertex), target);
+
+    // Stop once simplification no longer pays for an extra level
+    if (lod.empty() || lod.size() > lods.back().indexCount * 9 / 10)
+      break;
+    lods.push_back({(unsigned int)indices.size(), (unsigned int)lod.size()});
+    indices.insert(indices.end(), lod.begin(), lod.end());
+  }
+}
+
+int Model::selectLod() const {
+  if (lods.size() <= 1)
+    return 0;
+
+  GLfloat mv[16], proj[16];
+  glGetFloatv(GL_MODELVIEW_MATRIX, mv);
+  glGetFloatv(GL_PROJECTION_MATRIX, proj);
+  return selectLod(mv, proj);
+}
+
+int Model::selectLod(const GLfloat *mv, const GLfloat *proj) const {
+  if (lods.size() <= 1)
+    return 0;
+
+  // Bounding sphere in eye space (column-major matrices)
+  float cx = (minX + maxX) * 0.5f;
+  float cy = (minY + maxY) * 0.5f;
+  float cz = (minZ + maxZ) * 0.5f;
+  float eyeZ = mv[2] * cx + mv[6] * cy + mv[10] * cz + mv[14];
+  float scale = 0.0f;
+  for (int c = 0; c < 3; c++) {
+    float len = sqrtf(mv[c * 4] * mv[c * 4] + mv[c * 4 + 1] * mv[c * 4 + 1] +
+                      mv[c * 4 + 2] * mv[c * 4 + 2]);
+    if (len > scale)
+      scale = len;
+  }
+  float radius =
+      0.5f * sqrtf(getWidth() * getWidth() + getHeight() * getHeight() +
+                   getDepth() * getDepth()) *
+      scale;
+
+  float distance = -eyeZ;
+  if (distance <= radius)
+    return 0; // Camera is inside or right next to the object
+
+  // proj[5] = cot(fovy / 2): projected radius as a fraction of half height
+  float screenSize = radius * proj[5] / distance * lodBias;
+  int last = (int)lods.size() - 1;
+  for (int i = 0; i < last; i++) {
+    if (screenSize >= lodThresholds[i])
+      return i;
+  }
+  return last;
+}
+
+bool Model::loadFromPack(const char *filename) {
+  AssetView view;
+  std::vector<unsigned char> scratch;
+  if (!AssetPack::shared().get(filename, view, scratch))
+    return false;
+  // The pack is rebuilt with the game, so the source is not checked
+  return parseCache(view.data, view.size, filename, nullptr);
+}
+
+bool Model::loadFromCache(const std::string &cachePath, const char *filename) {
+  int64_t source[2]; // mtime, size
+  if (!statSource(filename, source[0], source[1]))
+    return false;
+
+  int fd = open(cachePath.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(MeshCacheHeader)) {
+    close(fd);
+    return false;
+  }
+
+  size_t mappedSize = (size_t)st.st_size;
+  void *mapped = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd); // The mapping stays valid after the descriptor is closed
+  if (mapped == MAP_FAILED)
+    return false;
+
+  bool valid =
+      parseCache((const unsigned char *)mapped, mappedSize, filename, source);
+  munmap(mapped, mappedSize);
+  return valid;
+}
+
+bool Model::parseCache(const unsigned char *data, size_t dataSize,
+                       const char *filename, const int64_t *source) {
+  if (dataSize < sizeof(MeshCacheHeader))
+    return false;
+  const char *bytes = (const char *)data;
+  const MeshCacheHeader *header = (const MeshCacheHeader *)bytes;
+  size_t pathLen = strlen(filename);
+
+  bool valid = memcmp(header->magic, kCacheMagic, sizeof(kCacheMagic)) == 0 &&
+               header->version == kCacheVersion &&
+               header->importFlags == kImportFlags &&
+               (!source ||
+                header->importer == (uint32_t)importerFor(filename)) &&
+               (!source || (header->sourceMtime == source[0] &&
+                            header->sourceSize == source[1])) &&
+               header->pathLength == pathLen;
+
+  size_t pathOffset = sizeof(MeshCacheHeader);
+  size_t vertexOffset = pathOffset + paddedPathLength(pathLen);
+  size_t indexOffset =
+      vertexOffset + (size_t)header->vertexCount * sizeof(PackedVertex);
+  size_t lodOffset =
+      indexOffset + (size_t)header->indexCount * sizeof(uint32_t);
+  size_t endOffset = lodOffset + (size_t)header->lodCount * sizeof(LodLevel);
+
+  if (valid)
+    valid = endOffset == dataSize &&
+            memcmp(bytes + pathOffset, filename, pathLen) == 0 &&
+            header->lodCount >= 1 && header->lodCount <= MAX_LODS;
+
+  // A truncated, edited or stale file could still pass the checks above;
+  // every LOD range and index is bounds checked too, since the draws and
+  // getMesh() trust them
+  const PackedVertex *v = (const PackedVertex *)(bytes + vertexOffset);
+  const uint32_t *idx = (const uint32_t *)(bytes + indexOffset);
+  const LodLevel *lod = (const LodLevel *)(bytes + lodOffset);
+  for (uint32_t i = 0; valid && i < header->lodCount; i++)
+    valid = lod[i].indexCount % 3 == 0 &&
+            (uint64_t)lod[i].firstIndex + lod[i].indexCount <=
+                header->indexCount;
+  for (uint32_t i = 0; valid && i < header->indexCount; i++)
+    valid = idx[i] < header->vertexCount;
+
+  if (valid) {
+    vertices.assign(v, v + header->vertexCount);
+    indices.assign(idx, idx + header->indexCount);
+    lods.assign(lod, lod + header->lodCount);
+
+    minX = header->bounds[0];
+    minY = header->bounds[1];
+    minZ = header->bounds[2];
+    maxX = header->bounds[3];
+    maxY = header->bounds[4];
+    maxZ = header->bounds[5];
+    vertexCount = vertices.size();
+
+    // Quantisation parameters follow from the bounds alone
+    center[0] = (minX + maxX) * 0.5f;
+    center[1] = (minY + maxY) * 0.5f;
+    center[2] = (minZ + maxZ) * 0.5f;
+    quantScale = fmaxf(getWidth(), fmaxf(getHeight(), getDepth())) * 0.5f;
+    if (quantScale <= 0.0f)
+      quantScale = 1.0f;
+  }
+  return valid;
+}
+
+bool Model::saveToCache(const std::string &cachePath,
+                        const char *filename) const {
+  MeshCacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+  header.version = kCacheVersion;
+  header.importFlags = kImportFlags;
+  if (!statSource(filename, header.sourceMtime, header.sourceSize))
+    return false;
+  header.pathLength = (uint32_t)strlen(filename);
+  header.vertexCount = (uint32_t)vertices.size();
+  header.indexCount = (uint32_t)indices.size();
+  header.bounds[0] = minX;
+  header.bounds[1] = minY;
+  header.bounds[2] = minZ;
+  header.bounds[3] = maxX;
+  header.bounds[4] = maxY;
+  header.bounds[5] = maxZ;
+  header.lodCount = (uint32_t)lods.size();
+  header.importer = (uint32_t)importerFor(filename);
+
+  // Write to a temporary file and rename so a crash never leaves a torn cache
+  std::string tmpPath = cachePath + ".tmp";
+  FILE *file = fopen(tmpPath.c_str(), "wb");
+  if (!file)
+    return false;
+
+  static const char zeros[4] = {0, 0, 0, 0};
+  size_t padding = paddedPathLength(header.pathLength) - header.pathLength;
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+            fwrite(filename, 1, header.pathLength, file) == header.pathLength &&
+            fwrite(zeros, 1, padding, file) == padding &&
+            fwrite(vertices.data(), sizeof(PackedVertex), vertices.size(),
+                   file) == vertices.size() &&
+            fwrite(indices.data(), sizeof(unsigned int), indices.size(),
+                   file) == indices.size() &&
+            fwrite(lods.data(), sizeof(LodLevel), lods.size(), file) ==
+                lods.size();
+  ok = (fclose(file) == 0) && ok;
+
+  if (!ok || rename(tmpPath.c_str(), cachePath.c_str()) != 0) {
+    remove(tmpPath.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool Model::uploadVertexBuffers() {
+  if (vertices.empty() || indices.empty())
+    return false;
+
+  // Fixed-function GL cannot decode octahedral normals, so the GPU copy
+  // carries them as snorm8 xyz; positions stay 16-bit and are rescaled by the
+  // modelview in render(). Without half-float support fall back to floats.
+  glGenBuffers(1, &vertexBufferId);
+  glBindBuffer(GL_ARRAY_BUFFER, vertexBufferId);
+  compactVertices = halfFloatVerticesSupported();
+  if (compactVertices) {
+    std::vector<GpuPackedVertex> gpu(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++) {
+      const PackedVertex &pv = vertices[i];
+      GpuPackedVertex &gv = gpu[i];
+      float nx, ny, nz;
+      decodeOctahedral(pv.normal, nx, ny, nz);
+      for (int k = 0; k < 3; k++)
+        gv.position[k] = pv.position[k];
+      gv.position[3] = 0;
+      gv.normal[0] = (int8_t)lroundf(nx * 127.0f);
+      gv.normal[1] = (int8_t)lroundf(ny * 127.0f);
+      gv.normal[2] = (int8_t)lroundf(nz * 127.0f);
+      gv.normal[3] = 0;
+      gv.uv[0] = pv.uv[0];
+      gv.uv[1] = pv.uv[1];
     }
+    glBufferData(GL_ARRAY_BUFFER, gpu.size() * sizeof(GpuPackedVertex),
+                 gpu.data(), GL_STATIC_DRAW);
+  } else {
+    std::vector<MeshVertex> full;
+    unpackVertices(full);
+    glBufferData(GL_ARRAY_BUFFER, full.size() * sizeof(MeshVertex),
+                 full.data(), GL_STATIC_DRAW);
   }
-  glEnd();
-  glEndList();
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-  loaded = true;
-  std::cout << "Loaded model: " << filename << " (Vertices: " << vertices.size()
-            << ", Faces: " << faces.size() << ")" << std::endl;
+  // 16-bit indices halve the index buffer whenever the mesh allows it
+  glGenBuffers(1, &indexBufferId);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferId);
+  if (vertices.size() <= 65536) {
+    std::vector<unsigned short> shortIndices(indices.begin(), indices.end());
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 shortIndices.size() * sizeof(unsigned short),
+                 shortIndices.data(), GL_STATIC_DRAW);
+    indexType = GL_UNSIGNED_SHORT;
+  } else {
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int),
+                 indices.data(), GL_STATIC_DRAW);
+    indexType = GL_UNSIGNED_INT;
+  }
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+  if (glGetError() != GL_NO_ERROR) {
+    std::cerr << "VBO upload failed, using display list: " << name
+              << std::endl;
+    releaseGpuResources();
+    return false;
+  }
   return true;
 }
 
+size_t Model::getGpuBytes() const {
+  if (vertexBufferId != 0) {
+    size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short)
+                                                      : sizeof(unsigned int);
+    size_t stride =
+        compactVertices ? sizeof(GpuPackedVertex) : sizeof(MeshVertex);
+    return vertexCount * stride + totalIndexCount * indexSize;
+  }
+  // Display list: every face corner is expanded to its own vertex
+  return totalIndexCount * sizeof(MeshVertex);
+}
+
+float Model::getBoundingRadius() const {
+  if (maxX < minX)
+    return 0.0f;
+  float x = std::max(fabsf(minX), fabsf(maxX));
+  float y = std::max(fabsf(minY), fabsf(maxY));
+  float z = std::max(fabsf(minZ), fabsf(maxZ));
+  return sqrtf(x * x + y * y + z * z);
+}
+
+void Model::printReport() const {
+  printf("Model report: %-28s %8zu tris %8zu verts %10zu bytes [%s]\n",
+         name.c_str(), getTriangleCount(), getVertexCount(), getGpuBytes(),
+         !usesVertexBuffers() ? "display list"
+         : compactVertices    ? "indexed VBO, packed"
+                              : "indexed VBO");
+  for (size_t i = 1; i < lods.size(); i++)
+    printf("              LOD%zu %8u tris\n", i, lods[i].indexCount / 3);
+}
+
+void Model::buildDisplayList() {
+  std::vector<MeshVertex> full;
+  unpackVertices(full);
+
+  // Create one display list per LOD
+  displayListCount = (GLsizei)lods.size();
+  displayListId = glGenLists(displayListCount);
+  for (GLsizei l = 0; l < displayListCount; l++) {
+    glNewList(displayListId + l, GL_COMPILE);
+    glBegin(GL_TRIANGLES);
+    for (unsigned int i = 0; i < lods[l].indexCount; i++) {
+      unsigned int index = indices[lods[l].firstIndex + i];
+      if (index >= full.size())
+        continue;
+      const MeshVertex &v = full[index];
+      glNormal3f(v.normal.x, v.normal.y, v.normal.z);
+      glTexCoord2f(v.uv.u, v.uv.v);
+      glVertex3f(v.position.x, v.position.y, v.position.z);
+    }
+    glEnd();
+    glEndList();
+  }
+}
+
+void Model::bindVertexArrays() const {
+  glBindBuffer(GL_ARRAY_BUFFER, vertexBufferId);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferId);
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glEnableClientState(GL_NORMAL_ARRAY);
+  glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+  if (compactVertices) {
+    const GLsizei stride = sizeof(GpuPackedVertex);
+    glVertexPointer(3, GL_SHORT, stride,
+                    (const void *)offsetof(GpuPackedVertex, position));
+    glNormalPointer(GL_BYTE, stride,
+                    (const void *)offsetof(GpuPackedVertex, normal));
+    glTexCoordPointer(2, GL_HALF_FLOAT, stride,
+                      (const void *)offsetof(GpuPackedVertex, uv));
+  } else {
+    const GLsizei stride = sizeof(MeshVertex);
+    glVertexPointer(3, GL_FLOAT, stride,
+                    (const void *)offsetof(MeshVertex, position));
+    glNormalPointer(GL_FLOAT, stride,
+                    (const void *)offsetof(MeshVertex, normal));
+    glTexCoordPointer(2, GL_FLOAT, stride,
+                      (const void *)offsetof(MeshVertex, uv));
+  }
+}
+
+void Model::unbindVertexArrays() const {
+  glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+  glDisableClientState(GL_NORMAL_ARRAY);
+  glDisableClientState(GL_VERTEX_ARRAY);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 void Model::render() {
-  if (loaded) {
-    glCallList(displayListId);
+  if (loaded && vertexBufferId != 0) {
+    const LodLevel &lod = lods[selectLod()];
+    bindVertexArrays();
+    if (compactVertices) {
+      // Undo the bounding-box quantisation (GL_NORMALIZE fixes normals)
+      float s = quantScale / 32767.0f;
+      glPushMatrix();
+      glTranslatef(center[0], center[1], center[2]);
+      glScalef(s, s, s);
+    }
+    size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short)
+                                                      : sizeof(unsigned int);
+    glDrawElements(GL_TRIANGLES, lod.indexCount, indexType,
+                   (const void *)(lod.firstIndex * indexSize));
+    if (compactVertices)
+      glPopMatrix();
+    unbindVertexArrays();
+  } else if (loaded) {
+    glCallList(displayListId + selectLod());
   } else {
     // Fallback if not loaded
     glutWireCube(1.0f);
   }
 }
+
+// ============================================================================
+// INSTANCED RENDERING
+// ============================================================================
+
+Transform::Transform() {
+  for (int i = 0; i < 16; i++)
+    m[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+}
+
+// out = a * b, column-major (out may not alias a or b)
+static void multiplyMatrices(const float *a, const float *b, float *out) {
+  for (int c = 0; c < 4; c++)
+    for (int r = 0; r < 4; r++)
+      out[c * 4 + r] = a[r] * b[c * 4] + a[4 + r] * b[c * 4 + 1] +
+                       a[8 + r] * b[c * 4 + 2] + a[12 + r] * b[c * 4 + 3];
+}
+
+static void postMultiply(float *m, const float *b) {
+  float result[16];
+  multiplyMatrices(m, b, result);
+  memcpy(m, result, sizeof(result));
+}
+
+Transform &Transform::translate(float x, float y, float z) {
+  Transform t;
+  t.m[12] = x;
+  t.m[13] = y;
+  t.m[14] = z;
+  postMultiply(m, t.m);
+  return *this;
+}
+
+Transform &Transform::rotate(float degrees, float x, float y, float z) {
+  float len = sqrtf(x * x + y * y + z * z);
+  if (len == 0.0f)
+    return *this;
+  x /= len;
+  y /= len;
+  z /= len;
+  float rad = degrees * 3.14159265f / 180.0f;
+  float c = cosf(rad), s = sinf(rad), k = 1.0f - c;
+  // The glRotate matrix, column-major
+  const float r[16] = {
+      x * x * k + c,     y * x * k + z * s, z * x * k - y * s, 0.0f,
+      x * y * k - z * s, y * y * k + c,     z * y * k + x * s, 0.0f,
+      x * z * k + y * s, y * z * k - x * s, z * z * k + c,     0.0f,
+      0.0f,              0.0f,              0.0f,              1.0f};
+  postMultiply(m, r);
+  return *this;
+}
+
+Transform &Transform::scale(float x, float y, float z) {
+  for (int r = 0; r < 4; r++) {
+    m[r] *= x;
+    m[4 + r] *= y;
+    m[8 + r] *= z;
+  }
+  return *this;
+}
+
+bool Model::instancingSupported() {
+  // Per-instance attributes need a vertex shader (GL 2.0) plus instanced
+  // draws and attribute divisors (core in 3.3, ARB extensions before)
+  static int supported = -1;
+  if (supported < 0) {
+    const char *version = (const char *)glGetString(GL_VERSION);
+    const char *extensions = (const char *)glGetString(GL_EXTENSIONS);
+    int major = 0, minor = 0;
+    if (version)
+      sscanf(version, "%d.%d", &major, &minor);
+    bool extensionsPresent =
+        extensions && strstr(extensions, "GL_ARB_draw_instanced") &&
+        strstr(extensions, "GL_ARB_instanced_arrays");
+    supported = (major >= 2 && extensionsPresent) ? 1 : 0;
+  }
+  return supported == 1;
+}
+
+// Generic attribute slots of the three instance matrix rows (0 aliases
+// gl_Vertex)
+static const GLuint kInstanceRowAttrib = 1;
+
+// Transforms and lights like the fixed-function pipeline it replaces:
+// GL_COLOR_MATERIAL on ambient and diffuse, infinite viewer, per-vertex
+// lighting. Instance matrices are expected to be rotation, translation and
+// uniform scale, so normals go through the same 3x3 (GL_NORMALIZE-style).
+static const char *kInstanceVertexShader = R"(
+#version 120
+attribute vec4 instanceRow0;
+attribute vec4 instanceRow1;
+attribute vec4 instanceRow2;
+uniform vec4 quantize; // xyz: center, w: scale
+uniform bool lighting;
+uniform bool lightOn[8];
+
+void main() {
+  vec4 local = vec4(gl_Vertex.xyz * quantize.w + quantize.xyz, 1.0);
+  vec4 placed = vec4(dot(instanceRow0, local), dot(instanceRow1, local),
+                     dot(instanceRow2, local), 1.0);
+  vec4 eye = gl_ModelViewMatrix * placed;
+  gl_Position = gl_ProjectionMatrix * eye;
+  gl_TexCoord[0] = gl_TextureMatrix[0] * gl_MultiTexCoord0;
+  gl_FogFragCoord = abs(eye.z);
+  if (!lighting) {
+    gl_FrontColor = gl_Color;
+    return;
+  }
+
+  vec3 n = vec3(dot(instanceRow0.xyz, gl_Normal),
+                dot(instanceRow1.xyz, gl_Normal),
+                dot(instanceRow2.xyz, gl_Normal));
+  n = normalize(gl_NormalMatrix * n);
+  vec4 color = gl_FrontMaterial.emission + gl_LightModel.ambient * gl_Color;
+  for (int i = 0; i < 8; i++) {
+    if (!lightOn[i])
+      continue;
+    vec3 l;
+    float attenuation = 1.0;
+    if (gl_LightSource[i].position.w == 0.0) {
+      l = normalize(gl_LightSource[i].position.xyz);
+    } else {
+      vec3 d = gl_LightSource[i].position.xyz - eye.xyz;
+      float dist = length(d);
+      l = d / dist;
+      attenuation = 1.0 / (gl_LightSource[i].constantAttenuation +
+                           gl_LightSource[i].linearAttenuation * dist +
+                           gl_LightSource[i].quadraticAttenuation * dist * dist);
+      if (gl_LightSource[i].spotCutoff <= 90.0) {
+        float spot = dot(-l, normalize(gl_LightSource[i].spotDirection));
+        attenuation *= spot < gl_LightSource[i].spotCosCutoff
+                           ? 0.0
+                           : pow(spot, gl_LightSource[i].spotExponent);
+      }
+    }
+    float diffuse = max(dot(n, l), 0.0);
+    color += attenuation * (gl_LightSource[i].ambient * gl_Color +
+                            gl_LightSource[i].diffuse * gl_Color * diffuse);
+    if (diffuse > 0.0) {
+      float h = max(dot(n, normalize(l + vec3(0.0, 0.0, 1.0))), 0.0);
+      color += attenuation * pow(h, gl_FrontMaterial.shininess) *
+               gl_LightSource[i].specular * gl_FrontMaterial.specular;
+    }
+  }
+  gl_FrontColor = vec4(color.rgb, gl_Color.a);
+}
+)";
+
+struct InstanceProgram {
+  GLuint id;
+  GLint quantize;
+  GLint lighting;
+  GLint lightOn;
+};
+
+// Compiled on first use; id 0 if the driver rejects it
+static const InstanceProgram &instanceProgram() {
+  static InstanceProgram program = {0, -1, -1, -1};
+  static bool built = false;
+  if (built)
+    return program;
+  built = true;
+
+  GLuint shader = glCreateShader(GL_VERTEX_SHADER);
+  glShaderSource(shader, 1, &kInstanceVertexShader, nullptr);
+  glCompileShader(shader);
+  GLint ok = GL_FALSE;
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+  if (!ok) {
+    char log[1024];
+    glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+    std::cerr << "Instancing shader failed to compile: " << log << std::endl;
+    glDeleteShader(shader);
+    return program;
+  }
+
+  GLuint id = glCreateProgram();
+  glAttachShader(id, shader);
+  glBindAttribLocation(id, kInstanceRowAttrib, "instanceRow0");
+  glBindAttribLocation(id, kInstanceRowAttrib + 1, "instanceRow1");
+  glBindAttribLocation(id, kInstanceRowAttrib + 2, "instanceRow2");
+  glLinkProgram(id);
+  glDeleteShader(shader); // Freed with the program
+  glGetProgramiv(id, GL_LINK_STATUS, &ok);
+  if (!ok) {
+    char log[1024];
+    glGetProgramInfoLog(id, sizeof(log), nullptr, log);
+    std::cerr << "Instancing shader failed to link: " << log << std::endl;
+    glDeleteProgram(id);
+    return program;
+  }
+  program.id = id;
+  program.quantize = glGetUniformLocation(id, "quantize");
+  program.lighting = glGetUniformLocation(id, "lighting");
+  program.lightOn = glGetUniformLocation(id, "lightOn");
+  return program;
+}
+
+void Model::renderInstances(const Transform *transforms, size_t count) {
+  if (count == 0)
+    return;
+  if (loaded && vertexBufferId != 0 && useInstancing &&
+      instancingSupported() && renderInstanced(transforms, count))
+    return;
+
+  // Client-side loop: vertex arrays are set up once for all instances
+  bool arrays = loaded && vertexBufferId != 0;
+  GLfloat mv[16], proj[16], instanceMv[16];
+  if (arrays) {
+    bindVertexArrays();
+    glGetFloatv(GL_MODELVIEW_MATRIX, mv);
+    glGetFloatv(GL_PROJECTION_MATRIX, proj);
+  }
+  size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short)
+                                                    : sizeof(unsigned int);
+  float s = quantScale / 32767.0f;
+  for (size_t i = 0; i < count; i++) {
+    glPushMatrix();
+    glMultMatrixf(transforms[i].m);
+    if (arrays) {
+      multiplyMatrices(mv, transforms[i].m, instanceMv);
+      const LodLevel &lod = lods[selectLod(instanceMv, proj)];
+      if (compactVertices) {
+        glTranslatef(center[0], center[1], center[2]);
+        glScalef(s, s, s);
+      }
+      glDrawElements(GL_TRIANGLES, lod.indexCount, indexType,
+                     (const void *)(lod.firstIndex * indexSize));
+    } else {
+      render();
+    }
+    glPopMatrix();
+  }
+  if (arrays)
+    unbindVertexArrays();
+}
+
+bool Model::renderInstanced(const Transform *transforms, size_t count) {
+  const InstanceProgram &program = instanceProgram();
+  if (program.id == 0)
+    return false;
+
+  // One LOD per instance, as render() would pick it; instances are grouped
+  // by LOD so each group is a contiguous range of the instance buffer
+  GLfloat mv[16], proj[16], instanceMv[16];
+  glGetFloatv(GL_MODELVIEW_MATRIX, mv);
+  glGetFloatv(GL_PROJECTION_MATRIX, proj);
+  std::vector<int> lodOf(count);
+  size_t lodCounts[MAX_LODS] = {0};
+  for (size_t i = 0; i < count; i++) {
+    multiplyMatrices(mv, transforms[i].m, instanceMv);
+    lodOf[i] = selectLod(instanceMv, proj);
+    lodCounts[lodOf[i]]++;
+  }
+  std::vector<float> rows;
+  rows.reserve(count * 12);
+  for (int l = 0; l < (int)lods.size(); l++) {
+    for (size_t i = 0; i < count; i++) {
+      if (lodOf[i] != l)
+        continue;
+      const float *m = transforms[i].m;
+      for (int r = 0; r < 3; r++) {
+        rows.push_back(m[r]);
+        rows.push_back(m[4 + r]);
+        rows.push_back(m[8 + r]);
+        rows.push_back(m[12 + r]);
+      }
+    }
+  }
+
+  // Static instance sets upload once; the buffer is only rewritten when a
+  // transform or an instance's LOD changes
+  if (instanceBufferId == 0)
+    glGenBuffers(1, &instanceBufferId);
+  glBindBuffer(GL_ARRAY_BUFFER, instanceBufferId);
+  if (rows != instanceRows) {
+    glBufferData(GL_ARRAY_BUFFER, rows.size() * sizeof(float), rows.data(),
+                 GL_STATIC_DRAW);
+    instanceRows.swap(rows);
+  }
+
+  glUseProgram(program.id);
+  GLint lightOn[8];
+  for (int i = 0; i < 8; i++)
+    lightOn[i] = glIsEnabled(GL_LIGHT0 + i);
+  glUniform1iv(program.lightOn, 8, lightOn);
+  glUniform1i(program.lighting, glIsEnabled(GL_LIGHTING));
+  if (compactVertices)
+    glUniform4f(program.quantize, center[0], center[1], center[2],
+                quantScale / 32767.0f);
+  else
+    glUniform4f(program.quantize, 0.0f, 0.0f, 0.0f, 1.0f);
+
+  for (GLuint a = 0; a < 3; a++) {
+    glEnableVertexAttribArray(kInstanceRowAttrib + a);
+    glVertexAttribDivisorARB(kInstanceRowAttrib + a, 1);
+  }
+  bindVertexArrays(); // Leaves the vertex buffer bound
+
+  size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short)
+                                                    : sizeof(unsigned int);
+  size_t first = 0;
+  for (int l = 0; l < (int)lods.size(); l++) {
+    if (lodCounts[l] == 0)
+      continue;
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBufferId);
+    for (GLuint a = 0; a < 3; a++)
+      glVertexAttribPointer(
+          kInstanceRowAttrib + a, 4, GL_FLOAT, GL_FALSE, 12 * sizeof(float),
+          (const void *)((first * 12 + a * 4) * sizeof(float)));
+    glDrawElementsInstancedARB(
+        GL_TRIANGLES, lods[l].indexCount, indexType,
+        (const void *)(lods[l].firstIndex * indexSize), (GLsizei)lodCounts[l]);
+    first += lodCounts[l];
+  }
+
+  for (GLuint a = 0; a < 3; a++) {
+    glVertexAttribDivisorARB(kInstanceRowAttrib + a, 0);
+    glDisableVertexAttribArray(kInstanceRowAttrib + a);
+  }
+  unbindVertexArrays();
+  glUseProgram(0);
+  return true;
+}
@@ -6,11 +6,16 @@
 #ifndef MODEL_H
 #define MODEL_H
 
+#include <cstdint>
+#include <future>
 #include <string>
 #include <vector>
 #ifdef __APPLE__
 #include <GLUT/glut.h>
 #else
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES // glGenBuffers & co. live in glext.h on Mesa
+#endif
 #include <GL/glut.h>
 #endif
 
@@ -31,37 +36,212 @@ struct Normal {
     float x, y, z;
 };
 
-struct Face {
-    int vIndex[3];
-    int tIndex[3];
-    int nIndex[3];
+// Full-precision interleaved vertex, used while importing and simplifying
+struct MeshVertex {
+    Vertex position;
+    Normal normal;
+    TexCoord uv;
+};
+
+// Compact vertex kept resident and stored in the binary mesh cache (12 bytes
+// instead of 32): positions are 16-bit normalized relative to the bounding
+// box, normals octahedral-encoded, texture coordinates half floats.
+struct PackedVertex {
+    int16_t position[3];
+    int8_t normal[2];
+    uint16_t uv[2];
+};
+
+// Placement of one instance for Model::renderInstances: a column-major
+// matrix applied on top of the current modelview. The builders post-multiply
+// like their glTranslatef/glRotatef/glScalef namesakes, so a per-draw
+// transform sequence carries over call for call.
+struct Transform {
+    float m[16];
+
+    Transform(); // identity
+    Transform& translate(float x, float y, float z);
+    Transform& rotate(float degrees, float x, float y, float z);
+    Transform& scale(float x, float y, float z);
+    Transform& scale(float s) { return scale(s, s, s); }
+};
+
+// One level of detail: a range of Model's shared index array
+struct LodLevel {
+    unsigned int firstIndex;
+    unsigned int indexCount;
 };
 
 class Model {
 private:
-    std::vector<Vertex> vertices;
-    std::vector<TexCoord> texCoords;
-    std::vector<Normal> normals;
-    std::vector<Face> faces;
-    
+    std::vector<PackedVertex> vertices; // resident copy, see retainCpuData
+    std::vector<unsigned int> indices; // 3 per triangle, all LODs back to back
+    std::vector<LodLevel> lods;        // lods[0] is the full-detail mesh
+    size_t vertexCount;
+    size_t totalIndexCount;
+
+    std::string name;
+
+    // Dequantisation: position = center + packed / 32767 * quantScale
+    float center[3];
+    float quantScale;
+
+    // Indexed vertex-buffer backend (preferred)
+    GLuint vertexBufferId;
+    GLuint indexBufferId;
+    GLenum indexType; // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    bool compactVertices; // VBO holds quantized vertices (else floats)
+
+    // renderInstances() transforms as last uploaded: 3 matrix rows per
+    // instance, grouped by LOD
+    GLuint instanceBufferId;
+    std::vector<float> instanceRows;
+
+    // Expanded display list backend (fallback), one list per LOD
     GLuint displayListId;
+    GLsizei displayListCount;
     bool loaded;
-    
+    bool keepCpuData; // see setRetainCpuData()
+
+    // decode() results waiting for upload()
+    bool decoded;
+    bool decodedFromCache;
+    bool decodedFromPack;
+    bool decodedWithObjParser;
+    double decodeMs;
+
+    // Streaming load in flight: a private Model decoded on the worker pool,
+    // swapped in by updateStreaming()
+    Model* streamStaging;
+    std::future<void> streamJob;
+    static std::vector<Model*> streamQueue;
+
     // Bounding box
     float minX, minY, minZ;
     float maxX, maxY, maxZ;
 
+    // Import paths
+    bool loadFromPack(const char* filename);
+    bool loadFromCache(const std::string& cachePath, const char* filename);
+    bool parseCache(const unsigned char* data, size_t dataSize,
+                    const char* filename, const int64_t* source);
+    bool saveToCache(const std::string& cachePath, const char* filename) const;
+    bool importWithAssimp(const char* filename,
+                          std::vector<MeshVertex>& out);
+    bool importWithObjParser(const char* filename,
+                             std::vector<MeshVertex>& out);
+    void generateLods(const std::vector<MeshVertex>& full);
+    void packVertices(const std::vector<MeshVertex>& full);
+    void unpackVertices(std::vector<MeshVertex>& out) const;
+    int selectLod() const;
+    int selectLod(const GLfloat* modelview, const GLfloat* projection) const;
+    void bindVertexArrays() const;
+    void unbindVertexArrays() const;
+    bool renderInstanced(const Transform* transforms, size_t count);
+    void buildDisplayList();
+    bool uploadVertexBuffers();
+    void releaseCpuData();
+    void releaseGpuResources();
+    bool queueStreamingLoad(const char* filename, bool withLods);
+    bool finishStreaming();
+    void cancelStreaming();
+    void takeDecoded(Model& other);
+
 public:
     Model();
     ~Model();
 
-    bool load(const char* filename);
+    // load() = decode() + upload(). decode() does all file/CPU work and makes
+    // no GL calls, so it may run on a worker thread; upload() creates the GL
+    // objects and must run on the GL thread.
+    bool load(const char* filename, bool withLods = false);
+    bool decode(const char* filename, bool withLods = false);
+    bool upload();
+    double getDecodeMs() const { return decodeMs; }
     void render();
-    
+    // Draws the model once per transform. With instancing this is one
+    // instanced draw per LOD in use; otherwise a loop that sets up the
+    // vertex arrays once and only changes the matrix between draws.
+    void renderInstances(const Transform* transforms, size_t count);
+
     // Get dimensions
     float getWidth() const { return maxX - minX; }
     float getHeight() const { return maxY - minY; }
     float getDepth() const { return maxZ - minZ; }
+    // Radius around the model origin that holds the whole mesh, whatever
+    // the rotation (0 until a mesh is loaded)
+    float getBoundingRadius() const;
+    void getBounds(float bounds[6]) const {
+        bounds[0] = minX; bounds[1] = minY; bounds[2] = minZ;
+        bounds[3] = maxX; bounds[4] = maxY; bounds[5] = maxZ;
+    }
+
+    // Draw cost / memory report
+    size_t getVertexCount() const { return vertexCount; }
+    size_t getTriangleCount() const {
+        return lods.empty() ? 0 : lods[0].indexCount / 3;
+    }
+    int getLodCount() const { return (int)lods.size(); }
+    size_t getGpuBytes() const;
+    size_t getResidentBytes() const;
+    bool usesVertexBuffers() const { return vertexBufferId != 0; }
+    void printReport() const;
+
+    // Binary mesh cache (written next to the source as <file>.meshcache).
+    // Meshes found in AssetPack::shared() are read from the pack instead.
+    static bool cacheEnabled;
+    static int cacheHits;
+    static int cacheMisses;
+    static double totalLoadMs;
+
+    // Importer for .obj sources that miss the pack and cache. The built-in
+    // parser (objparser.h) falls back to Assimp on files it cannot read;
+    // other formats always go through Assimp. The choice is part of the
+    // cache key, so switching importers re-imports loose meshes.
+    enum ObjImporter { IMPORTER_ASSIMP, IMPORTER_BUILTIN };
+    static ObjImporter objImporter;
+    static unsigned objParseThreads; // > 1: parse chunks in parallel
+
+    // Indexed VBO path; falls back to display lists when disabled/unsupported
+    static bool useVertexBuffers;
+    static bool vertexBuffersSupported();
+    static bool halfFloatVerticesSupported();
+
+    // renderInstances() draws through a small vertex shader with per-instance
+    // matrix attributes (GL 2.0 + ARB_draw_instanced/ARB_instanced_arrays);
+    // the fragment stage stays fixed-function. Needs the indexed VBO path.
+    static bool useInstancing;
+    static bool instancingSupported();
+
+    // Streaming mode: load() queues the decode and returns at once. Until
+    // updateStreaming() (GL thread, once per frame) uploads the mesh, a first
+    // load has no size and render() draws the wire-cube placeholder; a
+    // reload keeps drawing the previous mesh.
+    // maxUploads limits uploads per call (0 = everything that is ready).
+    // Returns the number of meshes swapped in.
+    static bool streaming;
+    static int updateStreaming(int maxUploads = 0);
+    static int getStreamingCount() { return (int)streamQueue.size(); }
+    bool isStreaming() const { return streamStaging != nullptr; }
+
+    // Keep the packed CPU copy after GPU upload (off: only bounds, counts
+    // and the LOD table stay resident)
+    static bool retainCpuData;
+    // The same for this model alone; takes effect at its next upload
+    void setRetainCpuData(bool retain) { keepCpuData = retain; }
+    bool hasCpuData() const { return !vertices.empty(); }
+    // Model-space vertices and triangle indices of the first LOD with at
+    // most maxTriangles triangles (else the coarsest), for baking into other
+    // geometry. Fails while nothing is loaded or once the CPU copy has been
+    // released (see setRetainCpuData).
+    bool getMesh(size_t maxTriangles, std::vector<MeshVertex>& meshVertices,
+                 std::vector<unsigned int>& meshIndices) const;
+
+    // LOD selection from projected bounding-sphere size (fraction of half
+    // the viewport height). lodBias > 1 keeps detail longer.
+    static const int MAX_LODS = 4;
+    static float lodThresholds[MAX_LODS - 1];
+    static float lodBias;
 };
 
 #endif // MODEL_H
@@ -0,0 +1,137 @@
+// ============================================================================
+// ObjBench.cpp - OBJ Importer Benchmark
+// Times Assimp against the built-in parser on every .obj in a directory and
+// checks that both produce the same bounding box and triangle count
+// Usage: obj_bench [asset directory] [iterations]
+// ============================================================================
+
+#include "model.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+
+struct BenchResult {
+  bool ok;
+  double bestMs;
+  size_t triangles;
+  size_t vertices;
+  float bounds[6];
+};
+
+// Best-of-N decode time with the given importer (cache and pack bypassed)
+static BenchResult runImporter(const std::string &path,
+                               Model::ObjImporter importer, unsigned threads,
+                               int iterations) {
+  Model::objImporter = importer;
+  Model::objParseThreads = threads;
+  BenchResult result = {false, 1e30, 0, 0, {0, 0, 0, 0, 0, 0}};
+  for (int i = 0; i < iterations; i++) {
+    Model model;
+    auto start = std::chrono::steady_clock::now();
+    result.ok = model.decode(path.c_str());
+    double ms = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+    if (!result.ok)
+      return result;
+    result.bestMs = std::min(result.bestMs, ms);
+    result.triangles = model.getTriangleCount();
+    result.vertices = model.getVertexCount();
+    model.getBounds(result.bounds);
+  }
+  return result;
+}
+
+static bool sameBounds(const float *a, const float *b) {
+  // Assimp's float reader may round the last bit differently
+  for (int i = 0; i < 6; i++)
+    if (fabsf(a[i] - b[i]) > 1e-5f * fmaxf(1.0f, fabsf(a[i])))
+      return false;
+  return true;
+}
+
+int main(int argc, char **argv) {
+  std::string dir = argc > 1 ? argv[1] : "assets";
+  int iterations = argc > 2 ? std::max(1, atoi(argv[2])) : 5;
+  unsigned threads = std::max(2u, std::thread::hardware_concurrency());
+  Model::cacheEnabled = false;
+
+  DIR *d = opendir(dir.c_str());
+  if (!d) {
+    printf("Cannot open asset directory: %s\n", dir.c_str());
+    return 1;
+  }
+  std::vector<std::string> files;
+  while (dirent *entry = readdir(d)) {
+    std::string file = entry->d_name;
+    if (file.size() > 4 && file.compare(file.size() - 4, 4, ".obj") == 0)
+      files.push_back(file);
+  }
+  closedir(d);
+  std::sort(files.begin(), files.end());
+
+  printf("%-22s %9s %9s %10s %10s %10s %8s  %s\n", "file", "KB", "tris",
+         "assimp ms", "parser ms", "x threads", "speedup", "check");
+  double assimpTotal = 0.0, parserTotal = 0.0, threadedTotal = 0.0;
+  size_t bytesTotal = 0;
+  int mismatches = 0;
+  for (const std::string &file : files) {
+    std::string path = dir + "/" + file;
+    struct stat st;
+    size_t bytes = stat(path.c_str(), &st) == 0 ? (size_t)st.st_size : 0;
+
+    BenchResult assimp =
+        runImporter(path, Model::IMPORTER_ASSIMP, 1, iterations);
+    BenchResult parser =
+        runImporter(path, Model::IMPORTER_BUILTIN, 1, iterations);
+    BenchResult threaded =
+        runImporter(path, Model::IMPORTER_BUILTIN, threads, iterations);
+    if (!assimp.ok && !parser.ok) {
+      printf("%-22s %9.1f  (no geometry, skipped)\n", file.c_str(),
+             bytes / 1024.0);
+      continue;
+    }
+
+    bool match = assimp.ok && parser.ok && threaded.ok &&
+                 assimp.triangles == parser.triangles &&
+                 parser.triangles == threaded.triangles &&
+                 sameBounds(assimp.bounds, parser.bounds) &&
+                 sameBounds(parser.bounds, threaded.bounds);
+    if (!match)
+      mismatches++;
+    printf("%-22s %9.1f %9zu %10.2f %10.2f %10.2f %7.1fx  %s\n",
+           file.c_str(), bytes / 1024.0, parser.triangles, assimp.bestMs,
+           parser.bestMs, threaded.bestMs, assimp.bestMs / parser.bestMs,
+           match ? "ok" : "MISMATCH");
+    if (!match)
+      printf("  assimp: %zu tris [%g %g %g]-[%g %g %g], parser: %zu tris "
+             "[%g %g %g]-[%g %g %g]\n",
+             assimp.triangles, assimp.bounds[0], assimp.bounds[1],
+             assimp.bounds[2], assimp.bounds[3], assimp.bounds[4],
+             assimp.bounds[5], parser.triangles, parser.bounds[0],
+             parser.bounds[1], parser.bounds[2], parser.bounds[3],
+             parser.bounds[4], parser.bounds[5]);
+
+    assimpTotal += assimp.bestMs;
+    parserTotal += parser.bestMs;
+    threadedTotal += threaded.bestMs;
+    bytesTotal += bytes;
+  }
+
+  double mb = bytesTotal / (1024.0 * 1024.0);
+  printf("Total: %.2f MB, assimp %.2f ms (%.1f MB/s), parser %.2f ms "
+         "(%.1f MB/s), parser on %u threads %.2f ms (%.1f MB/s)\n",
+         mb, assimpTotal, mb / (assimpTotal / 1000.0), parserTotal,
+         mb / (parserTotal / 1000.0), threads, threadedTotal,
+         mb / (threadedTotal / 1000.0));
+  printf("%s\n", mismatches ? "Outputs differ" : "Outputs match");
+  return mismatches ? 1 : 0;
+}
@@ -0,0 +1,385 @@
+// ============================================================================
+// ObjParser.cpp - Fast Wavefront OBJ Reader Implementation
+// ============================================================================
+
+#include "objparser.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+
+namespace {
+
+// Face corner as written in the file. Absolute indices are stored 0-based;
+// negative (relative) indices are stored as chunk-local index - kRelative
+// (the local index is itself negative when it reaches into an earlier chunk)
+// and resolved once every chunk's element counts are known.
+const int kRelative = 1 << 30;
+const int kNoIndex = INT32_MAX;  // corner has no vt / vn
+const int kBadIndex = INT32_MIN; // index 0, never valid
+struct Corner {
+  int v, vt, vn;
+};
+
+struct Chunk {
+  std::vector<float> positions; // xyz
+  std::vector<float> texCoords; // uv
+  std::vector<float> normals;   // xyz
+  std::vector<Corner> corners;
+  std::vector<unsigned int> faceSizes;
+  bool ok = true;
+};
+
+inline bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+inline const char *skipSpace(const char *p, const char *end) {
+  while (p < end && isSpace(*p))
+    p++;
+  return p;
+}
+
+inline const char *parseFloat(const char *p, const char *end, float &value) {
+  p = skipSpace(p, end);
+  if (p < end && *p == '+')
+    p++;
+#if defined(__cpp_lib_to_chars)
+  auto result = std::from_chars(p, end, value);
+  return result.ec == std::errc() ? result.ptr : nullptr;
+#else
+  // No floating-point from_chars in this standard library: strtof on a
+  // bounded copy (the mapping is not NUL-terminated)
+  char buffer[64];
+  size_t n = 0;
+  while (p + n < end && n < sizeof(buffer) - 1 && !isSpace(p[n]) &&
+         p[n] != '\n')
+    n++;
+  memcpy(buffer, p, n);
+  buffer[n] = '\0';
+  char *stop;
+  value = strtof(buffer, &stop);
+  return stop == buffer ? nullptr : p + (stop - buffer);
+#endif
+}
+
+inline const char *parseIndex(const char *p, const char *end, int &value) {
+  bool negative = false;
+  if (p < end && *p == '-') {
+    negative = true;
+    p++;
+  }
+  if (p >= end || *p < '0' || *p > '9')
+    return nullptr;
+  int v = 0;
+  while (p < end && *p >= '0' && *p <= '9')
+    v = v * 10 + (*p++ - '0');
+  value = negative ? -v : v;
+  return p;
+}
+
+// Converts a file index (1-based or negative) into the Corner encoding
+inline int encodeIndex(int index, size_t localCount) {
+  if (index > 0)
+    return index - 1;
+  if (index < 0)
+    return (int)localCount + index - kRelative; // resolved at merge
+  return kBadIndex;
+}
+
+void parseChunk(const char *p, const char *end, Chunk &chunk) {
+  while (p < end) {
+    const char *lineEnd = (const char *)memchr(p, '\n', end - p);
+    if (!lineEnd)
+      lineEnd = end;
+    p = skipSpace(p, lineEnd);
+
+    if (p + 1 < lineEnd && p[0] == 'v' && isSpace(p[1])) {
+      float xyz[3];
+      const char *q = p + 1;
+      for (int i = 0; i < 3 && q; i++)
+        q = parseFloat(q, lineEnd, xyz[i]);
+      if (!q) {
+        chunk.ok = false;
+        return;
+      }
+      chunk.positions.insert(chunk.positions.end(), xyz, xyz + 3);
+    } else if (p + 2 < lineEnd && p[0] == 'v' && p[1] == 't' &&
+               isSpace(p[2])) {
+      float uv[2] = {0.0f, 0.0f};
+      const char *q = parseFloat(p + 2, lineEnd, uv[0]);
+      if (q) {
+        const char *r = parseFloat(q, lineEnd, uv[1]);
+        if (r)
+          q = r; // 1D texture coordinates keep v = 0
+      }
+      if (!q) {
+        chunk.ok = false;
+        return;
+      }
+      chunk.texCoords.insert(chunk.texCoords.end(), uv, uv + 2);
+    } else if (p + 2 < lineEnd && p[0] == 'v' && p[1] == 'n' &&
+               isSpace(p[2])) {
+      float xyz[3];
+      const char *q = p + 2;
+      for (int i = 0; i < 3 && q; i++)
+        q = parseFloat(q, lineEnd, xyz[i]);
+      if (!q) {
+        chunk.ok = false;
+        return;
+      }
+      chunk.normals.insert(chunk.normals.end(), xyz, xyz + 3);
+    } else if (p + 1 < lineEnd && p[0] == 'f' && isSpace(p[1])) {
+      size_t positionCount = chunk.positions.size() / 3;
+      size_t texCoordCount = chunk.texCoords.size() / 2;
+      size_t normalCount = chunk.normals.size() / 3;
+      unsigned int size = 0;
+      const char *q = skipSpace(p + 1, lineEnd);
+      while (q < lineEnd) {
+        Corner c = {0, kNoIndex, kNoIndex};
+        int index;
+        q = parseIndex(q, lineEnd, index);
+        if (!q) {
+          chunk.ok = false;
+          return;
+        }
+        c.v = encodeIndex(index, positionCount);
+        if (q < lineEnd && *q == '/') {
+          q++;
+          if (q < lineEnd && *q != '/') {
+            q = parseIndex(q, lineEnd, index);
+            if (!q) {
+              chunk.ok = false;
+              return;
+            }
+            c.vt = encodeIndex(index, texCoordCount);
+          }
+          if (q < lineEnd && *q == '/') {
+            q++;
+            if (q < lineEnd && !isSpace(*q)) {
+              q = parseIndex(q, lineEnd, index);
+              if (!q) {
+                chunk.ok = false;
+                return;
+              }
+              c.vn = encodeIndex(index, normalCount);
+            }
+          }
+        }
+        chunk.corners.push_back(c);
+        size++;
+        q = skipSpace(q, lineEnd);
+      }
+      chunk.faceSizes.push_back(size);
+    }
+    p = lineEnd + 1;
+  }
+}
+
+// Resolves a Corner index against the global element count
+inline bool resolve(int &index, size_t chunkBase, size_t total) {
+  if (index == kBadIndex)
+    return false;
+  if (index < 0)
+    index = (int)chunkBase + index + kRelative;
+  return index >= 0 && (size_t)index < total;
+}
+
+struct CornerKey {
+  int v, vt, vn;
+  bool operator==(const CornerKey &o) const {
+    return v == o.v && vt == o.vt && vn == o.vn;
+  }
+};
+
+struct CornerHash {
+  size_t operator()(const CornerKey &k) const {
+    return ((size_t)k.v * 73856093u) ^ ((size_t)k.vt * 19349663u) ^
+           ((size_t)k.vn * 83492791u);
+  }
+};
+
+} // namespace
+
+bool parseObj(const char *filename, ObjMesh &out, unsigned threads) {
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return false;
+  }
+  size_t size = (size_t)st.st_size;
+  void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd); // The mapping stays valid after the descriptor is closed
+  if (mapped == MAP_FAILED)
+    return false;
+  const char *data = (const char *)mapped;
+
+  // 1. Parse line-aligned chunks (in parallel when asked to)
+  if (threads < 1)
+    threads = 1;
+  if (size < ((size_t)1 << 20))
+    threads = 1; // Not worth the threads
+  std::vector<Chunk> chunks(threads);
+  std::vector<const char *> bounds(threads + 1);
+  bounds[0] = data;
+  bounds[threads] = data + size;
+  for (unsigned i = 1; i < threads; i++) {
+    const char *p = data + size * i / threads;
+    if (p < bounds[i - 1])
+      p = bounds[i - 1];
+    const char *nl = (const char *)memchr(p, '\n', data + size - p);
+    bounds[i] = nl ? nl + 1 : data + size;
+  }
+  if (threads == 1) {
+    parseChunk(bounds[0], bounds[1], chunks[0]);
+  } else {
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threads; i++)
+      workers.emplace_back(parseChunk, bounds[i], bounds[i + 1],
+                           std::ref(chunks[i]));
+    for (std::thread &worker : workers)
+      worker.join();
+  }
+  munmap(mapped, size);
+
+  // 2. Merge: resolve indices, dedupe corners, fan-triangulate polygons
+  size_t positionTotal = 0, texCoordTotal = 0, normalTotal = 0;
+  for (const Chunk &chunk : chunks) {
+    if (!chunk.ok) {
+      fprintf(stderr, "OBJ parse error: %s\n", filename);
+      return false;
+    }
+    positionTotal += chunk.positions.size() / 3;
+    texCoordTotal += chunk.texCoords.size() / 2;
+    normalTotal += chunk.normals.size() / 3;
+  }
+  std::vector<float> positions, texCoords, normals;
+  positions.reserve(positionTotal * 3);
+  texCoords.reserve(texCoordTotal * 2);
+  normals.reserve(normalTotal * 3);
+
+  out.vertices.clear();
+  out.indices.clear();
+  std::unordered_map<CornerKey, unsigned int, CornerHash> unique;
+  std::vector<int> vertexPosition; // output vertex -> position index
+  bool missingNormals = false;
+
+  size_t positionBase = 0, texCoordBase = 0, normalBase = 0;
+  std::vector<unsigned int> polygon;
+  for (Chunk &chunk : chunks) {
+    positions.insert(positions.end(), chunk.positions.begin(),
+                     chunk.positions.end());
+    texCoords.insert(texCoords.end(), chunk.texCoords.begin(),
+                     chunk.texCoords.end());
+    normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+
+    size_t corner = 0;
+    for (unsigned int faceSize : chunk.faceSizes) {
+      polygon.clear();
+      bool valid = faceSize >= 3;
+      for (unsigned int i = 0; i < faceSize; i++) {
+        Corner c = chunk.corners[corner + i];
+        if (!resolve(c.v, positionBase, positionTotal) ||
+            (c.vt != kNoIndex && !resolve(c.vt, texCoordBase, texCoordTotal)) ||
+            (c.vn != kNoIndex && !resolve(c.vn, normalBase, normalTotal))) {
+          valid = false;
+          break;
+        }
+        if (c.vn == kNoIndex)
+          missingNormals = true;
+
+        CornerKey key = {c.v, c.vt, c.vn};
+        auto it = unique.emplace(key, (unsigned int)out.vertices.size());
+        if (it.second) {
+          MeshVertex mv;
+          mv.position = {positions[c.v * 3], positions[c.v * 3 + 1],
+                         positions[c.v * 3 + 2]};
+          if (c.vn != kNoIndex)
+            mv.normal = {normals[c.vn * 3], normals[c.vn * 3 + 1],
+                         normals[c.vn * 3 + 2]};
+          else
+            mv.normal = {0.0f, 0.0f, 0.0f};
+          if (c.vt != kNoIndex)
+            mv.uv = {texCoords[c.vt * 2], 1.0f - texCoords[c.vt * 2 + 1]};
+          else
+            mv.uv = {0.0f, 0.0f};
+          out.vertices.push_back(mv);
+          vertexPosition.push_back(c.v);
+        }
+        polygon.push_back(it.first->second);
+      }
+      corner += faceSize;
+      if (!valid)
+        continue;
+      for (size_t i = 1; i + 1 < polygon.size(); i++) {
+        out.indices.push_back(polygon[0]);
+        out.indices.push_back(polygon[i]);
+        out.indices.push_back(polygon[i + 1]);
+      }
+    }
+    positionBase += chunk.positions.size() / 3;
+    texCoordBase += chunk.texCoords.size() / 2;
+    normalBase += chunk.normals.size() / 3;
+  }
+
+  if (out.indices.empty())
+    return false;
+
+  // 3. Smooth normals for corners the file gave none: average the unit face
+  // normals around each position
+  if (missingNormals) {
+    std::vector<float> sums(positionTotal * 3, 0.0f);
+    for (size_t i = 0; i + 2 < out.indices.size(); i += 3) {
+      const Vertex &a = out.vertices[out.indices[i]].position;
+      const Vertex &b = out.vertices[out.indices[i + 1]].position;
+      const Vertex &c = out.vertices[out.indices[i + 2]].position;
+      float e1[3] = {b.x - a.x, b.y - a.y, b.z - a.z};
+      float e2[3] = {c.x - a.x, c.y - a.y, c.z - a.z};
+      float n[3] = {e1[1] * e2[2] - e1[2] * e2[1],
+                    e1[2] * e2[0] - e1[0] * e2[2],
+                    e1[0] * e2[1] - e1[1] * e2[0]};
+      float len = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+      if (len <= 0.0f)
+        continue;
+      for (int k = 0; k < 3; k++) {
+        int pos = vertexPosition[out.indices[i + k]];
+        for (int j = 0; j < 3; j++)
+          sums[pos * 3 + j] += n[j] / len;
+      }
+    }
+    for (size_t v = 0; v < out.vertices.size(); v++) {
+      Normal &n = out.vertices[v].normal;
+      if (n.x != 0.0f || n.y != 0.0f || n.z != 0.0f)
+        continue;
+      const float *s = &sums[vertexPosition[v] * 3];
+      float len = sqrtf(s[0] * s[0] + s[1] * s[1] + s[2] * s[2]);
+      if (len > 0.0f)
+        n = {s[0] / len, s[1] / len, s[2] / len};
+      else
+        n = {0.0f, 1.0f, 0.0f};
+    }
+  }
+
+  // 4. Bounds of the referenced vertices
+  out.bounds[0] = out.bounds[1] = out.bounds[2] = 1e9f;
+  out.bounds[3] = out.bounds[4] = out.bounds[5] = -1e9f;
+  for (const MeshVertex &mv : out.vertices) {
+    const float p[3] = {mv.position.x, mv.position.y, mv.position.z};
+    for (int k = 0; k < 3; k++) {
+      out.bounds[k] = fminf(out.bounds[k], p[k]);
+      out.bounds[k + 3] = fmaxf(out.bounds[k + 3], p[k]);
+    }
+  }
+  return true;
+}
@@ -0,0 +1,25 @@
+// ============================================================================
+// ObjParser.h - Fast Wavefront OBJ Reader
+// Built-in alternative to Assimp for the plain .obj meshes the game ships
+// ============================================================================
+
+#ifndef OBJPARSER_H
+#define OBJPARSER_H
+
+#include "model.h"
+#include <vector>
+
+struct ObjMesh {
+    std::vector<MeshVertex> vertices;
+    std::vector<unsigned int> indices; // 3 per triangle
+    float bounds[6];                   // minX, minY, minZ, maxX, maxY, maxZ
+};
+
+// Parses filename into an indexed triangle mesh, matching what Model's
+// Assimp flags produce: polygons fan-triangulated, V flipped, smooth normals
+// generated when the file has none, identical (v, vt, vn) corners shared.
+// The file is mmap'd; threads > 1 parses line-aligned chunks in parallel.
+// Only v/vt/vn/f records are read (groups, materials, lines are ignored).
+bool parseObj(const char* filename, ObjMesh& out, unsigned threads = 1);
+
+#endif // OBJPARSER_H
@@ -0,0 +1,339 @@
+// ============================================================================
+// Occlusion.cpp - Software Occlusion Culling Implementation
+// ============================================================================
+
+#include "occlusion.h"
+#include "atlas.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+bool OcclusionBuffer::enabled = true;
+int OcclusionBuffer::testedCount = 0;
+int OcclusionBuffer::occludedCount = 0;
+
+// ============================================================================
+// FOUR-WIDE LANES
+// The rasterizer walks each row four texels at a time
+// ============================================================================
+
+#if defined(__SSE2__)
+typedef __m128 Lanes;
+typedef __m128 LaneMask;
+
+static inline Lanes lanesSet(float v) { return _mm_set1_ps(v); }
+static inline Lanes lanesRamp(float base, float step) {
+  return _mm_setr_ps(base, base + step, base + 2 * step, base + 3 * step);
+}
+static inline Lanes lanesAdd(Lanes a, Lanes b) { return _mm_add_ps(a, b); }
+static inline LaneMask insideAll(Lanes a, Lanes b, Lanes c) {
+  Lanes zero = _mm_setzero_ps();
+  return _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(a, zero), _mm_cmpge_ps(b, zero)),
+                    _mm_cmpge_ps(c, zero));
+}
+static inline void storeNearer(float *dst, Lanes z, LaneMask inside) {
+  Lanes old = _mm_loadu_ps(dst);
+  Lanes nearer = _mm_max_ps(old, z);
+  _mm_storeu_ps(dst, _mm_or_ps(_mm_and_ps(inside, nearer),
+                               _mm_andnot_ps(inside, old)));
+}
+#elif defined(__ARM_NEON)
+typedef float32x4_t Lanes;
+typedef uint32x4_t LaneMask;
+
+static inline Lanes lanesSet(float v) { return vdupq_n_f32(v); }
+static inline Lanes lanesRamp(float base, float step) {
+  float lanes[4] = {base, base + step, base + 2 * step, base + 3 * step};
+  return vld1q_f32(lanes);
+}
+static inline Lanes lanesAdd(Lanes a, Lanes b) { return vaddq_f32(a, b); }
+static inline LaneMask insideAll(Lanes a, Lanes b, Lanes c) {
+  Lanes zero = vdupq_n_f32(0.0f);
+  return vandq_u32(vandq_u32(vcgeq_f32(a, zero), vcgeq_f32(b, zero)),
+                   vcgeq_f32(c, zero));
+}
+static inline void storeNearer(float *dst, Lanes z, LaneMask inside) {
+  Lanes old = vld1q_f32(dst);
+  vst1q_f32(dst, vbslq_f32(inside, vmaxq_f32(old, z), old));
+}
+#else
+struct Lanes {
+  float v[4];
+};
+struct LaneMask {
+  bool v[4];
+};
+
+static inline Lanes lanesSet(float v) { return {{v, v, v, v}}; }
+static inline Lanes lanesRamp(float base, float step) {
+  return {{base, base + step, base + 2 * step, base + 3 * step}};
+}
+static inline Lanes lanesAdd(Lanes a, Lanes b) {
+  return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2],
+           a.v[3] + b.v[3]}};
+}
+static inline LaneMask insideAll(Lanes a, Lanes b, Lanes c) {
+  LaneMask mask;
+  for (int i = 0; i < 4; i++)
+    mask.v[i] = a.v[i] >= 0.0f && b.v[i] >= 0.0f && c.v[i] >= 0.0f;
+  return mask;
+}
+static inline void storeNearer(float *dst, Lanes z, LaneMask inside) {
+  for (int i = 0; i < 4; i++)
+    if (inside.v[i] && z.v[i] > dst[i])
+      dst[i] = z.v[i];
+}
+#endif
+
+// ============================================================================
+// OCCLUSION BUFFER
+// ============================================================================
+
+OcclusionBuffer::OcclusionBuffer()
+    : depth(width * height, 0.0f), active(false), occluderCount(0),
+      debugTexture(0) {
+  for (int i = 0; i < 16; i++)
+    clip[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+}
+
+OcclusionBuffer::~OcclusionBuffer() {
+  if (debugTexture != 0)
+    glDeleteTextures(1, &debugTexture);
+}
+
+void OcclusionBuffer::begin() {
+  GLfloat mv[16], proj[16];
+  glGetFloatv(GL_MODELVIEW_MATRIX, mv);
+  glGetFloatv(GL_PROJECTION_MATRIX, proj);
+  // clip = proj * mv, column-major
+  for (int c = 0; c < 4; c++)
+    for (int r = 0; r < 4; r++)
+      clip[c * 4 + r] = proj[r] * mv[c * 4] + proj[4 + r] * mv[c * 4 + 1] +
+                        proj[8 + r] * mv[c * 4 + 2] +
+                        proj[12 + r] * mv[c * 4 + 3];
+  std::fill(depth.begin(), depth.end(), 0.0f);
+  occluderCount = 0;
+  active = true;
+}
+
+void OcclusionBuffer::transform(float x, float y, float z,
+                                float out[4]) const {
+  for (int r = 0; r < 4; r++)
+    out[r] = clip[r] * x + clip[4 + r] * y + clip[8 + r] * z + clip[12 + r];
+}
+
+void OcclusionBuffer::addBox(float minX, float minY, float minZ, float maxX,
+                             float maxY, float maxZ) {
+  float corners[8][4];
+  for (int i = 0; i < 8; i++)
+    transform(i & 1 ? maxX : minX, i & 2 ? maxY : minY, i & 4 ? maxZ : minZ,
+              corners[i]);
+  // Two triangles per face; the winding does not matter
+  static const int faces[6][4] = {{0, 1, 3, 2}, {4, 5, 7, 6}, {0, 1, 5, 4},
+                                  {2, 3, 7, 6}, {0, 2, 6, 4}, {1, 3, 7, 5}};
+  for (const int *f : faces) {
+    rasterizeTriangle(corners[f[0]], corners[f[1]], corners[f[2]]);
+    rasterizeTriangle(corners[f[0]], corners[f[2]], corners[f[3]]);
+  }
+  occluderCount++;
+}
+
+void OcclusionBuffer::addPyramid(float x, float y, float z, float baseSize,
+                                 float height) {
+  float half = baseSize / 2.0f;
+  float base[4][4], apex[4];
+  transform(x - half, y, z + half, base[0]);
+  transform(x + half, y, z + half, base[1]);
+  transform(x + half, y, z - half, base[2]);
+  transform(x - half, y, z - half, base[3]);
+  transform(x, y + height, z, apex);
+  for (int i = 0; i < 4; i++)
+    rasterizeTriangle(base[i], base[(i + 1) % 4], apex);
+  occluderCount++;
+}
+
+// Point where the edge a-b crosses the near plane (z + w = 0)
+static void nearIntersection(const float *a, const float *b, float *out) {
+  float da = a[2] + a[3], db = b[2] + b[3];
+  float t = da / (da - db);
+  for (int i = 0; i < 4; i++)
+    out[i] = a[i] + (b[i] - a[i]) * t;
+}
+
+void OcclusionBuffer::rasterizeTriangle(const float *a, const float *b,
+                                        const float *c) {
+  // Sutherland-Hodgman against the near plane only; the other planes are
+  // handled by clamping to the buffer
+  const float *in[3] = {a, b, c};
+  float clipped[4][4];
+  int count = 0;
+  for (int i = 0; i < 3; i++) {
+    const float *p = in[i], *q = in[(i + 1) % 3];
+    bool pInside = p[2] + p[3] >= 0.0f, qInside = q[2] + q[3] >= 0.0f;
+    if (pInside)
+      std::copy(p, p + 4, clipped[count++]);
+    if (pInside != qInside)
+      nearIntersection(p, q, clipped[count++]);
+  }
+  if (count < 3)
+    return;
+
+  float screen[4][3];
+  for (int i = 0; i < count; i++) {
+    float w = clipped[i][3];
+    if (w <= 1e-6f)
+      return;
+    screen[i][0] = (clipped[i][0] / w * 0.5f + 0.5f) * width;
+    screen[i][1] = (clipped[i][1] / w * 0.5f + 0.5f) * height;
+    screen[i][2] = 1.0f / w;
+  }
+  rasterizeScreen(screen[0], screen[1], screen[2]);
+  if (count == 4)
+    rasterizeScreen(screen[0], screen[2], screen[3]);
+}
+
+void OcclusionBuffer::rasterizeScreen(const float *a, const float *b,
+                                      const float *c) {
+  float area = (b[0] - a[0]) * (c[1] - a[1]) - (c[0] - a[0]) * (b[1] - a[1]);
+  if (std::fabs(area) < 1e-6f)
+    return;
+  if (area < 0.0f) {
+    std::swap(b, c);
+    area = -area;
+  }
+
+  int minX = std::max(0, (int)std::floor(std::min({a[0], b[0], c[0]})));
+  int maxX = std::min(width - 1, (int)std::ceil(std::max({a[0], b[0], c[0]})));
+  int minY = std::max(0, (int)std::floor(std::min({a[1], b[1], c[1]})));
+  int maxY =
+      std::min(height - 1, (int)std::ceil(std::max({a[1], b[1], c[1]})));
+  if (minX > maxX || minY > maxY)
+    return;
+  minX &= ~3; // Rows are walked in aligned groups of four
+
+  // Edge functions, each weighting the vertex opposite its edge; 1/w
+  // interpolates with the same weights
+  const float *v[3] = {a, b, c};
+  float stepX[3], stepY[3], origin[3];
+  float cx = minX + 0.5f, cy = minY + 0.5f;
+  for (int i = 0; i < 3; i++) {
+    const float *p = v[(i + 1) % 3], *q = v[(i + 2) % 3];
+    stepX[i] = -(q[1] - p[1]);
+    stepY[i] = q[0] - p[0];
+    origin[i] = (q[0] - p[0]) * (cy - p[1]) - (q[1] - p[1]) * (cx - p[0]);
+  }
+  float zX = 0.0f, zY = 0.0f, zOrigin = 0.0f;
+  for (int i = 0; i < 3; i++) {
+    zX += stepX[i] * v[i][2] / area;
+    zY += stepY[i] * v[i][2] / area;
+    zOrigin += origin[i] * v[i][2] / area;
+  }
+
+  Lanes edgeStep0 = lanesSet(4 * stepX[0]), edgeStep1 = lanesSet(4 * stepX[1]),
+        edgeStep2 = lanesSet(4 * stepX[2]), zStep = lanesSet(4 * zX);
+  for (int y = minY; y <= maxY; y++) {
+    int row = y - minY;
+    Lanes e0 = lanesRamp(origin[0] + row * stepY[0], stepX[0]);
+    Lanes e1 = lanesRamp(origin[1] + row * stepY[1], stepX[1]);
+    Lanes e2 = lanesRamp(origin[2] + row * stepY[2], stepX[2]);
+    Lanes z = lanesRamp(zOrigin + row * zY, zX);
+    float *texels = depth.data() + (size_t)y * width;
+    for (int x = minX; x <= maxX; x += 4) {
+      storeNearer(texels + x, z, insideAll(e0, e1, e2));
+      e0 = lanesAdd(e0, edgeStep0);
+      e1 = lanesAdd(e1, edgeStep1);
+      e2 = lanesAdd(e2, edgeStep2);
+      z = lanesAdd(z, zStep);
+    }
+  }
+}
+
+bool OcclusionBuffer::sphereVisible(float x, float y, float z,
+                                    float radius) const {
+  return boxVisible(x - radius, y - radius, z - radius, x + radius,
+                    y + radius, z + radius);
+}
+
+bool OcclusionBuffer::boxVisible(float minX, float minY, float minZ,
+                                 float maxX, float maxY, float maxZ) const {
+  if (!enabled || !active || occluderCount == 0)
+    return true;
+  testedCount++;
+
+  // w is affine in position, so the nearest point of the box is a corner
+  float left = 1e30f, right = -1e30f, bottom = 1e30f, top = -1e30f;
+  float nearest = 0.0f;
+  for (int i = 0; i < 8; i++) {
+    float p[4];
+    transform(i & 1 ? maxX : minX, i & 2 ? maxY : minY, i & 4 ? maxZ : minZ,
+              p);
+    if (p[2] + p[3] < 0.0f || p[3] <= 1e-6f)
+      return true; // Reaches past the near plane
+    float sx = (p[0] / p[3] * 0.5f + 0.5f) * width;
+    float sy = (p[1] / p[3] * 0.5f + 0.5f) * height;
+    left = std::min(left, sx);
+    right = std::max(right, sx);
+    bottom = std::min(bottom, sy);
+    top = std::max(top, sy);
+    nearest = std::max(nearest, 1.0f / p[3]);
+  }
+
+  // One texel of slack for occluder edges that only cover texel centres
+  int x0 = std::max(0, (int)std::floor(left) - 1);
+  int x1 = std::min(width - 1, (int)std::ceil(right) + 1);
+  int y0 = std::max(0, (int)std::floor(bottom) - 1);
+  int y1 = std::min(height - 1, (int)std::ceil(top) + 1);
+  if (x0 > x1 || y0 > y1)
+    return true; // Off screen; the frustum decides
+  for (int y = y0; y <= y1; y++) {
+    const float *texels = depth.data() + (size_t)y * width;
+    for (int x = x0; x <= x1; x++)
+      if (texels[x] <= nearest)
+        return true;
+  }
+  occludedCount++;
+  return false;
+}
+
+void OcclusionBuffer::drawDebug(float x, float y, float w, float h) {
+  float nearest = 0.0f;
+  for (float d : depth)
+    nearest = std::max(nearest, d);
+  // Empty texels stay black; the rest brighten towards the nearest one
+  std::vector<unsigned char> pixels(depth.size(), 0);
+  for (size_t i = 0; i < depth.size(); i++)
+    if (depth[i] > 0.0f)
+      pixels[i] = (unsigned char)(40 + 215 * std::sqrt(depth[i] / nearest));
+
+  if (debugTexture == 0) {
+    glGenTextures(1, &debugTexture);
+    bindTexture(debugTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  } else {
+    bindTexture(debugTexture);
+  }
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, width, height, 0,
+               GL_LUMINANCE, GL_UNSIGNED_BYTE, pixels.data());
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+  glEnable(GL_TEXTURE_2D);
+  glColor3f(1.0f, 1.0f, 1.0f);
+  glBegin(GL_QUADS);
+  glTexCoord2f(0, 0);
+  glVertex2f(x, y);
+  glTexCoord2f(1, 0);
+  glVertex2f(x + w, y);
+  glTexCoord2f(1, 1);
+  glVertex2f(x + w, y + h);
+  glTexCoord2f(0, 1);
+  glVertex2f(x, y + h);
+  glEnd();
+  glDisable(GL_TEXTURE_2D);
+}
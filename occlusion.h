@@ -0,0 +1,67 @@
+// ============================================================================
+// Occlusion.h - Software Occlusion Culling
+// Rasterizes a few large occluders into a low-resolution depth buffer on the
+// CPU, so entities hidden behind them are skipped before they are drawn
+// ============================================================================
+
+#ifndef OCCLUSION_H
+#define OCCLUSION_H
+
+#include "utils.h"
+#include <vector>
+
+// Depth is stored as 1/w (larger is nearer, 0 is empty), which interpolates
+// linearly across the screen. Rows run bottom to top, like GL window space.
+class OcclusionBuffer {
+private:
+    std::vector<float> depth;
+    float clip[16]; // projection * modelview, column-major
+    bool active;
+    int occluderCount;
+    GLuint debugTexture;
+
+    // Clip-space position of a world-space point
+    void transform(float x, float y, float z, float out[4]) const;
+    // Triangle in clip space, clipped against the near plane
+    void rasterizeTriangle(const float *a, const float *b, const float *c);
+    // Triangle in buffer coordinates (x, y, 1/w)
+    void rasterizeScreen(const float *a, const float *b, const float *c);
+
+public:
+    static const int width = 256;
+    static const int height = 128;
+
+    OcclusionBuffer();
+    ~OcclusionBuffer();
+    OcclusionBuffer(const OcclusionBuffer&) = delete;
+    OcclusionBuffer& operator=(const OcclusionBuffer&) = delete;
+
+    // Clears the buffer and takes the current GL projection * modelview
+    // (call after the camera is applied). Until begin(), nothing is occluded.
+    void begin();
+
+    // Occluders must lie inside what is actually drawn for them
+    void addBox(float minX, float minY, float minZ, float maxX, float maxY,
+                float maxZ);
+    void addPyramid(float x, float y, float z, float baseSize, float height);
+
+    // False only if the bounds are entirely behind rasterized occluders
+    bool sphereVisible(float x, float y, float z, float radius) const;
+    bool boxVisible(float minX, float minY, float minZ, float maxX,
+                    float maxY, float maxZ) const;
+
+    int getOccluderCount() const { return occluderCount; }
+
+    // Draws the buffer as a grey-scale quad (nearer is brighter) at x, y in
+    // the current projection; used by the HUD's 2D pass
+    void drawDebug(float x, float y, float w, float h);
+
+    // Occlusion tests are skipped (everything passes) while this is cleared
+    static bool enabled;
+    // Per-frame counts of tests made and of draws skipped by them
+    static int testedCount;
+    static int occludedCount;
+    static void resetCounts() { testedCount = occludedCount = 0; }
+};
+
+#endif // OCCLUSION_H
@@ -0,0 +1,467 @@
+// ============================================================================
+// Pack.cpp - Single-File Asset Pack Implementation
+// ============================================================================
+
+#include "pack.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char kPackMagic[8] = {'S', 'T', 'E', 'P', 'A', 'C', 'K', '1'};
+static const uint32_t kPackVersion = 1;
+static const uint32_t kFlagLz4 = 1;
+
+struct PackHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t entryCount;
+  uint64_t namesOffset;
+  uint64_t namesSize;
+};
+
+struct PackEntry {
+  uint32_t nameOffset; // into the name table
+  uint32_t nameLength;
+  uint32_t flags;
+  uint32_t reserved;
+  uint64_t offset;
+  uint64_t storedSize;
+  uint64_t rawSize;
+};
+
+// ============================================================================
+// LZ4 BLOCK CODEC
+// ============================================================================
+
+static const size_t kMinMatch = 4;
+static const size_t kLastLiterals = 5; // Block must end in literals
+static const size_t kMatchSafeEnd = 12; // No match may start after this
+static const int kHashBits = 16;
+
+static uint32_t read32(const unsigned char *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static uint32_t hashSequence(uint32_t sequence) {
+  return (sequence * 2654435761u) >> (32 - kHashBits);
+}
+
+// Writes an LZ4 extended length (the part that did not fit in the token)
+static bool writeLength(size_t length, unsigned char *&op,
+                        const unsigned char *oend) {
+  while (length >= 255) {
+    if (op >= oend)
+      return false;
+    *op++ = 255;
+    length -= 255;
+  }
+  if (op >= oend)
+    return false;
+  *op++ = (unsigned char)length;
+  return true;
+}
+
+static bool emitSequence(const unsigned char *literals, size_t literalLength,
+                         size_t matchLength, size_t offset, unsigned char *&op,
+                         const unsigned char *oend) {
+  if (op >= oend)
+    return false;
+  unsigned char *token = op++;
+  *token = (unsigned char)((literalLength >= 15 ? 15 : literalLength) << 4);
+  if (literalLength >= 15 && !writeLength(literalLength - 15, op, oend))
+    return false;
+  if ((size_t)(oend - op) < literalLength)
+    return false;
+  if (literalLength > 0)
+    memcpy(op, literals, literalLength);
+  op += literalLength;
+
+  if (matchLength == 0)
+    return true; // Final literal run
+
+  if (oend - op < 2)
+    return false;
+  *op++ = (unsigned char)(offset & 0xff);
+  *op++ = (unsigned char)(offset >> 8);
+  size_t extra = matchLength - kMinMatch;
+  *token |= (unsigned char)(extra >= 15 ? 15 : extra);
+  if (extra >= 15 && !writeLength(extra - 15, op, oend))
+    return false;
+  return true;
+}
+
+size_t lz4CompressBound(size_t size) { return size + size / 255 + 16; }
+
+size_t lz4Compress(const unsigned char *src, size_t size, unsigned char *dst,
+                   size_t capacity) {
+  unsigned char *op = dst;
+  const unsigned char *oend = dst + capacity;
+  const unsigned char *anchor = src;
+
+  if (size > kMatchSafeEnd) {
+    std::vector<uint32_t> table((size_t)1 << kHashBits, UINT32_MAX);
+    size_t matchLimit = size - kLastLiterals;
+    size_t ip = 0;
+    while (ip + kMatchSafeEnd <= size) {
+      uint32_t sequence = read32(src + ip);
+      uint32_t h = hashSequence(sequence);
+      uint32_t candidate = table[h];
+      table[h] = (uint32_t)ip;
+
+      if (candidate == UINT32_MAX || ip - candidate > 65535 ||
+          read32(src + candidate) != sequence) {
+        ip++;
+        continue;
+      }
+
+      // Extend forwards, leaving the last literals alone
+      size_t length = kMinMatch;
+      while (ip + length < matchLimit &&
+             src[candidate + length] == src[ip + length])
+        length++;
+      // And backwards over pending literals
+      while (ip > (size_t)(anchor - src) && candidate > 0 &&
+             src[ip - 1] == src[candidate - 1]) {
+        ip--;
+        candidate--;
+        length++;
+      }
+
+      if (!emitSequence(anchor, src + ip - anchor, length, ip - candidate, op,
+                        oend))
+        return 0;
+      ip += length;
+      anchor = src + ip;
+      if (ip >= 2 && ip + kMatchSafeEnd <= size)
+        table[hashSequence(read32(src + ip - 2))] = (uint32_t)(ip - 2);
+    }
+  }
+
+  if (!emitSequence(anchor, src + size - anchor, 0, 0, op, oend))
+    return 0;
+  return op - dst;
+}
+
+bool lz4Decompress(const unsigned char *src, size_t size, unsigned char *dst,
+                   size_t rawSize) {
+  const unsigned char *ip = src;
+  const unsigned char *iend = src + size;
+  unsigned char *op = dst;
+  unsigned char *oend = dst + rawSize;
+
+  while (ip < iend) {
+    unsigned token = *ip++;
+
+    size_t literalLength = token >> 4;
+    if (literalLength == 15) {
+      unsigned char s;
+      do {
+        if (ip >= iend)
+          return false;
+        s = *ip++;
+        literalLength += s;
+      } while (s == 255);
+    }
+    if ((size_t)(iend - ip) < literalLength ||
+        (size_t)(oend - op) < literalLength)
+      return false;
+    if (literalLength > 0)
+      memcpy(op, ip, literalLength);
+    ip += literalLength;
+    op += literalLength;
+
+    if (ip == iend)
+      break; // The last sequence has no match
+
+    if (iend - ip < 2)
+      return false;
+    size_t offset = ip[0] | ((size_t)ip[1] << 8);
+    ip += 2;
+    if (offset == 0 || offset > (size_t)(op - dst))
+      return false;
+
+    size_t matchLength = token & 15;
+    if (matchLength == 15) {
+      unsigned char s;
+      do {
+        if (ip >= iend)
+          return false;
+        s = *ip++;
+        matchLength += s;
+      } while (s == 255);
+    }
+    matchLength += kMinMatch;
+    if ((size_t)(oend - op) < matchLength)
+      return false;
+
+    // Overlapping matches repeat the pattern, so copy those byte by byte
+    const unsigned char *match = op - offset;
+    if (offset >= matchLength) {
+      memcpy(op, match, matchLength);
+    } else {
+      for (size_t i = 0; i < matchLength; i++)
+        op[i] = match[i];
+    }
+    op += matchLength;
+  }
+  return op == oend;
+}
+
+// ============================================================================
+// PACK READER
+// ============================================================================
+
+std::shared_ptr<const unsigned char> mapFile(const char *path, size_t &size) {
+  size = 0;
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0)
+    return nullptr;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    ::close(fd);
+    return nullptr;
+  }
+  size_t mappedSize = (size_t)st.st_size;
+  void *map = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED)
+    return nullptr;
+  size = mappedSize;
+  return std::shared_ptr<const unsigned char>(
+      (const unsigned char *)map, [mappedSize](const unsigned char *p) {
+        munmap((void *)p, mappedSize);
+      });
+}
+
+AssetPack::AssetPack() {
+  mapped = nullptr;
+  mappedSize = 0;
+}
+
+AssetPack::~AssetPack() { close(); }
+
+bool AssetPack::open(const char *packPath) {
+  close();
+
+  int fd = ::open(packPath, O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(PackHeader)) {
+    ::close(fd);
+    return false;
+  }
+  size_t size = (size_t)st.st_size;
+  void *map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd); // The mapping stays valid after the descriptor is closed
+  if (map == MAP_FAILED)
+    return false;
+
+  const unsigned char *bytes = (const unsigned char *)map;
+  const PackHeader *header = (const PackHeader *)bytes;
+  size_t indexEnd =
+      sizeof(PackHeader) + (size_t)header->entryCount * sizeof(PackEntry);
+  bool valid = memcmp(header->magic, kPackMagic, sizeof(kPackMagic)) == 0 &&
+               header->version == kPackVersion && indexEnd <= size &&
+               header->namesOffset >= indexEnd &&
+               header->namesOffset + header->namesSize <= size;
+
+  const PackEntry *index = (const PackEntry *)(bytes + sizeof(PackHeader));
+  const char *names = (const char *)(bytes + header->namesOffset);
+  for (uint32_t i = 0; valid && i < header->entryCount; i++) {
+    const PackEntry &e = index[i];
+    valid = (uint64_t)e.nameOffset + e.nameLength <= header->namesSize &&
+            e.offset + e.storedSize <= size &&
+            ((e.flags & kFlagLz4) || e.storedSize == e.rawSize);
+    if (valid)
+      entries[std::string(names + e.nameOffset, e.nameLength)] = {
+          e.offset, e.storedSize, e.rawSize, (e.flags & kFlagLz4) != 0};
+  }
+
+  if (!valid) {
+    printf("Asset pack is damaged or outdated: %s\n", packPath);
+    munmap(map, size);
+    entries.clear();
+    return false;
+  }
+
+  mapped = bytes;
+  mappedSize = size;
+  path = packPath;
+  return true;
+}
+
+void AssetPack::close() {
+  if (mapped)
+    munmap((void *)mapped, mappedSize);
+  mapped = nullptr;
+  mappedSize = 0;
+  entries.clear();
+  for (auto &e : extracted)
+    remove(e.second.c_str());
+  extracted.clear();
+}
+
+bool AssetPack::contains(const char *name) const {
+  return mapped && entries.count(name) != 0;
+}
+
+bool AssetPack::get(const char *name, AssetView &view,
+                    std::vector<unsigned char> &scratch) const {
+  if (!mapped)
+    return false;
+  auto it = entries.find(name);
+  if (it == entries.end())
+    return false;
+
+  const Entry &e = it->second;
+  if (!e.compressed) {
+    view.data = mapped + e.offset;
+    view.size = (size_t)e.rawSize;
+    return true;
+  }
+  scratch.resize((size_t)e.rawSize);
+  if (!lz4Decompress(mapped + e.offset, (size_t)e.storedSize, scratch.data(),
+                     scratch.size())) {
+    printf("Asset pack: corrupt entry %s\n", name);
+    return false;
+  }
+  view.data = scratch.data();
+  view.size = scratch.size();
+  return true;
+}
+
+std::string AssetPack::extractToFile(const char *name) {
+  auto done = extracted.find(name);
+  if (done != extracted.end())
+    return done->second;
+
+  AssetView view;
+  std::vector<unsigned char> scratch;
+  if (!get(name, view, scratch))
+    return name;
+
+  const char *tmpDir = getenv("TMPDIR");
+  std::string base = name;
+  size_t slash = base.find_last_of('/');
+  if (slash != std::string::npos)
+    base = base.substr(slash + 1);
+  std::string file = std::string(tmpDir ? tmpDir : "/tmp") + "/shadow_temple_" +
+                     std::to_string((long)getpid()) + "_" + base;
+
+  FILE *out = fopen(file.c_str(), "wb");
+  if (!out)
+    return name;
+  bool ok = fwrite(view.data, 1, view.size, out) == view.size;
+  ok = (fclose(out) == 0) && ok;
+  if (!ok) {
+    remove(file.c_str());
+    return name;
+  }
+  extracted[name] = file;
+  return file;
+}
+
+AssetPack &AssetPack::shared() {
+  static AssetPack pack;
+  return pack;
+}
+
+// ============================================================================
+// PACK WRITER
+// ============================================================================
+
+void AssetPackWriter::add(const std::string &name,
+                          const std::vector<unsigned char> &data) {
+  Blob blob;
+  blob.name = name;
+  blob.rawSize = data.size();
+  blob.compressed = false;
+
+  std::vector<unsigned char> packed(lz4CompressBound(data.size()));
+  size_t packedSize =
+      lz4Compress(data.data(), data.size(), packed.data(), packed.size());
+  if (packedSize > 0 && packedSize < data.size() - data.size() / 8) {
+    packed.resize(packedSize);
+    blob.data.swap(packed);
+    blob.compressed = true;
+  } else {
+    blob.data = data;
+  }
+  blobs.push_back(std::move(blob));
+}
+
+bool AssetPackWriter::write(const char *packPath) const {
+  PackHeader header;
+  memcpy(header.magic, kPackMagic, sizeof(kPackMagic));
+  header.version = kPackVersion;
+  header.entryCount = (uint32_t)blobs.size();
+  header.namesOffset =
+      sizeof(PackHeader) + (uint64_t)blobs.size() * sizeof(PackEntry);
+
+  std::string names;
+  std::vector<PackEntry> index(blobs.size());
+  for (size_t i = 0; i < blobs.size(); i++) {
+    index[i].nameOffset = (uint32_t)names.size();
+    index[i].nameLength = (uint32_t)blobs[i].name.size();
+    names += blobs[i].name;
+  }
+  header.namesSize = names.size();
+
+  // Blobs start 16-byte aligned so mesh/texture views can be read in place
+  uint64_t offset = header.namesOffset + header.namesSize;
+  for (size_t i = 0; i < blobs.size(); i++) {
+    offset = (offset + 15) & ~(uint64_t)15;
+    index[i].flags = blobs[i].compressed ? kFlagLz4 : 0;
+    index[i].reserved = 0;
+    index[i].offset = offset;
+    index[i].storedSize = blobs[i].data.size();
+    index[i].rawSize = blobs[i].rawSize;
+    offset += blobs[i].data.size();
+  }
+
+  std::string tmpPath = std::string(packPath) + ".tmp";
+  FILE *file = fopen(tmpPath.c_str(), "wb");
+  if (!file)
+    return false;
+
+  static const unsigned char zeros[16] = {0};
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+            fwrite(index.data(), sizeof(PackEntry), index.size(), file) ==
+                index.size() &&
+            fwrite(names.data(), 1, names.size(), file) == names.size();
+  uint64_t written = header.namesOffset + header.namesSize;
+  for (size_t i = 0; ok && i < blobs.size(); i++) {
+    size_t padding = (size_t)(index[i].offset - written);
+    ok = fwrite(zeros, 1, padding, file) == padding &&
+         fwrite(blobs[i].data.data(), 1, blobs[i].data.size(), file) ==
+             blobs[i].data.size();
+    written = index[i].offset + blobs[i].data.size();
+  }
+  ok = (fclose(file) == 0) && ok;
+
+  if (!ok || rename(tmpPath.c_str(), packPath) != 0) {
+    remove(tmpPath.c_str());
+    return false;
+  }
+  return true;
+}
+
+void AssetPackWriter::printReport() const {
+  size_t raw = 0, stored = 0;
+  for (const Blob &blob : blobs) {
+    printf("  %-32s %10llu -> %10zu bytes%s\n", blob.name.c_str(),
+           (unsigned long long)blob.rawSize, blob.data.size(),
+           blob.compressed ? " (lz4)" : "");
+    raw += blob.rawSize;
+    stored += blob.data.size();
+  }
+  printf("Asset pack: %zu entries, %zu -> %zu bytes\n", blobs.size(), raw,
+         stored);
+}
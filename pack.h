@@ -0,0 +1,104 @@
+// ============================================================================
+// Pack.h - Single-File Asset Pack
+// Header + index + LZ4 blobs, written at build time and mmap'd at runtime
+// ============================================================================
+
+#ifndef PACK_H
+#define PACK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// LZ4 BLOCK FORMAT
+// ============================================================================
+// Plain LZ4 blocks (no frame header or checksum); the pack index records both
+// sizes. Implemented here so the game needs no extra library.
+
+size_t lz4CompressBound(size_t size);
+// Returns the compressed size, or 0 if dst is too small
+size_t lz4Compress(const unsigned char* src, size_t size, unsigned char* dst,
+                   size_t capacity);
+// Fails on malformed input or if the output is not exactly rawSize bytes
+bool lz4Decompress(const unsigned char* src, size_t size, unsigned char* dst,
+                   size_t rawSize);
+
+// ============================================================================
+// PACK FILE
+// ============================================================================
+// [PackHeader][PackEntry * entryCount][names][blobs, 16-byte aligned]
+// Meshes are stored as Model mesh-cache images (packed vertices + LODs), so
+// loading one is a copy out of the mapping instead of an OBJ parse.
+
+struct AssetView {
+    const unsigned char* data;
+    size_t size;
+};
+
+// Maps a whole loose file read-only. The mapping stays valid while any copy
+// of the returned pointer is alive (null for missing or empty files).
+std::shared_ptr<const unsigned char> mapFile(const char* path, size_t& size);
+
+class AssetPack {
+private:
+    struct Entry {
+        uint64_t offset;
+        uint64_t storedSize;
+        uint64_t rawSize;
+        bool compressed;
+    };
+
+    const unsigned char* mapped;
+    size_t mappedSize;
+    std::string path;
+    std::map<std::string, Entry> entries;
+    std::map<std::string, std::string> extracted; // name -> temp file
+
+public:
+    AssetPack();
+    ~AssetPack();
+
+    bool open(const char* packPath);
+    void close();
+    bool isOpen() const { return mapped != nullptr; }
+    size_t getEntryCount() const { return entries.size(); }
+    size_t getFileSize() const { return mappedSize; }
+
+    bool contains(const char* name) const;
+    // Stored entries are returned as zero-copy views into the mapping; LZ4
+    // entries are decompressed into scratch and the view points there.
+    // Safe to call from worker threads.
+    bool get(const char* name, AssetView& view,
+             std::vector<unsigned char>& scratch) const;
+    // For consumers that need a real file (afplay): writes the asset to a
+    // temporary file once and returns its path, or name itself if the pack
+    // does not contain it. GL/main thread only.
+    std::string extractToFile(const char* name);
+
+    // Pack opened by the game at startup (assets.pack next to the binary)
+    static AssetPack& shared();
+};
+
+// Build-time writer used by the pack_assets tool
+class AssetPackWriter {
+private:
+    struct Blob {
+        std::string name;
+        std::vector<unsigned char> data;
+        uint64_t rawSize;
+        bool compressed;
+    };
+    std::vector<Blob> blobs;
+
+public:
+    // Compresses with LZ4 unless that saves less than 1/8 of the size
+    void add(const std::string& name, const std::vector<unsigned char>& data);
+    bool write(const char* packPath) const;
+    void printReport() const;
+};
+
+#endif // PACK_H
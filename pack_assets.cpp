@@ -0,0 +1,82 @@
+// ============================================================================
+// PackAssets.cpp - Build-Time Asset Packer
+// Writes every mesh (pre-processed), texture and sound into one pack file
+// Usage: pack_assets [output.pack] [asset directory]
+// ============================================================================
+
+#include "model.h"
+#include "pack.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <string>
+#include <vector>
+
+static bool readFile(const std::string &path, std::vector<unsigned char> &out) {
+  FILE *file = fopen(path.c_str(), "rb");
+  if (!file)
+    return false;
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  out.resize(size > 0 ? (size_t)size : 0);
+  bool ok = fread(out.data(), 1, out.size(), file) == out.size();
+  fclose(file);
+  return ok;
+}
+
+static bool hasExtension(const std::string &name, const char *ext) {
+  size_t len = strlen(ext);
+  return name.size() > len && name.compare(name.size() - len, len, ext) == 0;
+}
+
+int main(int argc, char **argv) {
+  const char *packPath = argc > 1 ? argv[1] : "assets.pack";
+  std::string dir = argc > 2 ? argv[2] : "assets";
+
+  DIR *d = opendir(dir.c_str());
+  if (!d) {
+    printf("Cannot open asset directory: %s\n", dir.c_str());
+    return 1;
+  }
+  std::vector<std::string> files;
+  while (dirent *entry = readdir(d))
+    files.push_back(entry->d_name);
+  closedir(d);
+  std::sort(files.begin(), files.end());
+
+  AssetPackWriter writer;
+  for (const std::string &file : files) {
+    // Names match the paths the game opens, e.g. "assets/pillar.obj"
+    std::string path = dir + "/" + file;
+    std::vector<unsigned char> data;
+
+    if (hasExtension(file, ".obj")) {
+      // Store the mesh cache image: packed vertices plus the LOD chain.
+      // Models loaded without LODs only use the first range.
+      Model model;
+      if (!model.decode(path.c_str(), true) ||
+          !readFile(path + ".meshcache", data)) {
+        printf("Skipping mesh that did not import: %s\n", path.c_str());
+        continue;
+      }
+    } else if (hasExtension(file, ".bmp") || hasExtension(file, ".wav")) {
+      if (!readFile(path, data)) {
+        printf("Skipping unreadable file: %s\n", path.c_str());
+        continue;
+      }
+    } else {
+      continue;
+    }
+    writer.add(path, data);
+  }
+
+  writer.printReport();
+  if (!writer.write(packPath)) {
+    printf("Could not write asset pack: %s\n", packPath);
+    return 1;
+  }
+  printf("Wrote %s\n", packPath);
+  return 0;
+}
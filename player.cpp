@@ -1,4 +1,7 @@
 #include "player.h"
+#include "assets.h"
+#include "atlas.h"
+#include "primitives.h"
 #include "utils.h"
 
 #ifndef CLAMP_DEFINED
@@ -56,21 +59,14 @@ Player::Player(float startX, float startY, float startZ) {
   landTimer = 0.0f;
   wasGrounded = true;
 
-  playerModel = new Model();
-  playerModel->load("assets/player.obj");
+  playerModel = AssetRegistry::acquireModel("assets/player.obj");
 
   // Load skin texture (or fail silently with ID=0)
-  skinTexture = loadBMP("assets/player.bmp");
-}
-
-Player::~Player() {
-  if (playerModel)
-    delete playerModel;
+  skinTexture = AssetRegistry::acquireTexture("assets/player.bmp");
 }
 
 void Player::loadModel(const char *filename) {
-  if (playerModel)
-    playerModel->load(filename);
+  playerModel = AssetRegistry::acquireModel(filename);
 }
 
 void Player::update(float deltaTime) {
@@ -370,9 +366,9 @@ void Player::render() {
     glColor3f(1.0f, 0.3f, 0.3f);
   } else {
     // Enable skin texture if loaded
-    if (skinTexture.id != 0) {
+    if (skinTexture->id != 0) {
       glEnable(GL_TEXTURE_2D);
-      glBindTexture(GL_TEXTURE_2D, skinTexture.id);
+      bindTexture(skinTexture->id);
       glColor3f(1.0f, 1.0f, 1.0f); // White modulation for texture
     } else {
       glDisable(GL_TEXTURE_2D);
@@ -390,30 +386,32 @@ void Player::render() {
   } else {
     // Fallback if model fails
     glColor3f(0.8f, 0.6f, 0.4f);
-    GLUquadric *quad = gluNewQuadric();
     glRotatef(-90, 1, 0, 0);
-    gluCylinder(quad, radius * 0.7f, radius * 0.7f, height * 0.6f, 16, 1);
+    PrimitiveCache::cylinder(radius * 0.7f, radius * 0.7f, height * 0.6f, 16,
+                             1);
     glTranslatef(0, 0, height * 0.6f);
-    glutSolidSphere(radius * 0.5f, 16, 16);
+    PrimitiveCache::solidSphere(radius * 0.5f, 16, 16);
     glColor3f(0.4f, 0.3f, 0.2f);
     glTranslatef(0, -radius * 0.4f, 0);
     glScalef(0.5f, 0.6f, 0.3f);
-    glutSolidCube(1.0f);
-    gluDeleteQuadric(quad);
+    PrimitiveCache::solidCube(1.0f);
   }
 
   // Render Glow Effect
   if (glowTimer > 0.0f) {
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    float alpha = glowTimer;                    // Fade out
-    glColor4f(1.0f, 0.84f, 0.0f, alpha * 0.5f); // Gold glow
+    glDisable(GL_LIGHTING);
+    glEnable(GL_TEXTURE_2D);
+    bindTexture(GlowBatch::texture());
 
-    glPushMatrix();
-    glTranslatef(0, height * 0.5f, 0); // Center on player
-    glutSolidSphere(1.0f, 16, 16);
-    glPopMatrix();
+    float alpha = glowTimer; // Fade out
+    glowSprite.clear();
+    glowSprite.add(0, height * 0.5f, 0, 1.0f, 1.0f, 1.0f, 0.84f, 0.0f,
+                   alpha * 0.5f); // Gold glow, centred on player
+    glowSprite.draw();
 
+    glEnable(GL_LIGHTING);
     glDisable(GL_BLEND);
   }
 
@@ -11,14 +11,16 @@
 #else
 #include <GL/glut.h>
 #endif
+#include "assets.h"
+#include "glow.h"
 #include "model.h"
 #include "utils.h"
 #include <cmath>
 
 class Player {
 private:
-  Model *playerModel;
-  Texture skinTexture;
+  ModelHandle playerModel;
+  TextureHandle skinTexture;
 
   // Position and orientation
   float x, y, z;
@@ -54,6 +56,7 @@ private:
   float damageCooldown;
   float damageFlashTimer;
   float glowTimer;
+  GlowBatch glowSprite; // Drawn while glowTimer runs
 
   float footstepTimer;
   float landTimer;
@@ -63,7 +66,6 @@ private:
 
 public:
   Player(float startX, float startY, float startZ);
-  ~Player();
 
   void loadModel(const char *filename);
   void update(float deltaTime);
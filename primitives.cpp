@@ -0,0 +1,211 @@
+// ============================================================================
+// Primitives.cpp - Cached Tessellated Primitives Implementation
+// ============================================================================
+
+#include "primitives.h"
+#include "model.h"
+#include "staticgeometry.h"
+#include <cstddef>
+#include <map>
+#include <tuple>
+
+bool PrimitiveCache::enabled = true;
+float PrimitiveCache::detailScale = 1.0f;
+
+enum Shape { SHAPE_SPHERE, SHAPE_CONE, SHAPE_TORUS, SHAPE_CUBE,
+             SHAPE_OCTAHEDRON, SHAPE_CYLINDER };
+
+// Shape, tessellation, and the proportions scaling cannot change (a
+// cylinder's radii and a torus' tube, relative to the largest radius)
+struct MeshKey {
+  int shape, slices, stacks;
+  float ratioA, ratioB;
+
+  bool operator<(const MeshKey &o) const {
+    return std::tie(shape, slices, stacks, ratioA, ratioB) <
+           std::tie(o.shape, o.slices, o.stacks, o.ratioA, o.ratioB);
+  }
+};
+
+struct PrimitiveMesh {
+  std::vector<BakedVertex> vertices; // Kept only without a buffer
+  GLuint bufferId;
+  GLsizei vertexCount;
+};
+
+static std::map<MeshKey, PrimitiveMesh> meshes;
+
+// Projected pixels per unit of size at view depth 1 (0 until beginFrame())
+static float pixelScale = 0.0f;
+
+static const PrimitiveMesh &findMesh(const MeshKey &key) {
+  auto it = meshes.find(key);
+  if (it != meshes.end())
+    return it->second;
+
+  PrimitiveMesh &mesh = meshes[key];
+  MeshBuilder builder;
+  builder.setTarget(&mesh.vertices);
+  switch (key.shape) {
+  case SHAPE_SPHERE:
+    builder.solidSphere(1.0f, key.slices, key.stacks);
+    break;
+  case SHAPE_CONE:
+    builder.solidCone(1.0f, 1.0f, key.slices, key.stacks);
+    break;
+  case SHAPE_TORUS:
+    builder.solidTorus(key.ratioA, 1.0f, key.slices, key.stacks);
+    break;
+  case SHAPE_CUBE:
+    builder.solidCube(1.0f);
+    break;
+  case SHAPE_OCTAHEDRON:
+    builder.solidOctahedron();
+    break;
+  case SHAPE_CYLINDER:
+    builder.cylinder(key.ratioA, key.ratioB, 1.0f, key.slices, key.stacks);
+    break;
+  }
+  mesh.vertexCount = (GLsizei)mesh.vertices.size();
+  mesh.bufferId = 0;
+  if (Model::useVertexBuffers && Model::vertexBuffersSupported()) {
+    glGenBuffers(1, &mesh.bufferId);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.bufferId);
+    glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(BakedVertex),
+                 mesh.vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    std::vector<BakedVertex>().swap(mesh.vertices);
+  }
+  return mesh;
+}
+
+// Draws the unit mesh scaled to size; GL_NORMALIZE keeps the normals of
+// non-uniformly scaled meshes unit length
+static void drawMesh(const MeshKey &key, float sx, float sy, float sz) {
+  const PrimitiveMesh &mesh = findMesh(key);
+  glPushMatrix();
+  glScalef(sx, sy, sz);
+  const char *base = nullptr;
+  if (mesh.bufferId != 0)
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.bufferId);
+  else
+    base = (const char *)mesh.vertices.data();
+  const GLsizei stride = sizeof(BakedVertex);
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glEnableClientState(GL_NORMAL_ARRAY);
+  glVertexPointer(3, GL_FLOAT, stride,
+                  base + offsetof(BakedVertex, position));
+  glNormalPointer(GL_FLOAT, stride, base + offsetof(BakedVertex, normal));
+  glDrawArrays(GL_TRIANGLES, 0, mesh.vertexCount);
+  glDisableClientState(GL_NORMAL_ARRAY);
+  glDisableClientState(GL_VERTEX_ARRAY);
+  if (mesh.bufferId != 0)
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glPopMatrix();
+}
+
+// Count at a detail level, never below floor (or the count itself)
+static int reduce(int count, int level, int floor) {
+  int reduced = count >> level;
+  int minimum = count < floor ? count : floor;
+  return reduced > minimum ? reduced : minimum;
+}
+
+void PrimitiveCache::beginFrame() {
+  GLfloat projection[16];
+  GLint viewport[4];
+  glGetFloatv(GL_PROJECTION_MATRIX, projection);
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  pixelScale = projection[5] * viewport[3] * 0.5f;
+}
+
+int PrimitiveCache::detailLevel(float radius) {
+  if (pixelScale <= 0.0f)
+    return 0;
+  GLfloat m[16];
+  glGetFloatv(GL_MODELVIEW_MATRIX, m);
+  // Largest axis scale of the modelview, applied to the radius
+  float scale = 0.0f;
+  for (int c = 0; c < 3; c++) {
+    float s = m[c * 4] * m[c * 4] + m[c * 4 + 1] * m[c * 4 + 1] +
+              m[c * 4 + 2] * m[c * 4 + 2];
+    if (s > scale)
+      scale = s;
+  }
+  float size = radius * sqrtf(scale);
+  float depth = -m[14];
+  if (depth <= size)
+    return 0; // Camera at or inside the shape
+  float pixels = size * pixelScale / depth * detailScale;
+  return pixels >= 48.0f ? 0 : pixels >= 16.0f ? 1 : 2;
+}
+
+void PrimitiveCache::solidSphere(float radius, int slices, int stacks) {
+  if (!enabled) {
+    glutSolidSphere(radius, slices, stacks);
+    return;
+  }
+  int level = detailLevel(radius);
+  MeshKey key = {SHAPE_SPHERE, reduce(slices, level, 6),
+                 reduce(stacks, level, 4), 0.0f, 0.0f};
+  drawMesh(key, radius, radius, radius);
+}
+
+void PrimitiveCache::solidCone(float base, float height, int slices,
+                               int stacks) {
+  if (!enabled) {
+    glutSolidCone(base, height, slices, stacks);
+    return;
+  }
+  int level = detailLevel(base > height ? base : height);
+  MeshKey key = {SHAPE_CONE, reduce(slices, level, 6),
+                 reduce(stacks, level, 1), 0.0f, 0.0f};
+  drawMesh(key, base, base, height);
+}
+
+void PrimitiveCache::solidTorus(float innerRadius, float outerRadius,
+                                int sides, int rings) {
+  if (!enabled) {
+    glutSolidTorus(innerRadius, outerRadius, sides, rings);
+    return;
+  }
+  int level = detailLevel(innerRadius + outerRadius);
+  MeshKey key = {SHAPE_TORUS, reduce(sides, level, 6),
+                 reduce(rings, level, 8), innerRadius / outerRadius, 0.0f};
+  drawMesh(key, outerRadius, outerRadius, outerRadius);
+}
+
+void PrimitiveCache::solidCube(float size) {
+  if (!enabled) {
+    glutSolidCube(size);
+    return;
+  }
+  MeshKey key = {SHAPE_CUBE, 0, 0, 0.0f, 0.0f};
+  drawMesh(key, size, size, size);
+}
+
+void PrimitiveCache::solidOctahedron() {
+  if (!enabled) {
+    glutSolidOctahedron();
+    return;
+  }
+  MeshKey key = {SHAPE_OCTAHEDRON, 0, 0, 0.0f, 0.0f};
+  drawMesh(key, 1.0f, 1.0f, 1.0f);
+}
+
+void PrimitiveCache::cylinder(float base, float top, float height,
+                              int slices, int stacks) {
+  float radius = base > top ? base : top;
+  if (!enabled || radius <= 0.0f) {
+    GLUquadric *quad = gluNewQuadric();
+    gluCylinder(quad, base, top, height, slices, stacks);
+    gluDeleteQuadric(quad);
+    return;
+  }
+  int level = detailLevel(radius > height ? radius : height);
+  MeshKey key = {SHAPE_CYLINDER, reduce(slices, level, 6),
+                 reduce(stacks, level, 1), base / radius, top / radius};
+  drawMesh(key, radius, radius, height);
+}
+
+size_t PrimitiveCache::getMeshCount() { return meshes.size(); }
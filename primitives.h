@@ -0,0 +1,51 @@
+// ============================================================================
+// Primitives.h - Cached Tessellated Primitives
+// Drop-in replacements for the GLUT/GLU solids the game draws every frame:
+// each shape is tessellated once at unit size and drawn from a buffer
+// ============================================================================
+
+#ifndef PRIMITIVES_H
+#define PRIMITIVES_H
+
+#include <cstddef>
+#ifdef __APPLE__
+#include <GLUT/glut.h>
+#else
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES // glGenBuffers & co. live in glext.h on Mesa
+#endif
+#include <GL/glut.h>
+#endif
+
+// Same parameters, orientation and normals as the GLUT/GLU call of the
+// same name, drawn with the current colour and material (no texture
+// coordinates, like GLUT). The slice and stack counts are the full detail;
+// small on-screen shapes are drawn with fewer, see detailLevel().
+class PrimitiveCache {
+public:
+    static void solidSphere(float radius, int slices, int stacks);
+    static void solidCone(float base, float height, int slices, int stacks);
+    static void solidTorus(float innerRadius, float outerRadius, int sides,
+                           int rings);
+    static void solidCube(float size);
+    static void solidOctahedron();
+    // gluCylinder without a quadric (no caps, no texture coordinates)
+    static void cylinder(float base, float top, float height, int slices,
+                         int stacks);
+
+    // Takes the projection and viewport that detailLevel() projects with;
+    // call once per frame after the 3D projection is set
+    static void beginFrame();
+    // 0 (full), 1 (half) or 2 (quarter the slices and stacks) for a shape of
+    // this radius around the current modelview origin; 0 before beginFrame()
+    static int detailLevel(float radius);
+
+    // Draws through GLUT/GLU as before while this is cleared
+    static bool enabled;
+    // Multiplies projected sizes before choosing a level (below 1 coarsens)
+    static float detailScale;
+
+    static size_t getMeshCount();
+};
+
+#endif // PRIMITIVES_H
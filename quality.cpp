@@ -0,0 +1,168 @@
+// ============================================================================
+// Quality.cpp - Adaptive Quality Governor Implementation
+// ============================================================================
+
+#include "quality.h"
+#include "atlas.h"
+#include "model.h"
+#include "primitives.h"
+#include "snowfall.h"
+#include <algorithm>
+#include <cstdio>
+
+// ============================================================================
+// SCALED RENDER TARGET
+// ============================================================================
+ScaledRenderTarget::ScaledRenderTarget()
+    : textureId(0), textureWidth(0), textureHeight(0), windowWidth(0),
+      windowHeight(0), sceneWidth(0), sceneHeight(0) {}
+
+ScaledRenderTarget::~ScaledRenderTarget() {
+  if (textureId != 0)
+    glDeleteTextures(1, &textureId);
+}
+
+void ScaledRenderTarget::begin(int width, int height, float scale) {
+  windowWidth = width;
+  windowHeight = height;
+  sceneWidth = (int)(width * scale + 0.5f);
+  sceneHeight = (int)(height * scale + 0.5f);
+  if (sceneWidth < 1)
+    sceneWidth = 1;
+  if (sceneHeight < 1)
+    sceneHeight = 1;
+  glViewport(0, 0, sceneWidth, sceneHeight);
+}
+
+void ScaledRenderTarget::end() {
+  if (sceneWidth >= windowWidth && sceneHeight >= windowHeight)
+    return; // Drawn at full size, nothing to stretch
+
+  // Sized for the window once, so every scale fits
+  if (textureId == 0 || textureWidth < windowWidth ||
+      textureHeight < windowHeight) {
+    if (textureId == 0)
+      glGenTextures(1, &textureId);
+    textureWidth = windowWidth;
+    textureHeight = windowHeight;
+    bindTexture(textureId);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, textureWidth, textureHeight, 0,
+                 GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+  }
+  bindTexture(textureId);
+  glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, sceneWidth, sceneHeight);
+
+  glViewport(0, 0, windowWidth, windowHeight);
+  glPushAttrib(GL_ENABLE_BIT);
+  glDisable(GL_LIGHTING);
+  glDisable(GL_DEPTH_TEST);
+  glDisable(GL_FOG);
+  glDisable(GL_BLEND);
+  glEnable(GL_TEXTURE_2D);
+  glMatrixMode(GL_PROJECTION);
+  glPushMatrix();
+  glLoadIdentity();
+  glMatrixMode(GL_MODELVIEW);
+  glPushMatrix();
+  glLoadIdentity();
+
+  float u = (float)sceneWidth / textureWidth;
+  float v = (float)sceneHeight / textureHeight;
+  glColor3f(1.0f, 1.0f, 1.0f);
+  glBegin(GL_QUADS);
+  glTexCoord2f(0, 0);
+  glVertex2f(-1, -1);
+  glTexCoord2f(u, 0);
+  glVertex2f(1, -1);
+  glTexCoord2f(u, v);
+  glVertex2f(1, 1);
+  glTexCoord2f(0, v);
+  glVertex2f(-1, 1);
+  glEnd();
+
+  glPopMatrix();
+  glMatrixMode(GL_PROJECTION);
+  glPopMatrix();
+  glMatrixMode(GL_MODELVIEW);
+  glPopAttrib();
+}
+
+// ============================================================================
+// QUALITY GOVERNOR
+// ============================================================================
+// Cheapest-looking savings first: snow and tessellation go before
+// resolution
+static const QualityGovernor::Level levels[] = {
+    {1.00f, 1.00f, 1.00f, 1.00f}, // Full quality
+    {1.00f, 0.60f, 0.75f, 0.80f},
+    {0.85f, 0.40f, 0.60f, 0.65f},
+    {0.75f, 0.25f, 0.50f, 0.50f},
+    {0.60f, 0.15f, 0.35f, 0.40f},
+    {0.50f, 0.10f, 0.25f, 0.30f},
+};
+static const int levelCount = sizeof(levels) / sizeof(levels[0]);
+
+bool QualityGovernor::enabled = true;
+float QualityGovernor::targetMs = 16.6f;
+
+QualityGovernor::QualityGovernor() : level(0), fastWindows(0), settling(false) {
+  samples.reserve(sampleFrames);
+}
+
+const QualityGovernor::Level &QualityGovernor::getSettings() const {
+  return levels[level];
+}
+
+void QualityGovernor::reset() {
+  samples.clear();
+  fastWindows = 0;
+  settling = false;
+}
+
+void QualityGovernor::frameFinished(float frameMs) {
+  if (!enabled)
+    return;
+  samples.push_back(frameMs);
+  if ((int)samples.size() < sampleFrames)
+    return;
+
+  // The median shrugs off one-off spikes (streamed meshes, level loads)
+  std::nth_element(samples.begin(), samples.begin() + sampleFrames / 2,
+                   samples.end());
+  float median = samples[sampleFrames / 2];
+  samples.clear();
+  if (settling) {
+    settling = false;
+    return;
+  }
+
+  if (median > targetMs * slowFactor) {
+    fastWindows = 0;
+    if (level + 1 < levelCount)
+      setLevel(level + 1, median);
+  } else if (median < targetMs * fastFactor) {
+    if (++fastWindows >= upgradeWindows && level > 0) {
+      fastWindows = 0;
+      setLevel(level - 1, median);
+    }
+  } else {
+    fastWindows = 0;
+  }
+}
+
+void QualityGovernor::setLevel(int newLevel, float frameMs) {
+  const Level &l = levels[newLevel];
+  printf("Quality: level %d -> %d (median %.1f ms, target %.1f ms): render "
+         "scale %.2f, snow %.0f%%, detail %.2f, LOD bias %.2f\n",
+         level, newLevel, frameMs, targetMs, l.renderScale,
+         l.snowBudget * 100.0f, l.detailScale, l.lodBias);
+  level = newLevel;
+  settling = true;
+  Snowfall::budget = l.snowBudget;
+  PrimitiveCache::detailScale = l.detailScale;
+  Model::lodBias = l.lodBias;
+}
@@ -0,0 +1,80 @@
+// ============================================================================
+// Quality.h - Adaptive Quality Governor
+// Measures frame time against a target and steps render scale, snow
+// budget, primitive tessellation and model LOD bias up or down with
+// hysteresis
+// ============================================================================
+
+#ifndef QUALITY_H
+#define QUALITY_H
+
+#include <vector>
+#ifdef __APPLE__
+#include <GLUT/glut.h>
+#else
+#include <GL/glut.h>
+#endif
+
+// Draws the scene into the bottom left part of the back buffer and
+// stretches it over the window, for rendering below window resolution
+class ScaledRenderTarget {
+private:
+    GLuint textureId;
+    int textureWidth, textureHeight;
+    int windowWidth, windowHeight;
+    int sceneWidth, sceneHeight;
+
+public:
+    ScaledRenderTarget();
+    ~ScaledRenderTarget();
+    ScaledRenderTarget(const ScaledRenderTarget&) = delete;
+    ScaledRenderTarget& operator=(const ScaledRenderTarget&) = delete;
+
+    // Sets the viewport for the scene: scale times the window size
+    void begin(int windowWidth, int windowHeight, float scale);
+    // Upscales the scene over the whole window (nothing at scale 1) and
+    // restores the full window viewport
+    void end();
+};
+
+class QualityGovernor {
+public:
+    struct Level {
+        float renderScale;    // Scene resolution relative to the window
+        float snowBudget;     // Fraction of the snowflakes drawn
+        float detailScale;    // PrimitiveCache::detailScale
+        float lodBias;        // Model::lodBias
+    };
+
+private:
+    std::vector<float> samples; // Frame times of the current window
+    int level;
+    int fastWindows;            // Consecutive windows well under target
+    bool settling;              // Discard the window after a change
+
+    void setLevel(int newLevel, float frameMs);
+
+public:
+    QualityGovernor();
+
+    // Records one frame's time (ms). Every sampleFrames frames the median
+    // is compared with the target: above target * slowFactor drops a
+    // level at once, under target * fastFactor for fastWindows windows in
+    // a row raises one. The window after a change is discarded.
+    void frameFinished(float frameMs);
+    // Forgets the samples, e.g. across a level switch
+    void reset();
+
+    int getLevel() const { return level; }
+    const Level& getSettings() const;
+
+    // Adjustments are made only while this is set (--no-governor)
+    static bool enabled;
+    static float targetMs;
+    static const int sampleFrames = 30;
+    static const int upgradeWindows = 3;
+    static constexpr float slowFactor = 1.1f;
+    static constexpr float fastFactor = 0.7f;
+};
+
+#endif // QUALITY_H
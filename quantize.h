@@ -0,0 +1,126 @@
+// ============================================================================
+// Quantize.h - Compact Vertex Encoding Helpers
+// 16-bit positions, octahedral normals and half-float texture coordinates
+// ============================================================================
+
+#ifndef QUANTIZE_H
+#define QUANTIZE_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// ============================================================================
+// HALF FLOATS (IEEE 754 binary16)
+// ============================================================================
+
+inline uint16_t floatToHalf(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  uint32_t sign = (bits >> 16) & 0x8000u;
+  int32_t exponent = (int32_t)((bits >> 23) & 0xffu) - 127 + 15;
+  uint32_t mantissa = bits & 0x7fffffu;
+
+  if (((bits >> 23) & 0xffu) == 0xffu) // Inf / NaN
+    return (uint16_t)(sign | 0x7c00u | (mantissa ? 0x200u : 0u));
+  if (exponent >= 31) // Overflow -> Inf
+    return (uint16_t)(sign | 0x7c00u);
+  if (exponent <= 0) { // Subnormal or zero
+    if (exponent < -10)
+      return (uint16_t)sign;
+    mantissa |= 0x800000u;
+    uint32_t shift = (uint32_t)(14 - exponent);
+    uint32_t half = mantissa >> shift;
+    if ((mantissa >> (shift - 1)) & 1u) // Round to nearest
+      half++;
+    return (uint16_t)(sign | half);
+  }
+  uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+  if (mantissa & 0x1000u) // Round to nearest (may carry into exponent)
+    half++;
+  return (uint16_t)half;
+}
+
+inline float halfToFloat(uint16_t half) {
+  uint32_t sign = (uint32_t)(half & 0x8000u) << 16;
+  uint32_t exponent = (half >> 10) & 0x1fu;
+  uint32_t mantissa = half & 0x3ffu;
+  uint32_t bits;
+
+  if (exponent == 0) {
+    if (mantissa == 0) {
+      bits = sign;
+    } else { // Normalise the subnormal
+      exponent = 127 - 15 + 1;
+      while ((mantissa & 0x400u) == 0) {
+        mantissa <<= 1;
+        exponent--;
+      }
+      bits = sign | (exponent << 23) | ((mantissa & 0x3ffu) << 13);
+    }
+  } else if (exponent == 31) {
+    bits = sign | 0x7f800000u | (mantissa << 13);
+  } else {
+    bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+  }
+
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// ============================================================================
+// OCTAHEDRAL NORMALS
+// ============================================================================
+// Projects the unit sphere onto an octahedron and unfolds it into a square,
+// so a normal fits into two signed components.
+
+inline float signNotZero(float v) { return v >= 0.0f ? 1.0f : -1.0f; }
+
+inline void encodeOctahedral(float x, float y, float z, int8_t out[2]) {
+  float sum = fabsf(x) + fabsf(y) + fabsf(z);
+  if (sum <= 0.0f) {
+    out[0] = 0;
+    out[1] = 127; // Degenerate normal -> +Y
+    return;
+  }
+  float u = x / sum, v = y / sum;
+  if (z < 0.0f) {
+    float fu = (1.0f - fabsf(v)) * signNotZero(u);
+    float fv = (1.0f - fabsf(u)) * signNotZero(v);
+    u = fu;
+    v = fv;
+  }
+  out[0] = (int8_t)lroundf(fmaxf(-1.0f, fminf(1.0f, u)) * 127.0f);
+  out[1] = (int8_t)lroundf(fmaxf(-1.0f, fminf(1.0f, v)) * 127.0f);
+}
+
+inline void decodeOctahedral(const int8_t in[2], float &x, float &y,
+                             float &z) {
+  x = in[0] / 127.0f;
+  y = in[1] / 127.0f;
+  z = 1.0f - fabsf(x) - fabsf(y);
+  if (z < 0.0f) {
+    float fx = (1.0f - fabsf(y)) * signNotZero(x);
+    float fy = (1.0f - fabsf(x)) * signNotZero(y);
+    x = fx;
+    y = fy;
+  }
+  float len = sqrtf(x * x + y * y + z * z);
+  x /= len;
+  y /= len;
+  z /= len;
+}
+
+// ============================================================================
+// 16-BIT POSITIONS
+// ============================================================================
+// Positions are stored relative to the bounding-box centre with one uniform
+// scale, so a single glTranslatef/glScalef undoes the quantisation and
+// normals need no correction.
+
+inline int16_t quantizeSnorm16(float v) {
+  return (int16_t)lroundf(fmaxf(-1.0f, fminf(1.0f, v)) * 32767.0f);
+}
+
+#endif // QUANTIZE_H
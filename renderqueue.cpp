@@ -0,0 +1,138 @@
+// ============================================================================
+// RenderQueue.cpp - State-Sorted Draw Submission Implementation
+// ============================================================================
+
+#include "renderqueue.h"
+#include "atlas.h"
+#include "lights.h"
+#include <algorithm>
+
+bool RenderQueue::sorting = true;
+int RenderQueue::stateChanges = 0;
+int RenderQueue::itemCount = 0;
+
+// State last set through apply(), while nothing else has changed it
+static RenderState current;
+static bool stateKnown = false;
+
+unsigned long long RenderState::sortKey() const {
+  unsigned long long material = (unsigned long long)(shininess * 256.0f);
+  return ((unsigned long long)blend << 60) |
+         ((unsigned long long)(lighting ? 0 : 1) << 59) |
+         ((unsigned long long)texture << 16) | (material & 0xFFFF);
+}
+
+RenderQueue::RenderQueue() : lights(nullptr) {
+  for (int i = 0; i < 16; i++)
+    view[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+}
+
+void RenderQueue::begin() {
+  glGetFloatv(GL_MODELVIEW_MATRIX, view);
+  opaque.clear();
+  transparent.clear();
+  stateKnown = false;
+}
+
+void RenderQueue::submit(const RenderState &state, float x, float y, float z,
+                         std::function<void()> draw) {
+  submit(state, x, y, z, 0.0f, std::move(draw));
+}
+
+void RenderQueue::submit(const RenderState &state, float x, float y, float z,
+                         float radius, std::function<void()> draw) {
+  Item item;
+  item.state = state;
+  item.key = state.sortKey();
+  item.x = x;
+  item.y = y;
+  item.z = z;
+  item.radius = radius;
+  item.depth = -(view[2] * x + view[6] * y + view[10] * z + view[14]);
+  item.draw = std::move(draw);
+  (state.isTransparent() ? transparent : opaque).push_back(std::move(item));
+}
+
+void RenderQueue::apply(const RenderState &state) {
+  if (!stateKnown || state.blend != current.blend) {
+    if (state.blend == BLEND_NONE) {
+      glDisable(GL_BLEND);
+      stateChanges++;
+    } else {
+      if (!stateKnown || current.blend == BLEND_NONE) {
+        glEnable(GL_BLEND);
+        stateChanges++;
+      }
+      glBlendFunc(GL_SRC_ALPHA, state.blend == BLEND_ADDITIVE
+                                    ? GL_ONE
+                                    : GL_ONE_MINUS_SRC_ALPHA);
+      stateChanges++;
+    }
+  }
+
+  if (!stateKnown || state.lighting != current.lighting) {
+    if (state.lighting)
+      glEnable(GL_LIGHTING);
+    else
+      glDisable(GL_LIGHTING);
+    stateChanges++;
+  }
+
+  if (!stateKnown || state.texture != current.texture) {
+    if (state.texture == 0) {
+      glDisable(GL_TEXTURE_2D);
+      stateChanges++;
+    } else {
+      if (!stateKnown || current.texture == 0) {
+        glEnable(GL_TEXTURE_2D);
+        stateChanges++;
+      }
+      bindTexture(state.texture);
+      stateChanges++;
+    }
+  }
+
+  if (!stateKnown || state.shininess != current.shininess) {
+    if (!stateKnown || (state.shininess > 0.0f) != (current.shininess > 0.0f)) {
+      GLfloat white[] = {1.0f, 1.0f, 1.0f, 1.0f};
+      GLfloat black[] = {0.0f, 0.0f, 0.0f, 1.0f};
+      glMaterialfv(GL_FRONT, GL_SPECULAR,
+                   state.shininess > 0.0f ? white : black);
+      stateChanges++;
+    }
+    glMaterialf(GL_FRONT, GL_SHININESS, state.shininess);
+    stateChanges++;
+  }
+
+  current = state;
+  stateKnown = true;
+}
+
+void RenderQueue::execute(const std::vector<Item> &items) {
+  for (const Item &item : items) {
+    apply(item.state);
+    if (lights && item.state.lighting)
+      lights->bind(item.x, item.y, item.z, item.radius);
+    item.draw();
+  }
+  itemCount += (int)items.size();
+}
+
+void RenderQueue::flush() {
+  if (sorting) {
+    std::stable_sort(opaque.begin(), opaque.end(),
+                     [](const Item &a, const Item &b) {
+                       return a.key != b.key ? a.key < b.key
+                                             : a.depth < b.depth;
+                     });
+    std::stable_sort(transparent.begin(), transparent.end(),
+                     [](const Item &a, const Item &b) {
+                       return a.depth > b.depth;
+                     });
+  }
+  execute(opaque);
+  execute(transparent);
+  apply(RenderState());
+  opaque.clear();
+  transparent.clear();
+}
@@ -0,0 +1,87 @@
+// ============================================================================
+// RenderQueue.h - State-Sorted Draw Submission
+// Levels submit their entities as draw items tagged with the GL state they
+// need; the queue orders them so that state is changed as rarely as possible
+// ============================================================================
+
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+#include "utils.h"
+#include <functional>
+#include <vector>
+
+class LightManager;
+
+enum BlendMode { BLEND_NONE, BLEND_ALPHA, BLEND_ADDITIVE };
+
+// The state an item is drawn with. The queue sets it, so draw callbacks only
+// issue transforms, colours and geometry and leave these alone.
+struct RenderState {
+    BlendMode blend;
+    bool lighting;
+    GLuint texture;  // 0 draws untextured
+    float shininess; // Above 0 also gives a white specular highlight
+
+    RenderState(BlendMode b = BLEND_NONE, bool lit = true, GLuint tex = 0,
+                float shine = 0.0f)
+        : blend(b), lighting(lit), texture(tex), shininess(shine) {}
+
+    bool isTransparent() const { return blend != BLEND_NONE; }
+    // Orders items by blending, lighting, texture, then material
+    unsigned long long sortKey() const;
+};
+
+// Opaque items are drawn first, grouped by state and front to back within
+// a group; transparent items follow back to front, as blending requires.
+class RenderQueue {
+private:
+    struct Item {
+        RenderState state;
+        unsigned long long key;
+        float x, y, z;
+        float radius; // Of the bounds around x, y, z, for light selection
+        float depth;  // Distance along the view direction
+        std::function<void()> draw;
+    };
+    std::vector<Item> opaque;
+    std::vector<Item> transparent;
+    float view[16]; // Modelview at begin()
+    LightManager* lights;
+
+    void execute(const std::vector<Item>& items);
+
+public:
+    RenderQueue();
+
+    // Takes the current modelview for depth sorting (call after the camera
+    // is applied) and forgets the GL state set by code outside the queue
+    void begin();
+    // draw runs with the modelview of begin() and must restore it. Items
+    // run in sorted order, so it must also set every colour it draws with
+    // rather than inherit one from whichever item ran before.
+    void submit(const RenderState& state, float x, float y, float z,
+                std::function<void()> draw);
+    // An item spread over radius around x, y, z (several instances), lit by
+    // the lights reaching any of it
+    void submit(const RenderState& state, float x, float y, float z,
+                float radius, std::function<void()> draw);
+    // Lit items are drawn with the point lights that lights selects at
+    // their position (nullptr: only what is already enabled)
+    void setLights(LightManager* manager) { lights = manager; }
+    // Draws and clears everything submitted, then leaves lighting on and
+    // blending, texturing and specular off
+    void flush();
+
+    // Sets what differs from the state last applied by the queue
+    static void apply(const RenderState& state);
+
+    // Items run in submission order while this is cleared, for comparison
+    static bool sorting;
+    // Per-frame counts of GL state calls made by apply() and items drawn
+    static int stateChanges;
+    static int itemCount;
+    static void resetCounts() { stateChanges = itemCount = 0; }
+};
+
+#endif // RENDERQUEUE_H
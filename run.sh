@@ -1,10 +1,25 @@
 #!/bin/bash
+# ./run.sh bench: time Assimp against the built-in OBJ parser on assets/
+if [ "$1" = "bench" ]; then
+    g++ -O3 -march=native -o obj_bench obj_bench.cpp model.cpp simplify.cpp threadpool.cpp pack.cpp objparser.cpp -framework OpenGL -framework GLUT -Wno-deprecated-declarations -Wall -I/opt/homebrew/include -L/opt/homebrew/lib -lassimp && ./obj_bench assets
+    exit $?
+fi
+# ./run.sh bmpbench: time the BMP loaders on assets/ (add "upload" for GL)
+if [ "$1" = "bmpbench" ]; then
+    g++ -O3 -march=native -o bmp_bench bmp_bench.cpp pack.cpp -framework OpenGL -framework GLUT -Wno-deprecated-declarations -Wall -I/opt/homebrew/include && ./bmp_bench assets 20 $2
+    exit $?
+fi
+
 # Compile the game
 echo "Compiling..."
-g++ -O3 -march=native -o shadow_temple Main.cpp camera.cpp player.cpp level.cpp model.cpp -framework OpenGL -framework GLUT -Wno-deprecated-declarations -Wall -I/opt/homebrew/include -L/opt/homebrew/lib -lassimp
+g++ -O3 -march=native -o shadow_temple Main.cpp camera.cpp player.cpp level.cpp atlas.cpp frustum.cpp occlusion.cpp renderqueue.cpp lights.cpp staticgeometry.cpp primitives.cpp snowfall.cpp glow.cpp hud.cpp quality.cpp model.cpp simplify.cpp assets.cpp threadpool.cpp pack.cpp objparser.cpp -framework OpenGL -framework GLUT -Wno-deprecated-declarations -Wall -I/opt/homebrew/include -L/opt/homebrew/lib -lassimp
 
 # Check if compilation was successful
 if [ $? -eq 0 ]; then
+    # Rebuild the asset pack (meshes are pre-processed, blobs LZ4-compressed)
+    echo "Packing assets..."
+    g++ -O3 -march=native -o pack_assets pack_assets.cpp model.cpp simplify.cpp threadpool.cpp pack.cpp objparser.cpp -framework OpenGL -framework GLUT -Wno-deprecated-declarations -Wall -I/opt/homebrew/include -L/opt/homebrew/lib -lassimp && ./pack_assets assets.pack assets > /dev/null || echo "Asset packing failed, using loose files."
+
     echo "Compilation successful! Starting game..."
     # Run the game
     ./shadow_temple
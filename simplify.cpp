@@ -0,0 +1,281 @@
+// ============================================================================
+// Simplify.cpp - Quadric Edge-Collapse Mesh Simplification Implementation
+// ============================================================================
+
+#include "simplify.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+namespace {
+
+struct Quadric {
+  // Symmetric 4x4 error matrix (Garland & Heckbert)
+  double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+
+  Quadric() { memset(this, 0, sizeof(*this)); }
+
+  void addPlane(double a, double b, double c, double d, double w) {
+    a2 += w * a * a;
+    ab += w * a * b;
+    ac += w * a * c;
+    ad += w * a * d;
+    b2 += w * b * b;
+    bc += w * b * c;
+    bd += w * b * d;
+    c2 += w * c * c;
+    cd += w * c * d;
+    d2 += w * d * d;
+  }
+
+  void add(const Quadric &q) {
+    a2 += q.a2;
+    ab += q.ab;
+    ac += q.ac;
+    ad += q.ad;
+    b2 += q.b2;
+    bc += q.bc;
+    bd += q.bd;
+    c2 += q.c2;
+    cd += q.cd;
+    d2 += q.d2;
+  }
+
+  double error(const float *p) const {
+    double x = p[0], y = p[1], z = p[2];
+    return a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x +
+           b2 * y * y + 2 * bc * y * z + 2 * bd * y + c2 * z * z +
+           2 * cd * z + d2;
+  }
+};
+
+struct Collapse {
+  unsigned int from, to;
+  double cost;
+  bool operator<(const Collapse &o) const { return cost < o.cost; }
+};
+
+struct Triangle {
+  unsigned int group[3];  // welded position ids
+  unsigned int vertex[3]; // original vertex ids (for attributes)
+};
+
+void triangleNormal(const float *a, const float *b, const float *c,
+                    float *n) {
+  float e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+  float e2[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+  n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+  n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+  n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+uint64_t edgeKey(unsigned int a, unsigned int b) {
+  if (a > b)
+    std::swap(a, b);
+  return ((uint64_t)a << 32) | b;
+}
+
+} // namespace
+
+std::vector<unsigned int> simplifyMesh(const std::vector<unsigned int> &indices,
+                                       const float *positions,
+                                       size_t vertexCount, size_t strideBytes,
+                                       size_t targetIndexCount) {
+  auto position = [&](size_t v) {
+    return (const float *)((const char *)positions + v * strideBytes);
+  };
+
+  // 1. Weld vertices that share a position so seams collapse together
+  std::vector<unsigned int> groupOf(vertexCount);
+  std::vector<unsigned int> groupVertex; // representative vertex per group
+  {
+    struct Key {
+      uint32_t x, y, z;
+      bool operator==(const Key &o) const {
+        return x == o.x && y == o.y && z == o.z;
+      }
+    };
+    struct KeyHash {
+      size_t operator()(const Key &k) const {
+        return (k.x * 73856093u) ^ (k.y * 19349663u) ^ (k.z * 83492791u);
+      }
+    };
+    std::unordered_map<Key, unsigned int, KeyHash> welded;
+    welded.reserve(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++) {
+      Key key;
+      memcpy(&key, position(v), sizeof(key));
+      auto it = welded.emplace(key, (unsigned int)groupVertex.size());
+      if (it.second)
+        groupVertex.push_back((unsigned int)v);
+      groupOf[v] = it.first->second;
+    }
+  }
+  size_t groupCount = groupVertex.size();
+  auto groupPos = [&](unsigned int g) { return position(groupVertex[g]); };
+
+  std::vector<Triangle> tris;
+  tris.reserve(indices.size() / 3);
+  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+    Triangle t;
+    for (int k = 0; k < 3; k++) {
+      t.vertex[k] = indices[i + k];
+      t.group[k] = groupOf[indices[i + k]];
+    }
+    if (t.group[0] != t.group[1] && t.group[1] != t.group[2] &&
+        t.group[0] != t.group[2])
+      tris.push_back(t);
+  }
+
+  // 2. Accumulate area-weighted plane quadrics per position
+  std::vector<Quadric> quadrics(groupCount);
+  for (const Triangle &t : tris) {
+    float n[3];
+    triangleNormal(groupPos(t.group[0]), groupPos(t.group[1]),
+                   groupPos(t.group[2]), n);
+    double len = sqrt((double)n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    if (len <= 0.0)
+      continue;
+    double a = n[0] / len, b = n[1] / len, c = n[2] / len;
+    const float *p = groupPos(t.group[0]);
+    double d = -(a * p[0] + b * p[1] + c * p[2]);
+    for (int k = 0; k < 3; k++)
+      quadrics[t.group[k]].addPlane(a, b, c, d, len * 0.5);
+  }
+
+  size_t targetTris = targetIndexCount / 3;
+  std::vector<unsigned int> collapseTo(groupCount);
+  std::vector<char> touched(groupCount);
+  std::vector<char> border(groupCount);
+  std::vector<unsigned int> adjOffset(groupCount + 1);
+  std::vector<unsigned int> adjTris;
+  std::vector<Collapse> candidates;
+  std::unordered_map<uint64_t, int> edgeUse;
+
+  // 3. Passes of independent edge collapses, cheapest first
+  for (int pass = 0; pass < 32 && tris.size() > targetTris; pass++) {
+    // Vertex -> triangle adjacency (CSR)
+    std::fill(adjOffset.begin(), adjOffset.end(), 0);
+    for (const Triangle &t : tris)
+      for (int k = 0; k < 3; k++)
+        adjOffset[t.group[k] + 1]++;
+    for (size_t g = 0; g < groupCount; g++)
+      adjOffset[g + 1] += adjOffset[g];
+    adjTris.assign(adjOffset[groupCount], 0);
+    {
+      std::vector<unsigned int> fill(adjOffset.begin(), adjOffset.end() - 1);
+      for (size_t i = 0; i < tris.size(); i++)
+        for (int k = 0; k < 3; k++)
+          adjTris[fill[tris[i].group[k]]++] = (unsigned int)i;
+    }
+
+    // Border edges are used by a single triangle
+    edgeUse.clear();
+    edgeUse.reserve(tris.size() * 3);
+    for (const Triangle &t : tris)
+      for (int k = 0; k < 3; k++)
+        edgeUse[edgeKey(t.group[k], t.group[(k + 1) % 3])]++;
+    std::fill(border.begin(), border.end(), 0);
+    for (const auto &e : edgeUse) {
+      if (e.second == 1) {
+        border[e.first >> 32] = 1;
+        border[e.first & 0xffffffffu] = 1;
+      }
+    }
+
+    candidates.clear();
+    for (const Triangle &t : tris) {
+      for (int k = 0; k < 3; k++) {
+        unsigned int a = t.group[k], b = t.group[(k + 1) % 3];
+        bool borderEdge = edgeUse[edgeKey(a, b)] == 1;
+        for (int dir = 0; dir < 2; dir++) {
+          unsigned int from = dir ? b : a, to = dir ? a : b;
+          // Border vertices may only slide along the border
+          if (border[from] && !borderEdge)
+            continue;
+          Quadric q = quadrics[from];
+          q.add(quadrics[to]);
+          candidates.push_back({from, to, q.error(groupPos(to))});
+        }
+      }
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    for (size_t g = 0; g < groupCount; g++)
+      collapseTo[g] = (unsigned int)g;
+    std::fill(touched.begin(), touched.end(), 0);
+
+    size_t toRemove = tris.size() - targetTris;
+    size_t removed = 0;
+    for (const Collapse &c : candidates) {
+      if (removed >= toRemove)
+        break;
+      if (touched[c.from] || touched[c.to])
+        continue;
+
+      // Reject collapses that would flip a surrounding triangle
+      bool flips = false;
+      size_t dropped = 0;
+      for (unsigned int i = adjOffset[c.from]; i < adjOffset[c.from + 1]; i++) {
+        const Triangle &t = tris[adjTris[i]];
+        if (t.group[0] == c.to || t.group[1] == c.to || t.group[2] == c.to) {
+          dropped++;
+          continue;
+        }
+        const float *p[3], *q[3];
+        for (int k = 0; k < 3; k++) {
+          p[k] = groupPos(t.group[k]);
+          q[k] = t.group[k] == c.from ? groupPos(c.to) : p[k];
+        }
+        float before[3], after[3];
+        triangleNormal(p[0], p[1], p[2], before);
+        triangleNormal(q[0], q[1], q[2], after);
+        if (before[0] * after[0] + before[1] * after[1] +
+                before[2] * after[2] <=
+            0.0f) {
+          flips = true;
+          break;
+        }
+      }
+      if (flips || dropped == 0)
+        continue;
+
+      collapseTo[c.from] = c.to;
+      quadrics[c.to].add(quadrics[c.from]);
+      touched[c.to] = 1;
+      for (unsigned int i = adjOffset[c.from]; i < adjOffset[c.from + 1]; i++)
+        for (int k = 0; k < 3; k++)
+          touched[tris[adjTris[i]].group[k]] = 1;
+      removed += dropped;
+    }
+
+    if (removed == 0)
+      break; // Nothing left that can collapse safely
+
+    // Apply collapses and drop degenerate triangles
+    size_t live = 0;
+    for (size_t i = 0; i < tris.size(); i++) {
+      Triangle t = tris[i];
+      for (int k = 0; k < 3; k++) {
+        unsigned int g = collapseTo[t.group[k]];
+        if (g != t.group[k]) {
+          t.group[k] = g;
+          t.vertex[k] = groupVertex[g];
+        }
+      }
+      if (t.group[0] != t.group[1] && t.group[1] != t.group[2] &&
+          t.group[0] != t.group[2])
+        tris[live++] = t;
+    }
+    tris.resize(live);
+  }
+
+  std::vector<unsigned int> result;
+  result.reserve(tris.size() * 3);
+  for (const Triangle &t : tris)
+    for (int k = 0; k < 3; k++)
+      result.push_back(t.vertex[k]);
+  return result;
+}
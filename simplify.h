@@ -0,0 +1,22 @@
+// ============================================================================
+// Simplify.h - Quadric Edge-Collapse Mesh Simplification
+// Used by Model to build its LOD chain at load time
+// ============================================================================
+
+#ifndef SIMPLIFY_H
+#define SIMPLIFY_H
+
+#include <cstddef>
+#include <vector>
+
+// Reduces an indexed triangle list towards targetIndexCount indices.
+// positions points at the first float of vertex 0; consecutive vertices are
+// strideBytes apart. Vertices that share a position (UV/normal seams) are
+// collapsed together, and collapses always move onto an existing vertex, so
+// the result indexes the same vertex buffer as the input.
+std::vector<unsigned int> simplifyMesh(const std::vector<unsigned int> &indices,
+                                       const float *positions,
+                                       size_t vertexCount, size_t strideBytes,
+                                       size_t targetIndexCount);
+
+#endif // SIMPLIFY_H
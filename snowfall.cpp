@@ -0,0 +1,115 @@
+// ============================================================================
+// Snowfall.cpp - Batched Snow Particles Implementation
+// ============================================================================
+
+#include "snowfall.h"
+#include "model.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+size_t Snowfall::defaultCount = 50000;
+float Snowfall::budget = 1.0f;
+bool Snowfall::synchronizeTiming = false;
+double Snowfall::drawMs = 0.0;
+int Snowfall::drawnCount = 0;
+
+Snowfall::Snowfall()
+    : extent(50.0f), height(50.0f), flakeSize(0.2f), bufferId(0) {}
+
+Snowfall::~Snowfall() {
+  if (bufferId != 0)
+    glDeleteBuffers(1, &bufferId);
+}
+
+void Snowfall::init(size_t count, float fieldExtent, float fieldHeight,
+                    float size) {
+  extent = fieldExtent;
+  height = fieldHeight;
+  flakeSize = size;
+  positions.resize(count * 3);
+  speeds.resize(count);
+  for (size_t i = 0; i < count; i++) {
+    respawn(i);
+    positions[i * 3 + 1] = (float)(rand() % (int)height);
+    speeds[i] = 2.0f + (float)(rand() % 100) / 50.0f;
+  }
+}
+
+void Snowfall::respawn(size_t i) {
+  int span = (int)(2.0f * extent);
+  positions[i * 3] = (rand() % span) - extent;
+  positions[i * 3 + 1] = height;
+  positions[i * 3 + 2] = (rand() % span) - extent;
+}
+
+size_t Snowfall::getActiveCount() const {
+  float fraction = budget < 0.0f ? 0.0f : (budget > 1.0f ? 1.0f : budget);
+  return (size_t)(speeds.size() * fraction);
+}
+
+void Snowfall::update(float deltaTime) {
+  size_t count = getActiveCount();
+  for (size_t i = 0; i < count; i++) {
+    float &y = positions[i * 3 + 1];
+    y -= speeds[i] * deltaTime;
+    if (y < 0)
+      respawn(i); // Randomize X/Z on respawn for variety
+  }
+}
+
+void Snowfall::render() {
+  GLsizei count = (GLsizei)getActiveCount();
+  if (count == 0)
+    return;
+  if (synchronizeTiming)
+    glFinish();
+  auto start = std::chrono::steady_clock::now();
+
+  // Size points like spheres of flakeSize: the attenuated size is
+  // pointSize / sqrt(c * d^2), so c picks the size at each eye distance d
+  static GLfloat maxSize = 0.0f;
+  if (maxSize == 0.0f) {
+    GLfloat range[2] = {1.0f, 1.0f};
+    glGetFloatv(GL_ALIASED_POINT_SIZE_RANGE, range);
+    maxSize = range[1] > 1.0f ? range[1] : 1.0f;
+  }
+  GLfloat projection[16];
+  GLint viewport[4];
+  glGetFloatv(GL_PROJECTION_MATRIX, projection);
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  float pixelScale = projection[5] * viewport[3] * 0.5f;
+  float k = maxSize / (flakeSize * pixelScale);
+  GLfloat attenuation[3] = {0.0f, 0.0f, k * k};
+  glPointSize(maxSize);
+  glPointParameterfv(GL_POINT_DISTANCE_ATTENUATION, attenuation);
+  glPointParameterf(GL_POINT_SIZE_MIN, 1.0f); // Far flakes stay visible
+
+  const GLvoid *data = positions.data();
+  if (Model::useVertexBuffers && Model::vertexBuffersSupported()) {
+    if (bufferId == 0)
+      glGenBuffers(1, &bufferId);
+    glBindBuffer(GL_ARRAY_BUFFER, bufferId);
+    glBufferData(GL_ARRAY_BUFFER, count * 3 * sizeof(float),
+                 positions.data(), GL_STREAM_DRAW);
+    data = nullptr;
+  }
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glVertexPointer(3, GL_FLOAT, 0, data);
+  glDrawArrays(GL_POINTS, 0, count);
+  glDisableClientState(GL_VERTEX_ARRAY);
+  if (data == nullptr)
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  GLfloat noAttenuation[3] = {1.0f, 0.0f, 0.0f};
+  glPointParameterfv(GL_POINT_DISTANCE_ATTENUATION, noAttenuation);
+  glPointParameterf(GL_POINT_SIZE_MIN, 0.0f);
+  glPointSize(1.0f);
+
+  if (synchronizeTiming)
+    glFinish();
+  drawMs += std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start)
+                .count();
+  drawnCount += count;
+}
@@ -0,0 +1,65 @@
+// ============================================================================
+// Snowfall.h - Batched Snow Particles
+// Keeps every flake's position in one contiguous array and draws the whole
+// field as distance-attenuated points in a single call
+// ============================================================================
+
+#ifndef SNOWFALL_H
+#define SNOWFALL_H
+
+#include <vector>
+#ifdef __APPLE__
+#include <GLUT/glut.h>
+#else
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES // glGenBuffers & co. live in glext.h on Mesa
+#endif
+#include <GL/glut.h>
+#endif
+
+class Snowfall {
+private:
+    std::vector<float> positions; // x, y, z per flake, as uploaded
+    std::vector<float> speeds;
+    float extent;     // Flakes fall within -extent..extent on x and z
+    float height;     // and respawn at this height
+    float flakeSize;  // World-space diameter of a flake
+    GLuint bufferId;
+
+    // New x and z for flake i, at the top of the field
+    void respawn(size_t i);
+
+public:
+    Snowfall();
+    ~Snowfall();
+    Snowfall(const Snowfall&) = delete;
+    Snowfall& operator=(const Snowfall&) = delete;
+
+    // Scatters count flakes through the field (keeps the GL buffer)
+    void init(size_t count, float extent, float height, float flakeSize);
+    void update(float deltaTime);
+    // One draw of every flake in the current colour; uses the current
+    // projection and viewport to size them like spheres of flakeSize
+    void render();
+
+    size_t getCount() const { return speeds.size(); }
+    size_t getActiveCount() const;
+
+    // Flakes per level, set from the command line
+    static size_t defaultCount;
+    // Fraction of the flakes updated and drawn (set by the quality
+    // governor); the rest wait where they are
+    static float budget;
+    // glFinish() around the draw so drawMs includes the GPU's work (stalls
+    // the pipeline; set it for measured frames only)
+    static bool synchronizeTiming;
+    // Per-frame time spent uploading and drawing snow, and flakes drawn
+    static double drawMs;
+    static int drawnCount;
+    static void resetCounts() {
+        drawMs = 0.0;
+        drawnCount = 0;
+    }
+};
+
+#endif // SNOWFALL_H
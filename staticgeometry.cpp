@@ -0,0 +1,832 @@
+// ============================================================================
+// StaticGeometry.cpp - Baked Level Geometry Implementation
+// ============================================================================
+
+#include "staticgeometry.h"
+#include "frustum.h"
+#include "lights.h"
+#include "occlusion.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#define PI 3.14159265359f
+
+// ============================================================================
+// MESH BUILDER
+// ============================================================================
+
+MeshBuilder::MeshBuilder() : target(nullptr), mode(GL_TRIANGLES) {
+  matrices.push_back(Transform());
+  currentColor[0] = currentColor[1] = currentColor[2] = currentColor[3] = 1.0f;
+  currentNormal[0] = currentNormal[1] = 0.0f;
+  currentNormal[2] = 1.0f;
+  currentUv[0] = currentUv[1] = 0.0f;
+  textureWindow(0.0f, 0.0f, 1.0f, 1.0f);
+}
+
+void MeshBuilder::pushMatrix() { matrices.push_back(matrices.back()); }
+
+void MeshBuilder::popMatrix() {
+  if (matrices.size() > 1)
+    matrices.pop_back();
+}
+
+void MeshBuilder::translate(float x, float y, float z) {
+  matrices.back().translate(x, y, z);
+}
+
+void MeshBuilder::rotate(float degrees, float x, float y, float z) {
+  matrices.back().rotate(degrees, x, y, z);
+}
+
+void MeshBuilder::scale(float x, float y, float z) {
+  matrices.back().scale(x, y, z);
+}
+
+void MeshBuilder::color(float r, float g, float b, float a) {
+  currentColor[0] = r;
+  currentColor[1] = g;
+  currentColor[2] = b;
+  currentColor[3] = a;
+}
+
+void MeshBuilder::normal(float x, float y, float z) {
+  currentNormal[0] = x;
+  currentNormal[1] = y;
+  currentNormal[2] = z;
+}
+
+void MeshBuilder::texCoord(float u, float v) {
+  currentUv[0] = window[0] + (window[2] - window[0]) * u;
+  currentUv[1] = window[1] + (window[3] - window[1]) * v;
+}
+
+void MeshBuilder::textureWindow(float u0, float v0, float u1, float v1) {
+  window[0] = u0;
+  window[1] = v0;
+  window[2] = u1;
+  window[3] = v1;
+}
+
+void MeshBuilder::begin(GLenum primitiveMode) {
+  mode = primitiveMode;
+  primitive.clear();
+}
+
+void MeshBuilder::vertex(float x, float y, float z) {
+  const float *m = matrices.back().m;
+  BakedVertex v;
+  for (int r = 0; r < 3; r++)
+    v.position[r] = m[r] * x + m[4 + r] * y + m[8 + r] * z + m[12 + r];
+
+  // Normals go through the inverse transpose of the upper 3x3, which is its
+  // cofactor matrix up to the sign of the determinant
+  float a[3][3];
+  for (int r = 0; r < 3; r++)
+    for (int c = 0; c < 3; c++)
+      a[r][c] = m[c * 4 + r];
+  float cof[3][3];
+  for (int r = 0; r < 3; r++)
+    for (int c = 0; c < 3; c++)
+      cof[r][c] = a[(r + 1) % 3][(c + 1) % 3] * a[(r + 2) % 3][(c + 2) % 3] -
+                  a[(r + 1) % 3][(c + 2) % 3] * a[(r + 2) % 3][(c + 1) % 3];
+  float det = a[0][0] * cof[0][0] + a[0][1] * cof[0][1] + a[0][2] * cof[0][2];
+  float sign = det < 0.0f ? -1.0f : 1.0f;
+  float length = 0.0f;
+  for (int r = 0; r < 3; r++) {
+    v.normal[r] = sign * (cof[r][0] * currentNormal[0] +
+                          cof[r][1] * currentNormal[1] +
+                          cof[r][2] * currentNormal[2]);
+    length += v.normal[r] * v.normal[r];
+  }
+  length = std::sqrt(length);
+  if (length > 0.0f)
+    for (int r = 0; r < 3; r++)
+      v.normal[r] /= length;
+
+  v.uv[0] = currentUv[0];
+  v.uv[1] = currentUv[1];
+  for (int i = 0; i < 4; i++) {
+    float c = currentColor[i] < 0.0f ? 0.0f
+              : currentColor[i] > 1.0f ? 1.0f
+                                       : currentColor[i];
+    v.color[i] = v.albedo[i] = (unsigned char)(c * 255.0f + 0.5f);
+  }
+  primitive.push_back(v);
+}
+
+void MeshBuilder::end() {
+  if (!target) {
+    primitive.clear();
+    return;
+  }
+  std::vector<BakedVertex> &out = *target;
+  const std::vector<BakedVertex> &p = primitive;
+  size_t n = p.size();
+  switch (mode) {
+  case GL_TRIANGLES:
+    for (size_t i = 0; i + 2 < n; i += 3)
+      out.insert(out.end(), {p[i], p[i + 1], p[i + 2]});
+    break;
+  case GL_QUADS:
+    for (size_t i = 0; i + 3 < n; i += 4)
+      out.insert(out.end(),
+                 {p[i], p[i + 1], p[i + 2], p[i], p[i + 2], p[i + 3]});
+    break;
+  case GL_TRIANGLE_FAN:
+    for (size_t i = 1; i + 1 < n; i++)
+      out.insert(out.end(), {p[0], p[i], p[i + 1]});
+    break;
+  case GL_TRIANGLE_STRIP:
+    for (size_t i = 0; i + 2 < n; i++) {
+      if (i % 2 == 0)
+        out.insert(out.end(), {p[i], p[i + 1], p[i + 2]});
+      else
+        out.insert(out.end(), {p[i + 1], p[i], p[i + 2]});
+    }
+    break;
+  case GL_QUAD_STRIP:
+    for (size_t i = 0; i + 3 < n; i += 2)
+      out.insert(out.end(), {p[i], p[i + 1], p[i + 3], p[i], p[i + 3],
+                             p[i + 2]});
+    break;
+  }
+  primitive.clear();
+}
+
+void MeshBuilder::solidCube(float size) {
+  // Per face: normal axis, then the two in-plane axes so that u x v points
+  // along the normal
+  static const float faces[6][3][3] = {
+      {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}},   {{-1, 0, 0}, {0, 0, 1}, {0, 1, 0}},
+      {{0, 1, 0}, {0, 0, 1}, {1, 0, 0}},   {{0, -1, 0}, {1, 0, 0}, {0, 0, 1}},
+      {{0, 0, 1}, {1, 0, 0}, {0, 1, 0}},   {{0, 0, -1}, {0, 1, 0}, {1, 0, 0}}};
+  static const float corners[4][2] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+  float h = size / 2.0f;
+  begin(GL_QUADS);
+  for (const auto &face : faces) {
+    normal(face[0][0], face[0][1], face[0][2]);
+    for (const float *c : corners)
+      vertex(h * (face[0][0] + c[0] * face[1][0] + c[1] * face[2][0]),
+             h * (face[0][1] + c[0] * face[1][1] + c[1] * face[2][1]),
+             h * (face[0][2] + c[0] * face[1][2] + c[1] * face[2][2]));
+  }
+  end();
+}
+
+void MeshBuilder::solidSphere(float radius, int slices, int stacks) {
+  // Poles on the z axis, as GLUT tessellates it
+  for (int i = 0; i < stacks; i++) {
+    float phi0 = PI * i / stacks, phi1 = PI * (i + 1) / stacks;
+    begin(GL_QUAD_STRIP);
+    for (int j = 0; j <= slices; j++) {
+      float theta = 2.0f * PI * j / slices;
+      float c = std::cos(theta), s = std::sin(theta);
+      float nx = std::sin(phi0) * c, ny = std::sin(phi0) * s;
+      float nz = std::cos(phi0);
+      normal(nx, ny, nz);
+      vertex(nx * radius, ny * radius, nz * radius);
+      nx = std::sin(phi1) * c;
+      ny = std::sin(phi1) * s;
+      nz = std::cos(phi1);
+      normal(nx, ny, nz);
+      vertex(nx * radius, ny * radius, nz * radius);
+    }
+    end();
+  }
+}
+
+void MeshBuilder::solidCone(float base, float height, int slices,
+                            int stacks) {
+  // Base disk at z = 0 facing -z, apex at z = height
+  begin(GL_TRIANGLE_FAN);
+  normal(0, 0, -1);
+  vertex(0, 0, 0);
+  for (int j = slices; j >= 0; j--) {
+    float theta = 2.0f * PI * j / slices;
+    vertex(std::cos(theta) * base, std::sin(theta) * base, 0);
+  }
+  end();
+
+  float slant = std::sqrt(height * height + base * base);
+  float nxy = height / slant, nz = base / slant;
+  for (int i = 0; i < stacks; i++) {
+    float z0 = height * i / stacks, z1 = height * (i + 1) / stacks;
+    float r0 = base * (1.0f - (float)i / stacks);
+    float r1 = base * (1.0f - (float)(i + 1) / stacks);
+    begin(GL_QUAD_STRIP);
+    for (int j = 0; j <= slices; j++) {
+      float theta = 2.0f * PI * j / slices;
+      float c = std::cos(theta), s = std::sin(theta);
+      normal(c * nxy, s * nxy, nz);
+      vertex(c * r1, s * r1, z1);
+      vertex(c * r0, s * r0, z0);
+    }
+    end();
+  }
+}
+
+void MeshBuilder::cylinder(float base, float top, float height, int slices,
+                           int stacks) {
+  // GLU's layout: x = sin, y = cos, s around from 0 to 1, t up the z axis
+  float slope = (base - top) / height;
+  float nxy = 1.0f / std::sqrt(1.0f + slope * slope);
+  float nz = slope * nxy;
+  for (int i = 0; i < stacks; i++) {
+    float t0 = (float)i / stacks, t1 = (float)(i + 1) / stacks;
+    float r0 = base + (top - base) * t0, r1 = base + (top - base) * t1;
+    begin(GL_QUAD_STRIP);
+    for (int j = 0; j <= slices; j++) {
+      float theta = 2.0f * PI * (j == slices ? 0 : j) / slices;
+      float s = std::sin(theta), c = std::cos(theta);
+      float u = (float)j / slices;
+      normal(s * nxy, c * nxy, nz);
+      texCoord(u, t0);
+      vertex(s * r0, c * r0, t0 * height);
+      texCoord(u, t1);
+      vertex(s * r1, c * r1, t1 * height);
+    }
+    end();
+  }
+}
+
+void MeshBuilder::solidTorus(float innerRadius, float outerRadius, int sides,
+                             int rings) {
+  // Ring around the z axis with a tube of innerRadius
+  for (int i = 0; i < rings; i++) {
+    float phi0 = 2.0f * PI * i / rings, phi1 = 2.0f * PI * (i + 1) / rings;
+    begin(GL_QUAD_STRIP);
+    for (int j = 0; j <= sides; j++) {
+      float theta = 2.0f * PI * j / sides;
+      float ct = std::cos(theta), st = std::sin(theta);
+      float ring = outerRadius + innerRadius * ct;
+      normal(std::cos(phi0) * ct, std::sin(phi0) * ct, st);
+      vertex(std::cos(phi0) * ring, std::sin(phi0) * ring, innerRadius * st);
+      normal(std::cos(phi1) * ct, std::sin(phi1) * ct, st);
+      vertex(std::cos(phi1) * ring, std::sin(phi1) * ring, innerRadius * st);
+    }
+    end();
+  }
+}
+
+void MeshBuilder::solidOctahedron() {
+  static const float inv = 0.57735027f; // 1 / sqrt(3)
+  begin(GL_TRIANGLES);
+  for (int octant = 0; octant < 8; octant++) {
+    float sx = octant & 1 ? -1.0f : 1.0f;
+    float sy = octant & 2 ? -1.0f : 1.0f;
+    float sz = octant & 4 ? -1.0f : 1.0f;
+    normal(sx * inv, sy * inv, sz * inv);
+    // x, y, z vertices wind outwards when the octant's signs multiply to +1
+    vertex(sx, 0, 0);
+    if (sx * sy * sz > 0.0f) {
+      vertex(0, sy, 0);
+      vertex(0, 0, sz);
+    } else {
+      vertex(0, 0, sz);
+      vertex(0, sy, 0);
+    }
+  }
+  end();
+}
+
+void MeshBuilder::mesh(const std::vector<MeshVertex> &vertices,
+                       const std::vector<unsigned int> &indices) {
+  begin(GL_TRIANGLES);
+  for (unsigned int index : indices) {
+    const MeshVertex &v = vertices[index];
+    normal(v.normal.x, v.normal.y, v.normal.z);
+    texCoord(v.uv.u, v.uv.v);
+    vertex(v.position.x, v.position.y, v.position.z);
+  }
+  end();
+}
+
+// ============================================================================
+// STATIC GEOMETRY
+// ============================================================================
+
+bool StaticGeometry::bakeLights = true;
+float StaticGeometry::chunkSize = 32.0f;
+int StaticGeometry::drawnChunks = 0;
+int StaticGeometry::culledChunks = 0;
+int StaticGeometry::dynamicLitChunks = 0;
+
+MeshBuilder &StaticGeometry::group(const RenderState &state, bool cull) {
+  unsigned long long key = state.sortKey();
+  Group *found = nullptr;
+  for (Group &g : groups)
+    if (g.state.sortKey() == key)
+      found = &g;
+  if (!found) {
+    groups.push_back(Group());
+    found = &groups.back();
+    found->state = state;
+    found->bufferId = 0;
+    found->vertexCount = 0;
+    found->cull = true;
+    found->baked = false;
+  }
+  found->cull = found->cull && cull;
+  if (state.isTransparent()) {
+    Range range = {(GLint)found->vertices.size(), 0, {0.0f, 0.0f, 0.0f}};
+    found->ranges.push_back(range);
+  }
+  // New groups may move the vertex arrays of earlier ones, so only the
+  // latest target is kept
+  builder.setTarget(&found->vertices);
+  return builder;
+}
+
+// Grows bounds (min x, y, z, max x, y, z) to hold position
+static void growBounds(float *bounds, const float *position) {
+  for (int k = 0; k < 3; k++) {
+    bounds[k] = std::min(bounds[k], position[k]);
+    bounds[3 + k] = std::max(bounds[3 + k], position[k]);
+  }
+}
+
+static void emptyBounds(float *bounds) {
+  for (int k = 0; k < 3; k++) {
+    bounds[k] = 1e30f;
+    bounds[3 + k] = -1e30f;
+  }
+}
+
+void StaticGeometry::buildChunks(Group &g) {
+  g.chunks.clear();
+  size_t triangles = g.vertices.size() / 3;
+  if (g.state.isTransparent() || triangles == 0)
+    return;
+
+  // Triangles ordered by the cell their centroid falls in; the order within
+  // a cell is kept
+  std::vector<std::pair<std::pair<int, int>, size_t>> order(triangles);
+  for (size_t t = 0; t < triangles; t++) {
+    float x = 0.0f, z = 0.0f;
+    for (int c = 0; c < 3; c++) {
+      x += g.vertices[t * 3 + c].position[0] / 3.0f;
+      z += g.vertices[t * 3 + c].position[2] / 3.0f;
+    }
+    std::pair<int, int> cell(0, 0);
+    if (g.cull)
+      cell = std::make_pair((int)std::floor(z / chunkSize),
+                            (int)std::floor(x / chunkSize));
+    order[t] = std::make_pair(cell, t);
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [](const std::pair<std::pair<int, int>, size_t> &a,
+                      const std::pair<std::pair<int, int>, size_t> &b) {
+                     return a.first < b.first;
+                   });
+
+  std::vector<BakedVertex> vertices(triangles * 3);
+  std::vector<LitVertex> lit(g.lit.empty() ? 0 : triangles * 3);
+  for (size_t i = 0; i < triangles; i++) {
+    size_t t = order[i].second;
+    if (i == 0 || order[i].first != order[i - 1].first) {
+      Chunk chunk;
+      chunk.first = (GLint)(i * 3);
+      chunk.count = 0;
+      emptyBounds(chunk.bounds);
+      g.chunks.push_back(chunk);
+    }
+    Chunk &chunk = g.chunks.back();
+    for (int c = 0; c < 3; c++) {
+      vertices[i * 3 + c] = g.vertices[t * 3 + c];
+      if (!lit.empty())
+        lit[i * 3 + c] = g.lit[t * 3 + c];
+      growBounds(chunk.bounds, vertices[i * 3 + c].position);
+    }
+    chunk.count += 3;
+  }
+  g.vertices.swap(vertices);
+  g.lit.swap(lit);
+}
+
+void StaticGeometry::buildChunks() {
+  for (Group &g : groups)
+    buildChunks(g);
+}
+
+void StaticGeometry::upload() {
+  for (Group &g : groups) {
+    if (g.chunks.empty())
+      buildChunks(g);
+    g.vertexCount = (GLsizei)g.vertices.size();
+    for (size_t i = 0; i < g.ranges.size(); i++) {
+      Range &r = g.ranges[i];
+      GLint last = i + 1 < g.ranges.size() ? g.ranges[i + 1].first
+                                           : (GLint)g.vertexCount;
+      r.count = last - r.first;
+      double sum[3] = {0.0, 0.0, 0.0};
+      emptyBounds(r.bounds);
+      for (GLint v = r.first; v < last; v++) {
+        for (int k = 0; k < 3; k++)
+          sum[k] += g.vertices[v].position[k];
+        growBounds(r.bounds, g.vertices[v].position);
+      }
+      for (int k = 0; k < 3; k++)
+        r.center[k] = r.count ? (float)(sum[k] / r.count) : 0.0f;
+    }
+
+    if (!Model::useVertexBuffers || !Model::vertexBuffersSupported() ||
+        g.vertexCount == 0)
+      continue;
+    if (g.bufferId == 0)
+      glGenBuffers(1, &g.bufferId);
+    glBindBuffer(GL_ARRAY_BUFFER, g.bufferId);
+    glBufferData(GL_ARRAY_BUFFER, g.vertices.size() * sizeof(BakedVertex),
+                 g.vertices.data(),
+                 g.lit.empty() ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (g.lit.empty()) // relight() rewrites the rest from client memory
+      std::vector<BakedVertex>().swap(g.vertices);
+  }
+  builder.setTarget(nullptr);
+}
+
+void StaticGeometry::release() {
+  for (Group &g : groups)
+    if (g.bufferId != 0)
+      glDeleteBuffers(1, &g.bufferId);
+  groups.clear();
+  builder.setTarget(nullptr);
+  bakedVertices = 0;
+  relightGroup = relightVertex = 0;
+}
+
+void StaticGeometry::swap(StaticGeometry &other) {
+  groups.swap(other.groups);
+  std::swap(bakedVertices, other.bakedVertices);
+  std::swap(relightGroup, other.relightGroup);
+  std::swap(relightVertex, other.relightVertex);
+  builder.setTarget(nullptr);
+  other.builder.setTarget(nullptr);
+}
+
+size_t StaticGeometry::getTriangleCount() const {
+  size_t triangles = 0;
+  for (const Group &g : groups)
+    triangles += g.vertexCount / 3;
+  return triangles;
+}
+
+// Highest opaque surface over each 1x1 cell of the x/z plane, which the
+// ambient occlusion term looks for horizons in
+namespace {
+struct Heightfield {
+  float minX, minZ;
+  int width, depth;
+  std::vector<float> heights;
+
+  float at(float x, float z) const {
+    int cx = (int)std::floor(x - minX), cz = (int)std::floor(z - minZ);
+    if (cx < 0 || cz < 0 || cx >= width || cz >= depth)
+      return -1e30f;
+    return heights[cz * width + cx];
+  }
+  void raise(float x, float y, float z) {
+    int cx = (int)std::floor(x - minX), cz = (int)std::floor(z - minZ);
+    if (cx < 0 || cz < 0 || cx >= width || cz >= depth)
+      return;
+    float &h = heights[cz * width + cx];
+    h = std::max(h, y);
+  }
+};
+} // namespace
+
+static float occlusionAt(const Heightfield &field, const BakedVertex &v) {
+  static const float distances[] = {1.5f, 3.0f, 6.0f, 12.0f};
+  const float *n = v.normal;
+  // Start half a unit off the surface, so a wall does not shade itself
+  float px = v.position[0] + n[0] * 0.5f, pz = v.position[2] + n[2] * 0.5f;
+  float py = v.position[1] + 0.05f;
+  float occluded = 0.0f, total = 0.0f;
+  for (int i = 0; i < 8; i++) {
+    float dx = std::cos(i * PI / 4), dz = std::sin(i * PI / 4);
+    // Directions the surface does not face see nothing of it
+    float weight = n[0] * dx + n[2] * dz + n[1];
+    if (weight <= 0.0f)
+      continue;
+    float slope = 0.0f; // Steepest horizon, rise over run
+    for (float d : distances)
+      slope = std::max(slope, (field.at(px + dx * d, pz + dz * d) - py) / d);
+    occluded += weight * slope / std::sqrt(1.0f + slope * slope);
+    total += weight;
+  }
+  return total > 0.0f ? 1.0f - 0.8f * occluded / total : 1.0f;
+}
+
+void StaticGeometry::lightVertex(BakedVertex &vertex, const LitVertex &lit,
+                                 const LightSource &sun) {
+  float lx = sun.position[0] - vertex.position[0];
+  float ly = sun.position[1] - vertex.position[1];
+  float lz = sun.position[2] - vertex.position[2];
+  float length = std::sqrt(lx * lx + ly * ly + lz * lz);
+  float facing = 0.0f;
+  if (length > 0.0f)
+    facing = std::max(0.0f, (vertex.normal[0] * lx + vertex.normal[1] * ly +
+                             vertex.normal[2] * lz) /
+                                length);
+  for (int k = 0; k < 3; k++) {
+    float c = lit.fixed[k] + vertex.albedo[k] / 255.0f *
+                                 (sun.ambient[k] * lit.occlusion +
+                                  sun.diffuse[k] * facing);
+    c = c < 0.0f ? 0.0f : c > 1.0f ? 1.0f : c;
+    vertex.color[k] = (unsigned char)(c * 255.0f + 0.5f);
+  }
+  vertex.color[3] = vertex.albedo[3];
+}
+
+void StaticGeometry::bakeLighting(const LightSource &sun,
+                                  const std::vector<PointLight> &lights,
+                                  bool sunMoves) {
+  if (!bakeLights)
+    return;
+
+  // Specular highlights move with the eye, so shiny groups stay lit
+  std::vector<Group *> baked;
+  for (Group &g : groups)
+    if (g.state.lighting && g.state.shininess == 0.0f && !g.vertices.empty())
+      baked.push_back(&g);
+  if (baked.empty())
+    return;
+
+  Heightfield field;
+  float maxX = -1e30f, maxZ = -1e30f;
+  field.minX = field.minZ = 1e30f;
+  for (const Group &g : groups) {
+    if (!g.state.lighting || g.state.isTransparent())
+      continue;
+    for (const BakedVertex &v : g.vertices) {
+      field.minX = std::min(field.minX, v.position[0]);
+      field.minZ = std::min(field.minZ, v.position[2]);
+      maxX = std::max(maxX, v.position[0]);
+      maxZ = std::max(maxZ, v.position[2]);
+    }
+  }
+  field.width = maxX >= field.minX ? (int)(maxX - field.minX) + 1 : 0;
+  field.depth = maxZ >= field.minZ ? (int)(maxZ - field.minZ) + 1 : 0;
+  field.heights.assign((size_t)field.width * field.depth, -1e30f);
+  // Sample every triangle at under half a cell, walls included: their top
+  // edge is what a neighbour sees
+  for (const Group &g : groups) {
+    if (!g.state.lighting || g.state.isTransparent())
+      continue;
+    for (size_t t = 0; t + 2 < g.vertices.size(); t += 3) {
+      const float *a = g.vertices[t].position;
+      const float *b = g.vertices[t + 1].position;
+      const float *c = g.vertices[t + 2].position;
+      float edge = 0.0f;
+      for (int k = 0; k < 3; k += 2)
+        edge = std::max(edge, std::max(std::fabs(b[k] - a[k]),
+                                       std::max(std::fabs(c[k] - a[k]),
+                                                std::fabs(c[k] - b[k]))));
+      int steps = (int)(edge * 2.0f) + 1;
+      for (int i = 0; i <= steps; i++) {
+        for (int j = 0; i + j <= steps; j++) {
+          float s = (float)i / steps, r = (float)j / steps;
+          float p[3];
+          for (int k = 0; k < 3; k++)
+            p[k] = a[k] + (b[k] - a[k]) * s + (c[k] - a[k]) * r;
+          field.raise(p[0], p[1], p[2]);
+        }
+      }
+    }
+  }
+
+  for (Group *g : baked) {
+    g->state.lighting = false;
+    g->baked = true;
+    if (sunMoves)
+      g->lit.resize(g->vertices.size());
+    for (size_t i = 0; i < g->vertices.size(); i++) {
+      BakedVertex &v = g->vertices[i];
+      LitVertex lit;
+      lit.occlusion = occlusionAt(field, v);
+      // GL's default global ambient of 0.2, then the point lights, which
+      // have no ambient or (on these groups) specular term
+      for (int k = 0; k < 3; k++)
+        lit.fixed[k] = v.albedo[k] / 255.0f * 0.2f * lit.occlusion;
+      for (const PointLight &l : lights) {
+        float lx = l.x - v.position[0], ly = l.y - v.position[1];
+        float lz = l.z - v.position[2];
+        float d = std::sqrt(lx * lx + ly * ly + lz * lz);
+        float facing = d > 0.0f ? (v.normal[0] * lx + v.normal[1] * ly +
+                                   v.normal[2] * lz) /
+                                      d
+                                : 1.0f;
+        if (facing <= 0.0f)
+          continue;
+        float attenuation =
+            facing / (l.attenuation[0] + l.attenuation[1] * d +
+                      l.attenuation[2] * d * d);
+        for (int k = 0; k < 3; k++)
+          lit.fixed[k] += v.albedo[k] / 255.0f * l.color[k] * attenuation;
+      }
+      lightVertex(v, lit, sun);
+      if (sunMoves)
+        g->lit[i] = lit;
+    }
+    bakedVertices += g->vertices.size();
+  }
+  relightGroup = relightVertex = 0;
+}
+
+void StaticGeometry::relight(const LightSource &sun, size_t budget) {
+  // At most one sweep per call; groups without a kept sun share are
+  // skipped, and a whole round of them ends the call
+  budget = std::min(budget, bakedVertices);
+  size_t skipped = 0;
+  while (budget > 0 && skipped <= groups.size()) {
+    if (relightGroup >= groups.size())
+      relightGroup = 0;
+    Group &g = groups[relightGroup];
+    if (relightVertex >= g.lit.size()) {
+      relightGroup++;
+      relightVertex = 0;
+      skipped++;
+      continue;
+    }
+    skipped = 0;
+    size_t first = relightVertex;
+    size_t last = std::min(g.lit.size(), first + budget);
+    for (size_t i = first; i < last; i++)
+      lightVertex(g.vertices[i], g.lit[i], sun);
+    if (g.bufferId != 0) {
+      glBindBuffer(GL_ARRAY_BUFFER, g.bufferId);
+      glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(BakedVertex),
+                      (last - first) * sizeof(BakedVertex),
+                      g.vertices.data() + first);
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    budget -= last - first;
+    relightVertex = last;
+  }
+}
+
+void StaticGeometry::bindGroup(const Group &group, bool albedo) {
+  const char *base = nullptr;
+  if (group.bufferId != 0)
+    glBindBuffer(GL_ARRAY_BUFFER, group.bufferId);
+  else
+    base = (const char *)group.vertices.data();
+  const GLsizei stride = sizeof(BakedVertex);
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glEnableClientState(GL_NORMAL_ARRAY);
+  glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+  glEnableClientState(GL_COLOR_ARRAY);
+  glVertexPointer(3, GL_FLOAT, stride,
+                  base + offsetof(BakedVertex, position));
+  glNormalPointer(GL_FLOAT, stride, base + offsetof(BakedVertex, normal));
+  glTexCoordPointer(2, GL_FLOAT, stride, base + offsetof(BakedVertex, uv));
+  glColorPointer(4, GL_UNSIGNED_BYTE, stride,
+                 base + (albedo ? offsetof(BakedVertex, albedo)
+                                : offsetof(BakedVertex, color)));
+}
+
+void StaticGeometry::unbindGroup(const Group &group) {
+  glDisableClientState(GL_COLOR_ARRAY);
+  glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+  glDisableClientState(GL_NORMAL_ARRAY);
+  glDisableClientState(GL_VERTEX_ARRAY);
+  if (group.bufferId != 0)
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void StaticGeometry::drawGroup(const Group &group, GLint first,
+                               GLsizei count) {
+  if (count == 0)
+    return;
+  bindGroup(group);
+  glDrawArrays(GL_TRIANGLES, first, count);
+  unbindGroup(group);
+}
+
+// Bounds test against the view, then the occluders. Occluders coincide with
+// the walls they stand for, so the occlusion box is grown a little to keep a
+// wall from hiding itself.
+static bool boundsVisible(const float *b, const Frustum &frustum,
+                          const OcclusionBuffer &occlusion) {
+  const float slack = 0.5f;
+  return frustum.boxVisible(b[0], b[1], b[2], b[3], b[4], b[5]) &&
+         occlusion.boxVisible(b[0] - slack, b[1] - slack, b[2] - slack,
+                              b[3] + slack, b[4] + slack, b[5] + slack);
+}
+
+void StaticGeometry::drawOpaque(const Frustum &frustum,
+                                const OcclusionBuffer &occlusion) const {
+  for (const Group &g : groups) {
+    if (g.state.isTransparent())
+      continue;
+    // Adjacent visible chunks are drawn as one run
+    bool bound = false;
+    GLint runFirst = 0;
+    GLsizei runCount = 0;
+    auto flush = [&] {
+      if (runCount == 0)
+        return;
+      if (!bound) {
+        RenderQueue::apply(g.state);
+        bindGroup(g);
+        bound = true;
+      }
+      glDrawArrays(GL_TRIANGLES, runFirst, runCount);
+      runCount = 0;
+    };
+    for (const Chunk &c : g.chunks) {
+      if (g.cull && !boundsVisible(c.bounds, frustum, occlusion)) {
+        culledChunks++;
+        flush();
+        continue;
+      }
+      drawnChunks++;
+      if (runCount == 0 || runFirst + runCount != c.first) {
+        flush();
+        runFirst = c.first;
+      }
+      runCount += c.count;
+    }
+    flush();
+    if (bound)
+      unbindGroup(g);
+  }
+}
+
+void StaticGeometry::submitTransparent(RenderQueue &queue,
+                                       const Frustum &frustum,
+                                       const OcclusionBuffer &occlusion) const {
+  for (const Group &g : groups) {
+    for (const Range &r : g.ranges) {
+      if (r.count == 0 ||
+          (g.cull && !boundsVisible(r.bounds, frustum, occlusion)))
+        continue;
+      const Group *group = &g;
+      GLint first = r.first;
+      GLsizei count = r.count;
+      queue.submit(g.state, r.center[0], r.center[1], r.center[2],
+                   [group, first, count] { drawGroup(*group, first, count); });
+    }
+  }
+}
+
+void StaticGeometry::drawDynamicLights(const Frustum &frustum,
+                                       const OcclusionBuffer &occlusion,
+                                       LightManager &lights) const {
+  // Only the point lights' diffuse term, over what is already on screen:
+  // no sun or global ambient, fog fading to black, and the same depths
+  // drawOpaque() wrote
+  bool started = false;
+  GLboolean sunEnabled = GL_FALSE;
+  GLfloat ambient[4];
+  auto start = [&] {
+    sunEnabled = glIsEnabled(GL_LIGHT0);
+    glGetFloatv(GL_LIGHT_MODEL_AMBIENT, ambient);
+    glPushAttrib(GL_DEPTH_BUFFER_BIT | GL_FOG_BIT);
+    GLfloat black[] = {0.0f, 0.0f, 0.0f, 1.0f};
+    glDisable(GL_LIGHT0);
+    glLightModelfv(GL_LIGHT_MODEL_AMBIENT, black);
+    glFogfv(GL_FOG_COLOR, black);
+    glDepthMask(GL_FALSE);
+    glDepthFunc(GL_LEQUAL);
+    started = true;
+  };
+
+  for (const Group &g : groups) {
+    if (!g.baked || g.state.isTransparent())
+      continue;
+    bool bound = false;
+    for (const Chunk &c : g.chunks) {
+      if (c.count == 0 ||
+          (g.cull && !boundsVisible(c.bounds, frustum, occlusion)))
+        continue;
+      const float *b = c.bounds;
+      float dx = b[3] - b[0], dy = b[4] - b[1], dz = b[5] - b[2];
+      float radius = 0.5f * std::sqrt(dx * dx + dy * dy + dz * dz);
+      if (lights.bind((b[0] + b[3]) * 0.5f, (b[1] + b[4]) * 0.5f,
+                      (b[2] + b[5]) * 0.5f, radius, true) == 0)
+        continue;
+      if (!started)
+        start();
+      if (!bound) {
+        RenderQueue::apply(
+            RenderState(BLEND_ADDITIVE, true, g.state.texture));
+        bindGroup(g, true);
+        bound = true;
+      }
+      glDrawArrays(GL_TRIANGLES, c.first, c.count);
+      dynamicLitChunks++;
+    }
+    if (bound)
+      unbindGroup(g);
+  }
+
+  if (!started)
+    return;
+  glPopAttrib();
+  glLightModelfv(GL_LIGHT_MODEL_AMBIENT, ambient);
+  if (sunEnabled)
+    glEnable(GL_LIGHT0);
+}
@@ -0,0 +1,196 @@
+// ============================================================================
+// StaticGeometry.h - Baked Level Geometry
+// Records a level's never-moving geometry once, pre-transformed into world
+// space, and draws it as one vertex buffer per render state
+// ============================================================================
+
+#ifndef STATICGEOMETRY_H
+#define STATICGEOMETRY_H
+
+#include "model.h"
+#include "renderqueue.h"
+#include "utils.h"
+#include <vector>
+
+struct PointLight;
+class Frustum;
+class LightManager;
+class OcclusionBuffer;
+
+// World-space vertex with its colour, as GL_COLOR_MATERIAL applies it, and
+// that colour before any baked lighting
+struct BakedVertex {
+    float position[3];
+    float normal[3];
+    float uv[2];
+    unsigned char color[4];
+    unsigned char albedo[4];
+};
+
+// Takes geometry the way immediate mode draws it -- current colour, normal
+// and texture coordinate, a modelview stack, glBegin/glEnd primitives -- and
+// appends it as transformed triangles. The solids are tessellated with the
+// parameters, orientation and texture coordinates of their GLUT/GLU
+// namesakes, so draw code ports call for call.
+class MeshBuilder {
+private:
+    std::vector<BakedVertex>* target;
+    std::vector<Transform> matrices; // back() is current
+    std::vector<BakedVertex> primitive; // vertices since begin()
+    GLenum mode;
+    float currentColor[4];
+    float currentNormal[3];
+    float currentUv[2];
+    float window[4]; // u0, v0, u1, v1
+
+public:
+    MeshBuilder();
+    void setTarget(std::vector<BakedVertex>* vertices) { target = vertices; }
+
+    void pushMatrix();
+    void popMatrix();
+    void translate(float x, float y, float z);
+    void rotate(float degrees, float x, float y, float z);
+    void scale(float x, float y, float z);
+
+    void color(float r, float g, float b, float a = 1.0f);
+    void normal(float x, float y, float z);
+    void texCoord(float u, float v);
+    // Maps later texture coordinates from 0..1 into this window, as a
+    // texture matrix translate and scale would (0, 0, 1, 1 to reset)
+    void textureWindow(float u0, float v0, float u1, float v1);
+    // GL_TRIANGLES, GL_QUADS, GL_TRIANGLE_FAN, GL_TRIANGLE_STRIP and
+    // GL_QUAD_STRIP
+    void begin(GLenum primitiveMode);
+    void vertex(float x, float y, float z);
+    void end();
+
+    void solidCube(float size);
+    void solidSphere(float radius, int slices, int stacks);
+    void solidCone(float base, float height, int slices, int stacks);
+    // gluCylinder with gluQuadricTexture enabled; no caps
+    void cylinder(float base, float top, float height, int slices,
+                  int stacks);
+    void solidTorus(float innerRadius, float outerRadius, int sides,
+                    int rings);
+    void solidOctahedron();
+    // A model's triangles (see Model::getMesh) through the current matrix,
+    // colour and texture window
+    void mesh(const std::vector<MeshVertex>& vertices,
+              const std::vector<unsigned int>& indices);
+};
+
+class StaticGeometry {
+private:
+    // Vertices added by one group() call of a transparent state, which the
+    // queue sorts on their own
+    struct Range {
+        GLint first;
+        GLsizei count;
+        float center[3];
+        float bounds[6]; // min x, y, z, max x, y, z
+    };
+    // Triangles of an opaque group within one chunkSize x chunkSize cell of
+    // the x/z plane, culled as a whole
+    struct Chunk {
+        GLint first;
+        GLsizei count;
+        float bounds[6];
+    };
+    // What stays fixed of a baked vertex's lighting while the sun moves
+    struct LitVertex {
+        float fixed[3];  // Global ambient and the point lights
+        float occlusion; // Ambient occlusion, 1 when open
+    };
+    struct Group {
+        RenderState state;
+        std::vector<BakedVertex> vertices; // Dropped once in a buffer,
+                                           // unless the sun is re-baked
+        GLuint bufferId;
+        GLsizei vertexCount;
+        std::vector<Range> ranges; // Transparent groups only
+        std::vector<LitVertex> lit; // Only while the sun is re-baked
+        std::vector<Chunk> chunks; // Opaque groups only
+        bool cull; // Off for the sky, which lies past the fog end
+        bool baked; // Lit through its colours by bakeLighting()
+    };
+    std::vector<Group> groups;
+    MeshBuilder builder;
+    size_t bakedVertices;
+    size_t relightGroup, relightVertex; // Where relight() continues
+
+    static void buildChunks(Group& group);
+    // With albedo the colour array is the unlit colour
+    static void bindGroup(const Group& group, bool albedo = false);
+    static void unbindGroup(const Group& group);
+    static void drawGroup(const Group& group, GLint first, GLsizei count);
+    static void lightVertex(BakedVertex& vertex, const LitVertex& lit,
+                            const LightSource& sun);
+
+public:
+    StaticGeometry() : bakedVertices(0), relightGroup(0), relightVertex(0) {}
+    ~StaticGeometry() { release(); }
+    StaticGeometry(const StaticGeometry&) = delete;
+    StaticGeometry& operator=(const StaticGeometry&) = delete;
+
+    // Builder appending to the group drawn with state (created on first
+    // use), valid until the next call. For a transparent state each call
+    // starts a piece that is depth sorted separately, so make one call per
+    // object. A group any call asks not to cull is always drawn whole.
+    MeshBuilder& group(const RenderState& state, bool cull = true);
+    // Before upload(), CPU only: sorts the opaque groups into chunks so
+    // upload() does not have to on the GL thread
+    void buildChunks();
+    // Moves every group into a vertex buffer (GL thread only); when Model's
+    // buffer path is off or unsupported they are drawn from client memory
+    void upload();
+    void release();
+    // Exchanges the contents with other, e.g. to put a geometry baked in
+    // the background in place
+    void swap(StaticGeometry& other);
+
+    // Before upload(): bakes the sun, the point lights and an ambient
+    // occlusion term (from a heightfield of the opaque geometry) into the
+    // colours of every lit group without a specular highlight, and draws
+    // those groups unlit. With sunMoves the sun's share is kept apart for
+    // relight().
+    void bakeLighting(const LightSource& sun,
+                      const std::vector<PointLight>& lights, bool sunMoves);
+    // Redoes the sun's share for up to budget vertices with its current
+    // position and colours, continuing where the last call stopped, and
+    // uploads them; a full sweep takes vertices / budget calls
+    void relight(const LightSource& sun, size_t budget);
+
+    // Opaque chunks that pass the frustum and occlusion tests, drawn at
+    // once; the visible transparent pieces are submitted to the queue so
+    // they are blended after the opaque entities
+    void drawOpaque(const Frustum& frustum,
+                    const OcclusionBuffer& occlusion) const;
+    void submitTransparent(RenderQueue& queue, const Frustum& frustum,
+                           const OcclusionBuffer& occlusion) const;
+    // After drawOpaque(): adds the lights the bake left out (orbs, portal,
+    // icicle warnings) to the visible baked chunks, in one additive pass
+    // per chunk they reach. Leaves those lights bound.
+    void drawDynamicLights(const Frustum& frustum,
+                           const OcclusionBuffer& occlusion,
+                           LightManager& lights) const;
+
+    size_t getGroupCount() const { return groups.size(); }
+    size_t getTriangleCount() const;
+    size_t getBakedVertexCount() const { return bakedVertices; }
+
+    // Lit groups keep fixed-function lighting while this is cleared
+    static bool bakeLights;
+    // Edge of a chunk on x and z
+    static float chunkSize;
+
+    // Per-frame chunk counts of drawOpaque(), and of drawDynamicLights()
+    static int drawnChunks;
+    static int culledChunks;
+    static int dynamicLitChunks;
+    static void resetCounts() {
+        drawnChunks = culledChunks = dynamicLitChunks = 0;
+    }
+};
+
+#endif // STATICGEOMETRY_H
@@ -0,0 +1,41 @@
+// ============================================================================
+// ThreadPool.h - Fixed-Size Worker Pool
+// Runs CPU-only jobs (asset decoding) off the GLUT thread
+// ============================================================================
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Jobs must not make GL calls: the context is only current on the GLUT
+// thread.
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::packaged_task<void()>> queue;
+    std::mutex mutex;
+    std::condition_variable jobReady;
+    bool stopping;
+
+    void workerLoop();
+
+public:
+    // threadCount 0 = one worker per hardware thread
+    explicit ThreadPool(unsigned threadCount = 0);
+    ~ThreadPool();
+
+    std::future<void> submit(std::function<void()> job);
+    unsigned getThreadCount() const { return (unsigned)workers.size(); }
+
+    // Process-wide pool shared by all loaders
+    static ThreadPool& shared();
+};
+
+#endif // THREADPOOL_H
@@ -6,9 +6,14 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include "pack.h"
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
 #ifdef __APPLE__
 #include <GLUT/glut.h>
 #else
@@ -170,65 +175,227 @@ struct Texture {
   unsigned int id;
   int width;
   int height;
+  size_t bytes; // uploaded texel data, all mip levels
 
-  Texture() : id(0), width(0), height(0) {}
+  Texture() : id(0), width(0), height(0), bytes(0) {}
 };
 
-// Simple BMP loader
-inline Texture loadBMP(const char *filename) {
-  Texture tex;
-  FILE *file = fopen(filename, "rb");
-  if (!file) {
-    printf("Image could not be opened: %s\n", filename);
-    return tex;
+// Decoded BMP pixels, bottom row first as GL expects: 24-bit BGR or 32-bit
+// BGRX rows padded to 4 bytes (stride). pixels points straight into the
+// file mapping or the asset pack when possible; storage is only used for
+// LZ4-packed files and top-down images, which are flipped on load. mips
+// holds levels 1..n of the mip chain back to back in the same row layout.
+struct BMPImage {
+  std::shared_ptr<const unsigned char> mapping; // keeps a loose file mapped
+  std::vector<unsigned char> storage;
+  std::vector<unsigned char> mips;
+  const unsigned char *pixels;
+  int width;
+  int height;
+  int bytesPerPixel; // 3 or 4
+  size_t stride;
+
+  BMPImage()
+      : pixels(nullptr), width(0), height(0), bytesPerPixel(3), stride(0) {}
+  BMPImage(const BMPImage &) = delete; // pixels may point into storage
+  BMPImage &operator=(const BMPImage &) = delete;
+  BMPImage(BMPImage &&) = default;
+  BMPImage &operator=(BMPImage &&) = default;
+};
+
+inline size_t bmpRowBytes(int width, int bytesPerPixel) {
+  return ((size_t)width * bytesPerPixel + 3) & ~(size_t)3;
+}
+
+inline uint32_t readLE32(const unsigned char *p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+inline uint16_t readLE16(const unsigned char *p) { return p[0] | (p[1] << 8); }
+
+// Validates a BMP held in memory and points image at its pixel rows. Accepts
+// uncompressed 24/32-bit images (and 32-bit BI_BITFIELDS with the standard
+// BGRX masks), bottom-up or top-down. Copies only to flip top-down rows.
+inline bool parseBMP(const unsigned char *data, size_t size,
+                     const char *filename, BMPImage &image) {
+  const char *error = nullptr;
+  uint32_t dataPos = 0, infoSize = 0, compression = 0;
+  int32_t width = 0, height = 0;
+  int bits = 0;
+  if (size < 54 || data[0] != 'B' || data[1] != 'M') {
+    error = "not a BMP file";
+  } else {
+    dataPos = readLE32(data + 0x0A);
+    infoSize = readLE32(data + 0x0E);
+    width = (int32_t)readLE32(data + 0x12);
+    height = (int32_t)readLE32(data + 0x16);
+    bits = readLE16(data + 0x1C);
+    compression = readLE32(data + 0x1E);
+    if (infoSize < 40 || readLE16(data + 0x1A) != 1)
+      error = "unsupported header";
+    else if (bits != 24 && bits != 32)
+      error = "unsupported bit depth (24 or 32 only)";
+    else if (compression == 3 && bits == 32 && size >= 66 &&
+             readLE32(data + 0x36) == 0x00FF0000 &&
+             readLE32(data + 0x3A) == 0x0000FF00 &&
+             readLE32(data + 0x3E) == 0x000000FF)
+      compression = 0; // BI_BITFIELDS with the BI_RGB layout
+    else if (compression != 0)
+      error = "compressed BMPs are not supported";
+    if (!error && (width <= 0 || width > 32768 || height == 0 ||
+                   height > 32768 || height < -32768))
+      error = "bad dimensions";
   }
 
-  unsigned char header[54];
-  if (fread(header, 1, 54, file) != 54) {
-    printf("Not a correct BMP file: %s\n", filename);
-    fclose(file);
-    return tex;
+  size_t rows = height < 0 ? (size_t)-height : (size_t)height;
+  size_t stride = error ? 0 : bmpRowBytes(width, bits / 8);
+  if (!error && (dataPos < 14 + infoSize || dataPos > size ||
+                 stride * rows > size - dataPos))
+    error = "pixel data out of bounds";
+  if (error) {
+    printf("Not a correct BMP file: %s (%s)\n", filename, error);
+    return false;
   }
 
-  if (header[0] != 'B' || header[1] != 'M') {
-    printf("Not a correct BMP file: %s\n", filename);
-    fclose(file);
-    return tex;
+  image.width = width;
+  image.height = (int)rows;
+  image.bytesPerPixel = bits / 8;
+  image.stride = stride;
+  image.pixels = data + dataPos;
+  if (height < 0) {
+    // Top-down: GL wants the bottom row first
+    std::vector<unsigned char> flipped(stride * rows);
+    for (size_t y = 0; y < rows; y++)
+      memcpy(&flipped[y * stride], data + dataPos + (rows - 1 - y) * stride,
+             stride);
+    image.storage.swap(flipped);
+    image.pixels = image.storage.data();
+  }
+  return true;
+}
+
+// Box-filters level 0 down to 1x1 into image.mips (odd edges repeat their
+// last texel). Makes no GL calls.
+inline void buildMipChain(BMPImage &image) {
+  const int bpp = image.bytesPerPixel;
+  size_t total = 0;
+  for (int w = image.width, h = image.height; w > 1 || h > 1;) {
+    w = w > 1 ? w / 2 : 1;
+    h = h > 1 ? h / 2 : 1;
+    total += bmpRowBytes(w, bpp) * h;
   }
+  image.mips.assign(total, 0);
+
+  const unsigned char *src = image.pixels;
+  unsigned char *dst = image.mips.data();
+  int srcW = image.width, srcH = image.height;
+  while (srcW > 1 || srcH > 1) {
+    int dstW = srcW > 1 ? srcW / 2 : 1;
+    int dstH = srcH > 1 ? srcH / 2 : 1;
+    size_t srcRow = bmpRowBytes(srcW, bpp), dstRow = bmpRowBytes(dstW, bpp);
+    for (int y = 0; y < dstH; y++) {
+      const unsigned char *row0 = src + (size_t)(2 * y) * srcRow;
+      const unsigned char *row1 =
+          src + (size_t)(2 * y + 1 < srcH ? 2 * y + 1 : 2 * y) * srcRow;
+      unsigned char *out = dst + (size_t)y * dstRow;
+      for (int x = 0; x < dstW; x++) {
+        size_t x0 = (size_t)(2 * x) * bpp;
+        size_t x1 = (size_t)(2 * x + 1 < srcW ? 2 * x + 1 : 2 * x) * bpp;
+        for (int c = 0; c < bpp; c++)
+          out[x * bpp + c] = (unsigned char)((row0[x0 + c] + row0[x1 + c] +
+                                              row1[x0 + c] + row1[x1 + c] +
+                                              2) /
+                                             4);
+      }
+    }
+    src = dst;
+    dst += dstRow * dstH;
+    srcW = dstW;
+    srcH = dstH;
+  }
+}
+
+// Maps a BMP from the asset pack or disk and validates it, without copying
+// the pixels. Makes no GL calls, so it is safe on worker threads.
+inline bool openBMP(const char *filename, BMPImage &image) {
+  AssetView view;
+  if (AssetPack::shared().get(filename, view, image.storage))
+    return parseBMP(view.data, view.size, filename, image);
 
-  unsigned int dataPos = *(int *)&(header[0x0A]);
-  unsigned int imageSize = *(int *)&(header[0x22]);
-  unsigned int width = *(int *)&(header[0x12]);
-  unsigned int height = *(int *)&(header[0x16]);
+  size_t size;
+  image.mapping = mapFile(filename, size);
+  if (!image.mapping) {
+    printf("Image could not be opened: %s\n", filename);
+    return false;
+  }
+  return parseBMP(image.mapping.get(), size, filename, image);
+}
 
-  if (imageSize == 0)
-    imageSize = width * height * 3;
-  if (dataPos == 0)
-    dataPos = 54;
+// openBMP() plus the mip chain
+inline bool readBMP(const char *filename, BMPImage &image) {
+  if (!openBMP(filename, image))
+    return false;
+  buildMipChain(image);
+  return true;
+}
 
-  unsigned char *data = new unsigned char[imageSize];
-  fread(data, 1, imageSize, file);
-  fclose(file);
+#ifndef GL_BGRA
+#define GL_BGRA 0x80E1
+#endif
 
+// Creates the GL texture for a decoded BMP with its full mip chain and
+// trilinear filtering (GL thread only). Level 0 is read straight from the
+// mapping; rows are 4-byte aligned, which GL_UNPACK_ALIGNMENT is set to.
+inline Texture uploadBMP(const BMPImage &image, const char *filename) {
+  Texture tex;
   glGenTextures(1, &tex.id);
   glBindTexture(GL_TEXTURE_2D, tex.id);
 
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_BGR,
-               GL_UNSIGNED_BYTE, data);
+  GLint previousAlignment;
+  glGetIntegerv(GL_UNPACK_ALIGNMENT, &previousAlignment);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+  const int bpp = image.bytesPerPixel;
+  GLenum format = bpp == 4 ? GL_BGRA : GL_BGR;
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image.width, image.height, 0, format,
+               GL_UNSIGNED_BYTE, image.pixels);
+  tex.bytes = image.stride * image.height;
+
+  const unsigned char *mip = image.mips.data();
+  int level = 0;
+  for (int w = image.width, h = image.height;
+       !image.mips.empty() && (w > 1 || h > 1);) {
+    w = w > 1 ? w / 2 : 1;
+    h = h > 1 ? h / 2 : 1;
+    glTexImage2D(GL_TEXTURE_2D, ++level, GL_RGB, w, h, 0, format,
+                 GL_UNSIGNED_BYTE, mip);
+    mip += bmpRowBytes(w, bpp) * h;
+    tex.bytes += bmpRowBytes(w, bpp) * h;
+  }
+  glPixelStorei(GL_UNPACK_ALIGNMENT, previousAlignment);
 
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                  level > 0 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-  tex.width = width;
-  tex.height = height;
+  tex.width = image.width;
+  tex.height = image.height;
 
-  delete[] data;
-  printf("Loaded texture: %s\n", filename);
+  printf("Loaded texture: %s (%d mip levels, %zu bytes)\n", filename,
+         level + 1, tex.bytes);
   return tex;
 }
 
+// Simple BMP loader (no registry: the caller owns the GL texture)
+inline Texture loadBMP(const char *filename) {
+  BMPImage image;
+  if (!readBMP(filename, image))
+    return Texture();
+  return uploadBMP(image, filename);
+}
+
 // ============================================================================
 // DRAWING HELPERS
 // ============================================================================
@@ -394,8 +561,10 @@ inline void playSound(SoundEffect sound) {
   }
 
   if (soundFile[0] != '\0') {
-    char command[256];
-    sprintf(command, "afplay %s &", soundFile);
+    // afplay needs a real file; packed sounds are extracted once
+    std::string path = AssetPack::shared().extractToFile(soundFile);
+    char command[512];
+    snprintf(command, sizeof(command), "afplay '%s' &", path.c_str());
     system(command);
   }
 #endif